@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "bench_report.h"
+#include "camera_path.h"
+#include "flythrough_controller.h"
+#include "renderer_setup.h"
+#include "scene_setup.h"
+#include "engine/asset_manager.h"
+#include "engine/engine.h"
+#include "engine/renderer.h"
+#include "graphics/camera.h"
+#include "graphics/framegraph.h"
+#include "utils/game_settings.h"
+#include "utils/profiler.h"
+#include "utils/trace_capture.h"
+#include "world/planet.h"
+#include "world/world.h"
+
+/*
+ * PlanetEngineBench [camera path] [--output <report.json>] [--fixed-delta <seconds>] [--warmup-frames <count>] [--trace-frames <count>...]
+ *
+ * Play a camera path at a fixed time step in a hidden window, without vsync, and write per segment CPU / GPU times and profiler counters.
+ * Runs with software rendering too (LIBGL_ALWAYS_SOFTWARE=1 for llvmpipe).
+ */
+
+// The GpuProfiler drops the frames it couldn't resolve after a few frames
+static constexpr uint32_t max_gpu_wait_frames = 10;
+
+int main(int argc, char** argv) {
+    std::filesystem::path camera_path_file = "resources/bench/flythrough.txt";
+    std::filesystem::path output           = "bench_report.json";
+    double                fixed_delta      = 1.0 / 60.0;
+    uint32_t              warmup_frames    = 120;
+    for (int i = 1; i < argc; ++i) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--output") == 0 && has_value)
+            output = argv[++i];
+        else if (std::strcmp(argv[i], "--fixed-delta") == 0 && has_value)
+            fixed_delta = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--warmup-frames") == 0 && has_value)
+            warmup_frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        else if (std::strncmp(argv[i], "--trace-", 8) == 0 && has_value)
+            ++i; // Handled by TraceCapture
+        else if (argv[i][0] != '-')
+            camera_path_file = argv[i];
+        else {
+            std::cerr << "Unknown argument " << argv[i] << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    if (fixed_delta <= 0) {
+        std::cerr << "Invalid fixed delta " << fixed_delta << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    auto camera_path = CameraPath::load(camera_path_file);
+    if (!camera_path)
+        return EXIT_FAILURE;
+
+    // Must be set before the renderer is created
+    GameSettings::get().headless            = true;
+    GameSettings::get().v_sync              = false;
+    GameSettings::get().fixed_delta_seconds = fixed_delta;
+    Profiler::set_enabled(true);
+
+    const auto main_camera = std::make_shared<Camera>();
+    const auto framegraph  = setup_renderer(main_camera);
+    const auto earth       = setup_scene(main_camera);
+
+    const auto controller = std::make_shared<FlythroughController>(*camera_path);
+    controller->add_child(main_camera);
+    earth->add_child(controller);
+
+    Engine::get().get_asset_manager().compile_programs();
+
+    // Several GPU frames can be resolved during the same frame : receive each of them
+    BenchReport report(*camera_path);
+    Profiler::get().on_gpu_frame_resolved.add_object(&report, &BenchReport::add_gpu_frame);
+    const auto  trace_settings  = TraceCapture::settings_from_command_line(argc, argv);
+    uint32_t    frame           = 0;
+    uint32_t    gpu_wait_frames = 0;
+    while (!Engine::get().get_renderer().should_close()) {
+        // Shaders compile and the first LODs are generated during the warm-up
+        if (frame == warmup_frames) {
+            controller->start();
+            if (trace_settings)
+                TraceCapture::get().start(*trace_settings);
+        }
+        const bool recording = frame >= warmup_frames && !controller->is_finished();
+        if (frame >= warmup_frames && controller->is_finished() && (report.gpu_complete() || ++gpu_wait_frames > max_gpu_wait_frames))
+            break;
+
+        const TimeType frame_start = std::chrono::steady_clock::now();
+        Engine::get().get_asset_manager().refresh_dirty_assets();
+        {
+            STAT_FRAME("Game_loop");
+            Engine::get().get_renderer().initialize();
+            Engine::get().get_world().tick_world();
+            framegraph->render(true, Engine::get().get_renderer().window_width(), Engine::get().get_renderer().window_height());
+            Engine::get().get_renderer().submit();
+        }
+        const double cpu_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_start).count();
+        Profiler::get().new_frame();
+
+        // Attribute the frame to the segment it was rendered on (the controller jumps to the next segment during the tick)
+        if (recording) {
+            const size_t segment = std::min(controller->current_segment(), camera_path->get_segments().size() - 1);
+            report.add_frame(segment, frame_start, cpu_seconds, Profiler::get().get_last_frame_counters());
+        }
+        frame++;
+    }
+    Profiler::get().on_gpu_frame_resolved.clear_object(&report);
+
+    const BenchReport::RunInfo info{
+        .camera_path         = camera_path_file,
+        .fixed_delta_seconds = fixed_delta,
+        .width               = Engine::get().get_renderer().window_width(),
+        .height              = Engine::get().get_renderer().window_height(),
+    };
+    if (!report.write(output, info))
+        return EXIT_FAILURE;
+    std::cout << "Benchmark report written to " << output.string() << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,104 @@
+#include "bench_report.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+#include "utils/json.h"
+
+BenchReport::BenchReport(const CameraPath& path) {
+    for (const auto& segment : path.get_segments())
+        segments.emplace_back().name = segment.name;
+    total.name = "total";
+}
+
+void BenchReport::add_counters(SegmentStats& stats, const std::vector<Counter>& counters) {
+    for (const auto& counter : counters) {
+        const auto it = std::ranges::find_if(stats.counters, [&](const Counter& item) { return item.same_name(counter.name); });
+        if (it == stats.counters.end())
+            stats.counters.emplace_back(counter);
+        else
+            it->value += counter.value;
+    }
+}
+
+void BenchReport::add_frame(size_t segment, TimeType frame_start, double cpu_seconds, const std::vector<Counter>& counters) {
+    const uint64_t microseconds = static_cast<uint64_t>(cpu_seconds * 1000000.0);
+    for (auto* stats : {&segments[segment], &total}) {
+        if (stats->frames == 0)
+            stats->begin = frame_start;
+        stats->frames++;
+        stats->cpu_total += cpu_seconds;
+        stats->cpu.add(microseconds);
+        add_counters(*stats, counters);
+    }
+    last_frame_start = frame_start;
+}
+
+void BenchReport::add_gpu_frame(const std::vector<Record>& frame) {
+    // Frames submitted during the warm-up are ignored
+    if (frame.empty() || total.frames == 0 || frame.front().start < total.begin)
+        return;
+    last_gpu_frame = frame.front().start;
+
+    TimeType begin = frame.front().start;
+    TimeType end   = frame.front().end;
+    for (const auto& record : frame) {
+        begin = std::min(begin, record.start);
+        end   = std::max(end, record.end);
+    }
+    const double seconds = std::chrono::duration<double>(end - begin).count();
+
+    // Last segment started before the frame
+    SegmentStats* owner = &segments.front();
+    for (auto& segment : segments)
+        if (segment.frames > 0 && segment.begin <= frame.front().start)
+            owner = &segment;
+
+    for (auto* stats : {owner, &total}) {
+        stats->gpu_frames++;
+        stats->gpu_total += seconds;
+        stats->gpu.add(static_cast<uint64_t>(seconds * 1000000.0));
+    }
+}
+
+bool BenchReport::gpu_complete() const {
+    return total.frames > 0 && last_gpu_frame >= last_frame_start;
+}
+
+static void write_times(std::ofstream& file, const DurationHistogram& histogram, double total_seconds, uint32_t frames) {
+    file << "{\"frames\":" << frames << ",\"mean\":" << (frames > 0 ? total_seconds * 1000.0 / frames : 0.0);
+    for (const auto& [name, percentile] : {std::pair{"p50", 50.0}, std::pair{"p95", 95.0}, std::pair{"p99", 99.0}, std::pair{"max", 100.0}})
+        file << ",\"" << name << "\":" << static_cast<double>(histogram.percentile(percentile)) / 1000.0;
+    file << "}";
+}
+
+bool BenchReport::write(const std::filesystem::path& output, const RunInfo& info) const {
+    std::ofstream file(output);
+    if (!file) {
+        std::cerr << "Failed to open benchmark report " << output.string() << std::endl;
+        return false;
+    }
+
+    const auto write_segment = [&](const SegmentStats& stats) {
+        file << "{\"name\":\"" << escape_json(stats.name) << "\",\"frames\":" << stats.frames << ",\"simulated_seconds\":" << stats.frames * info.fixed_delta_seconds << ",\"cpu_ms\":";
+        write_times(file, stats.cpu, stats.cpu_total, stats.frames);
+        file << ",\"gpu_ms\":";
+        write_times(file, stats.gpu, stats.gpu_total, stats.gpu_frames);
+        file << ",\"counters\":{";
+        for (size_t i = 0; i < stats.counters.size(); ++i)
+            file << (i == 0 ? "" : ",") << "\"" << escape_json(stats.counters[i].name) << "\":" << stats.counters[i].value;
+        file << "}}";
+    };
+
+    file << "{\"camera_path\":\"" << escape_json(info.camera_path.generic_string()) << "\",\"fixed_delta_seconds\":" << info.fixed_delta_seconds << ",\"resolution\":[" << info.width << ","
+        << info.height << "],\n\"total\":";
+    write_segment(total);
+    file << ",\n\"segments\":[";
+    for (size_t i = 0; i < segments.size(); ++i) {
+        file << (i == 0 ? "\n" : ",\n");
+        write_segment(segments[i]);
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "camera_path.h"
+#include "utils/frame_stats.h"
+#include "utils/profiler.h"
+
+/**
+ * \brief Per segment statistics of a benchmark run : CPU frame times, GPU frame times (from the STAT_GPU scopes) and the sum of the profiler counters
+ * (LOD rebuilds, draw commands...), written as JSON.
+ */
+class BenchReport {
+public:
+    BenchReport(const CameraPath& path);
+
+    /**
+     * \brief Record a frame played while the camera was on 'segment'. 'frame_start' is the CPU time the frame started at.
+     */
+    void add_frame(size_t segment, TimeType frame_start, double cpu_seconds, const std::vector<Counter>& counters);
+
+    /**
+     * \brief Record the GPU events of a resolved frame (see Profiler::on_gpu_frame_resolved). They are attributed to the segment that was playing when they were submitted.
+     */
+    void add_gpu_frame(const std::vector<Record>& frame);
+
+    /**
+     * \brief True once the GPU events of every recorded frame were received
+     */
+    [[nodiscard]] bool gpu_complete() const;
+
+    struct RunInfo {
+        std::filesystem::path camera_path;
+        double                fixed_delta_seconds;
+        uint32_t              width;
+        uint32_t              height;
+    };
+    bool write(const std::filesystem::path& output, const RunInfo& info) const;
+
+private:
+    struct SegmentStats {
+        std::string          name;
+        uint32_t             frames     = 0;
+        uint32_t             gpu_frames = 0;
+        double               cpu_total  = 0;
+        double               gpu_total  = 0;
+        DurationHistogram    cpu;
+        DurationHistogram    gpu;
+        std::vector<Counter> counters;
+        TimeType             begin;
+    };
+
+    static void add_counters(SegmentStats& stats, const std::vector<Counter>& counters);
+
+    std::vector<SegmentStats> segments;
+    SegmentStats              total;
+    TimeType                  last_frame_start;
+    TimeType                  last_gpu_frame;
+};
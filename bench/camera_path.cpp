@@ -0,0 +1,102 @@
+#include "camera_path.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+std::optional<CameraPath> CameraPath::load(const std::filesystem::path& file) {
+    std::ifstream input(file);
+    if (!input) {
+        std::cerr << "Failed to open camera path " << file.string() << std::endl;
+        return {};
+    }
+
+    CameraPath  path;
+    std::string line;
+    for (size_t line_number = 1; std::getline(input, line); ++line_number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream statement(line);
+        std::string        keyword;
+        if (!(statement >> keyword))
+            continue;
+
+        const auto error = [&](const std::string& message) {
+            std::cerr << file.string() << ":" << line_number << " : " << message << std::endl;
+            return std::optional<CameraPath>();
+        };
+
+        if (keyword == "segment") {
+            Segment     segment;
+            std::string look;
+            if (!(statement >> segment.name >> look))
+                return error("expected 'segment <name> <center|forward>'");
+            if (look == "center")
+                segment.look = LookMode::Center;
+            else if (look == "forward")
+                segment.look = LookMode::Forward;
+            else
+                return error("unknown look mode '" + look + "'");
+            path.segments.emplace_back(std::move(segment));
+        } else if (keyword == "key") {
+            if (path.segments.empty())
+                return error("key declared before the first segment");
+            Key key;
+            if (!(statement >> key.time >> key.direction.x() >> key.direction.y() >> key.direction.z() >> key.altitude))
+                return error("expected 'key <time> <x> <y> <z> <altitude>'");
+            if (key.direction.squaredNorm() == 0)
+                return error("null direction");
+            auto& keys = path.segments.back().keys;
+            if (!keys.empty() && key.time <= keys.back().time)
+                return error("key times must be increasing");
+            if (keys.empty() && key.time != 0)
+                return error("the first key of a segment must be at time 0");
+            key.direction.normalize();
+            keys.emplace_back(key);
+        } else
+            return error("unknown statement '" + keyword + "'");
+    }
+
+    for (const auto& segment : path.segments)
+        if (segment.keys.size() < 2) {
+            std::cerr << file.string() << " : segment '" << segment.name << "' needs at least 2 keys" << std::endl;
+            return {};
+        }
+    if (path.segments.empty()) {
+        std::cerr << file.string() << " : no segment" << std::endl;
+        return {};
+    }
+    return path;
+}
+
+template <typename T> static T catmull_rom(const T& p0, const T& p1, const T& p2, const T& p3, double t) {
+    const double t2 = t * t;
+    const double t3 = t2 * t;
+    return 0.5 * (2.0 * p1 + (p2 - p0) * t + (2.0 * p0 - 5.0 * p1 + 4.0 * p2 - p3) * t2 + (3.0 * p1 - p0 - 3.0 * p2 + p3) * t3);
+}
+
+CameraPath::Sample CameraPath::sample(const Segment& segment, double time) {
+    const auto& keys = segment.keys;
+    time             = std::clamp(time, 0.0, segment.duration());
+
+    // First key starting after 'time'
+    size_t next = 1;
+    while (next < keys.size() - 1 && keys[next].time < time)
+        ++next;
+    const size_t current = next - 1;
+    const double t       = (time - keys[current].time) / (keys[next].time - keys[current].time);
+
+    // The end keys are duplicated to get the tangents of the first and last intervals
+    const Key& k0 = keys[current == 0 ? 0 : current - 1];
+    const Key& k1 = keys[current];
+    const Key& k2 = keys[next];
+    const Key& k3 = keys[std::min(next + 1, keys.size() - 1)];
+
+    Eigen::Vector3d direction = catmull_rom(k0.direction, k1.direction, k2.direction, k3.direction, t);
+    if (direction.squaredNorm() < 1e-12) // Opposite keys : fall back to the closest one
+        direction = t < 0.5 ? k1.direction : k2.direction;
+    return Sample{
+        .direction = direction.normalized(),
+        .altitude  = catmull_rom(k0.altitude, k1.altitude, k2.altitude, k3.altitude, t),
+    };
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+/**
+ * \brief Camera path of the benchmark, split in named segments. Each segment is a Catmull-Rom spline through its keys, the camera jumps from the end
+ * of a segment to the start of the next one. Keys are expressed relative to the planet : a direction from its center and an altitude above sea level.
+ *
+ * File format (one statement per line, '#' starts a comment) :
+ *   segment <name> <center|forward>   center : look at the planet center, forward : look along the path
+ *   key <time> <x> <y> <z> <altitude> time in seconds from the segment start, direction (normalized when loaded), altitude in meters
+ */
+class CameraPath {
+public:
+    enum class LookMode {
+        Center,
+        Forward,
+    };
+
+    struct Key {
+        double          time;
+        Eigen::Vector3d direction;
+        double          altitude;
+    };
+
+    struct Segment {
+        std::string      name;
+        LookMode         look = LookMode::Center;
+        std::vector<Key> keys;
+
+        [[nodiscard]] double duration() const { return keys.empty() ? 0 : keys.back().time; }
+    };
+
+    struct Sample {
+        Eigen::Vector3d direction;
+        double          altitude;
+    };
+
+    /**
+     * \brief Print the errors and return nothing if the file is not valid
+     */
+    static std::optional<CameraPath> load(const std::filesystem::path& file);
+
+    [[nodiscard]] const std::vector<Segment>& get_segments() const { return segments; }
+
+    /**
+     * \brief Interpolate a segment at 'time' seconds from its start (clamped to the segment duration)
+     */
+    [[nodiscard]] static Sample sample(const Segment& segment, double time);
+
+private:
+    std::vector<Segment> segments;
+};
@@ -0,0 +1,81 @@
+#include "flythrough_controller.h"
+
+#include "graphics/camera.h"
+#include "utils/profiler.h"
+#include "world/planet.h"
+
+// Time step used to find the direction of the path in LookMode::Forward
+static constexpr double forward_look_ahead = 0.05;
+
+FlythroughController::FlythroughController(CameraPath in_path)
+    : SceneComponent("flythrough controller"),
+      path(std::move(in_path)) {
+    set_tick_group(TickGroup::PrePhysic);
+}
+
+void FlythroughController::start() {
+    playing       = true;
+    segment_index = 0;
+    segment_time  = 0;
+}
+
+void FlythroughController::tick(double delta_time) {
+    STAT_FRAME("Flythrough_update");
+
+    const auto& segments = path.get_segments();
+    if (playing && !is_finished()) {
+        segment_time += delta_time;
+        // Jump to the start of the next segment (teleport)
+        if (segment_time > segments[segment_index].duration()) {
+            segment_time = 0;
+            segment_index++;
+        }
+    }
+
+    const auto& segment  = segments[std::min(segment_index, segments.size() - 1)];
+    const double time     = is_finished() ? segment.duration() : segment_time;
+    const auto   position = path_position(segment, time);
+
+    Eigen::Vector3d forward;
+    Eigen::Vector3d up_hint;
+    if (segment.look == CameraPath::LookMode::Forward) {
+        forward = path_position(segment, time + forward_look_ahead) - position;
+        if (forward.squaredNorm() < 1e-12) // End of the segment
+            forward = position - path_position(segment, time - forward_look_ahead);
+        up_hint = position.normalized();
+    } else {
+        forward = -position;
+        up_hint = Eigen::Vector3d::UnitZ();
+    }
+    forward.normalize();
+    if (std::abs(forward.dot(up_hint)) > 0.999)
+        up_hint = Eigen::Vector3d::UnitX();
+
+    // Camera axes : x forward, y right, z up
+    const Eigen::Vector3d right = up_hint.cross(forward).normalized();
+    Eigen::Matrix3d       axes;
+    axes.col(0) = forward;
+    axes.col(1) = right;
+    axes.col(2) = forward.cross(right);
+
+    get_camera()->set_local_position(position);
+    get_camera()->set_local_rotation(Eigen::Quaterniond(axes));
+}
+
+Eigen::Vector3d FlythroughController::path_position(const CameraPath::Segment& segment, double time) const {
+    const auto sample = CameraPath::sample(segment, time);
+    if (get_parent()->get_class() != Class::of<Planet>())
+        return sample.direction * sample.altitude;
+
+    // Stay above the ground, as the default camera controller does
+    const Planet* planet   = static_cast<Planet*>(get_parent());
+    const double  altitude = std::max(sample.altitude, planet->get_ground_altitude(sample.direction) + 2.0);
+    return sample.direction * (planet->get_radius() + altitude);
+}
+
+std::shared_ptr<Camera> FlythroughController::get_camera() const {
+    for (const auto& child : get_children())
+        if (child->get_class() == Class::of<Camera>())
+            return dynamic_pointer_cast<Camera>(child);
+    return nullptr;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <memory>
+
+#include "camera_path.h"
+#include "world/scene_component.h"
+
+class Camera;
+
+/**
+ * \brief Move its child camera along a CameraPath, advancing by the world delta time (GameSettings::fixed_delta_seconds makes it repeatable).
+ * Should be attached to the planet the path is relative to.
+ */
+class FlythroughController : public SceneComponent {
+public:
+    FlythroughController(CameraPath in_path);
+
+    /**
+     * \brief Start playing the path. Until then, the camera stays on the first key (warm-up)
+     */
+    void start();
+
+    void tick(double delta_time) override;
+
+    [[nodiscard]] bool              is_finished() const { return segment_index >= path.get_segments().size(); }
+    [[nodiscard]] size_t            current_segment() const { return segment_index; }
+    [[nodiscard]] const CameraPath& get_path() const { return path; }
+
+    virtual Class get_class() override { return Class(this); }
+
+private:
+    [[nodiscard]] std::shared_ptr<Camera> get_camera() const;
+    [[nodiscard]] Eigen::Vector3d         path_position(const CameraPath::Segment& segment, double time) const;
+
+    CameraPath path;
+    bool       playing       = false;
+    size_t     segment_index = 0;
+    double     segment_time  = 0;
+};
@@ -0,0 +1,38 @@
+#version 430
+
+#include "../libs/atmosphere.cginc"
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout (rgba16f, binding = 0) uniform writeonly image2DArray sky_view_luts;
+layout (binding = 1) uniform sampler2DArray transmittance_luts;
+
+// Layout must match SkyViewData in atmosphere.cpp
+layout(std430, binding = 11) readonly buffer SkyViewData {
+    vec4 viewer_position;
+    vec4 sun_direction;
+};
+
+#define SKY_VIEW_SAMPLES 32
+
+void main() {
+    // Single atmosphere pushed by Atmosphere::rebuild_sky_view_lut()
+    AtmosphereParameters atmosphere = atmospheres[0];
+    ivec2 lut_size = imageSize(sky_view_luts).xy;
+    if (any(greaterThanEqual(gl_GlobalInvocationID.xy, uvec2(lut_size))))
+        return;
+
+    vec2 uv = (vec2(gl_GlobalInvocationID.xy) + 0.5) / vec2(lut_size);
+    vec3 up = normalize(viewer_position.xyz - atmosphere.center);
+    vec3 direction = sky_view_direction(up, sun_direction.xyz, uv);
+
+    vec3 in_scattered_light = vec3(0);
+    RaySphereTraceResult hit = raySphereIntersection(atmosphere.center, atmosphere.atmosphere_radius, direction, viewer_position.xyz);
+    float distance_through_atmosphere = hit.atmosphereDistanceOut - hit.atmosphereDistanceIn;
+    if (distance_through_atmosphere > 0.0) {
+        vec3 ray_start = viewer_position.xyz + direction * (hit.atmosphereDistanceIn - atmosphere.epsilon);
+        in_scattered_light = atmosphere_scattering(transmittance_luts, atmosphere, ray_start, direction, distance_through_atmosphere - atmosphere.epsilon, sun_direction.xyz, SKY_VIEW_SAMPLES);
+    }
+
+    imageStore(sky_view_luts, ivec3(gl_GlobalInvocationID.xy, atmosphere.lut_layer), vec4(in_scattered_light, 1));
+}
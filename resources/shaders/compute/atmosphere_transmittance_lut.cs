@@ -0,0 +1,37 @@
+#version 430
+
+#include "../libs/atmosphere.cginc"
+
+layout (local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+layout (r32f, binding = 0) uniform writeonly image2DArray transmittance_luts;
+
+#define OPTICAL_DEPTH_SAMPLES 64
+
+void main() {
+    // Single atmosphere pushed by Atmosphere::rebuild_transmittance_lut()
+    AtmosphereParameters atmosphere = atmospheres[0];
+    ivec2 lut_size = imageSize(transmittance_luts).xy;
+    if (any(greaterThanEqual(gl_GlobalInvocationID.xy, uvec2(lut_size))))
+        return;
+
+    // Texel values, see transmittance_lut_uv()
+    vec2 values = vec2(gl_GlobalInvocationID.xy) / vec2(lut_size - 1);
+    float cos_zenith = values.x * 2 - 1;
+    float start_radius = atmosphere.planet_radius + values.y * (atmosphere.atmosphere_radius - atmosphere.planet_radius);
+
+    // Work around the planet center : the ray starts on the Y axis
+    vec2 ray_start = vec2(0, start_radius);
+    vec2 ray_direction = vec2(sqrt(max(0, 1 - cos_zenith * cos_zenith)), cos_zenith);
+    float ray_length = -start_radius * cos_zenith + sqrt(max(0, start_radius * start_radius * (cos_zenith * cos_zenith - 1) + atmosphere.atmosphere_radius * atmosphere.atmosphere_radius));
+
+    // Rays going through the planet keep the clamped ground density, like the direct march did
+    float step_size = ray_length / OPTICAL_DEPTH_SAMPLES;
+    float optical_depth = 0;
+    for (int i = 0; i < OPTICAL_DEPTH_SAMPLES; ++i) {
+        vec2 location = ray_start + ray_direction * (float(i) + 0.5) * step_size;
+        optical_depth += atmosphere_density(atmosphere, length(location) - atmosphere.planet_radius) * step_size;
+    }
+
+    imageStore(transmittance_luts, ivec3(gl_GlobalInvocationID.xy, atmosphere.lut_layer), vec4(optical_depth));
+}
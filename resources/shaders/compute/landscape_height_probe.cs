@@ -0,0 +1,24 @@
+#version 430
+
+#include "../libs/landscape.cginc"
+
+layout (local_size_x = 64) in;
+
+layout(std430, binding = 4) buffer PROBE_DIRECTIONS
+{
+  vec4 probe_directions[];
+};
+
+layout(std430, binding = 5) buffer PROBE_HEIGHTS
+{
+  float probe_heights[];
+};
+
+// Evaluate the terrain height function for a list of directions. Used to compare the CPU implementation (src/world/landscape.cpp) with the GPU one.
+void main() {
+  uint index = gl_GlobalInvocationID.x;
+  if (index >= probe_heights.length())
+    return;
+
+  probe_heights[index] = get_height_at_location_v2(probe_directions[index].xyz);
+}
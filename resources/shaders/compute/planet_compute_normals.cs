@@ -2,12 +2,29 @@
 
 #include "../libs/compute_base.cginc"
 
-layout (local_size_x = 1, local_size_y = 1, local_size_z = 1) in;
+layout (local_size_x = CHUNK_GROUP_SIZE, local_size_y = CHUNK_GROUP_SIZE, local_size_z = 1) in;
 
-layout (rg32f, binding = 0) uniform image2D heightmap_input;
-layout (rg16f, binding = 1) uniform image2D img_output;
+layout (rg32f, binding = 0) uniform image2DArray heightmap_input;
+layout (rg16f, binding = 1) uniform image2DArray img_output;
+
+#define HEIGHT_TILE_SIZE (CHUNK_GROUP_SIZE + 2)
+
+// Heights of the texels processed by this group, with a one texel halo.
+shared float height_tile[HEIGHT_TILE_SIZE][HEIGHT_TILE_SIZE];
 
 void main() {
+    // Load the heights once per group (each texel is used by up to 3 invocations)
+    ivec2 tile_origin = ivec2(gl_WorkGroupID.xy * CHUNK_GROUP_SIZE) - 1;
+    for (uint i = gl_LocalInvocationIndex; i < HEIGHT_TILE_SIZE * HEIGHT_TILE_SIZE; i += CHUNK_GROUP_SIZE * CHUNK_GROUP_SIZE) {
+        ivec2 tile_pos = ivec2(i % HEIGHT_TILE_SIZE, i / HEIGHT_TILE_SIZE);
+        ivec2 texel = clamp(tile_origin + tile_pos, ivec2(0), ivec2(chunk_map_size() - 1));
+        height_tile[tile_pos.y][tile_pos.x] = imageLoad(heightmap_input, chunk_texel(texel)).r;
+    }
+    barrier();
+
+    if (is_outside_chunk_map(gl_GlobalInvocationID.xy))
+        return;
+
     // Don't compute on borders
       if (gl_GlobalInvocationID.x == 0 || gl_GlobalInvocationID.y == 0 || gl_GlobalInvocationID.x == Chunk_CellCount * 4 + 4 || gl_GlobalInvocationID.y == Chunk_CellCount * 4 + 4) {
           return;
@@ -15,13 +32,12 @@ void main() {
 
     ivec2 vertex_pos_2D = pixel_pos_to_vertex_2D_pos(gl_GlobalInvocationID.xy);
 
-    // Skip center
+    // The center is computed too : the finer LOD samples it for geomorphing
     if (
       abs(vertex_pos_2D.x - 1) > Chunk_CellCount * 2 + 2 ||
-      abs(vertex_pos_2D.y - 1) > Chunk_CellCount * 2 + 2 ||
-      (Chunk_CurrentLOD != 0 && abs(vertex_pos_2D.x) < Chunk_CellCount - 1 && abs(vertex_pos_2D.y) < Chunk_CellCount - 1)
+      abs(vertex_pos_2D.y - 1) > Chunk_CellCount * 2 + 2
     ) {    
-      imageStore(img_output, ivec2(gl_GlobalInvocationID.xy), normalize(vec4(0)));
+      imageStore(img_output, chunk_texel(gl_GlobalInvocationID.xy), normalize(vec4(0)));
       return;
     }
 
@@ -31,9 +47,10 @@ void main() {
     ivec2 dirx = ivec2(f0.x, -f0.y);
     ivec2 diry = ivec2(f0.y, f0.x);
 
-    float h0 = imageLoad(heightmap_input, ivec2(gl_GlobalInvocationID.xy)).r;
-    float h1 = imageLoad(heightmap_input, ivec2(gl_GlobalInvocationID.xy + dirx)).r;
-    float h2 = imageLoad(heightmap_input, ivec2(gl_GlobalInvocationID.xy + diry)).r;
+    ivec2 tile_pos = ivec2(gl_LocalInvocationID.xy) + 1;
+    float h0 = height_tile[tile_pos.y][tile_pos.x];
+    float h1 = height_tile[tile_pos.y + dirx.y][tile_pos.x + dirx.x];
+    float h2 = height_tile[tile_pos.y + diry.y][tile_pos.x + diry.x];
 
     vec3 v0 = vec3(0, h0, 0);
     vec3 v1 = vec3(Chunk_CellWidth, h1, 0);
@@ -43,5 +60,5 @@ void main() {
     vec3 bitangent = normalize(v2 - v0);
 
     vec2 tangent_bitangent = vec2(tangent.y, bitangent.y);
-    imageStore(img_output, ivec2(gl_GlobalInvocationID.xy), vec4(tangent_bitangent, 0, 1));
+    imageStore(img_output, chunk_texel(gl_GlobalInvocationID.xy), vec4(tangent_bitangent, 0, 1));
 }
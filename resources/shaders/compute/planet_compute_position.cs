@@ -1,25 +1,28 @@
 #version 430
 
+// One invocation layer per update rect
+#define CHUNK_INDEX UpdateRects[gl_GlobalInvocationID.z].ChunkIndex
+
 #include "../libs/landscape.cginc"
 #include "../libs/compute_base.cginc"
 
-layout (local_size_x = 1, local_size_y = 1) in;
-layout (rg32f, binding = 0) uniform image2D img_output;
+layout (local_size_x = CHUNK_GROUP_SIZE, local_size_y = CHUNK_GROUP_SIZE) in;
+layout (rg32f, binding = 0) uniform image2DArray img_output;
 
 void main() {
+  ChunkUpdateRect rect = UpdateRects[gl_GlobalInvocationID.z];
 
-  ivec2 vertex_pos_2D = pixel_pos_to_vertex_2D_pos(gl_GlobalInvocationID.xy);
-
-  if (Chunk_CurrentLOD != 0 && abs(vertex_pos_2D.x) < Chunk_CellCount - 1 && abs(vertex_pos_2D.y) < Chunk_CellCount - 1) {
-    imageStore(img_output, ivec2(gl_GlobalInvocationID), vec4(0, 0, 0, 1));
+  // The dispatch is sized for the longest side on x : thin rects are transposed
+  ivec2 offset = rect.Size.x >= rect.Size.y ? ivec2(gl_GlobalInvocationID.xy) : ivec2(gl_GlobalInvocationID.yx);
+  if (any(greaterThanEqual(offset, rect.Size)))
     return;
-  }
-  
-	vec2 vertex_2d_pos = (Chunk_LocalTransform * vec4(vertex_pos_2D.x, 0, vertex_pos_2D.y, 1)).xz;
+
+  // Heights only depend on the grid position, so they are also generated under the inner hole of the ring (keeps the toroidal maps valid when the ring moves)
+	vec2 vertex_2d_pos = vec2(rect.GridMin + offset) * Chunk_CellWidth;
 	vec3 vertex_3d_pos = grid_to_sphere(vertex_2d_pos, Chunk_PlanetRadius);
   vec3 world_normal = normalize(mat3(Chunk_PlanetModel) * (vertex_3d_pos + vec3(Chunk_PlanetRadius, 0, 0)));
 
   float h0 = get_height_at_location_v2(world_normal) * 0.2;
 
-  imageStore(img_output, ivec2(gl_GlobalInvocationID), vec4(h0, h0, 0, 1));
+  imageStore(img_output, ivec3((rect.TexelMin + offset) % chunk_map_size(), Chunk_Layer), vec4(h0, h0, 0, 1));
 }
\ No newline at end of file
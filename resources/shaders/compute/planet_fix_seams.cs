@@ -2,16 +2,19 @@
 
 #include "../libs/compute_base.cginc"
 
-layout (local_size_x = 1, local_size_y = 1) in;
+layout (local_size_x = CHUNK_GROUP_SIZE, local_size_y = CHUNK_GROUP_SIZE) in;
 
-layout (rg32f, binding = 0) uniform image2D img_input;
+layout (rg32f, binding = 0) uniform image2DArray img_input;
 
 void main() {
-    
-    float h_base = imageLoad(img_input, ivec2(gl_GlobalInvocationID.xy)).x;
+    if (is_outside_chunk_map(gl_GlobalInvocationID.xy))
+        return;
+
+    // Original height (x may contain the result of a previous fix)
+    float h_base = imageLoad(img_input, chunk_texel(gl_GlobalInvocationID.xy)).y;
   // Don't compute on borders
     if (gl_GlobalInvocationID.x == 0 || gl_GlobalInvocationID.y == 0 || gl_GlobalInvocationID.x == Chunk_CellCount * 4 + 4 || gl_GlobalInvocationID.y == Chunk_CellCount * 4 + 4) {
-        imageStore(img_input, ivec2(gl_GlobalInvocationID.xy), vec4(h_base, h_base, 0, 1));
+        imageStore(img_input, chunk_texel(gl_GlobalInvocationID.xy), vec4(h_base, h_base, 0, 1));
         return;
     }
 
@@ -44,11 +47,12 @@ void main() {
     }
     weight *= clamp((max(float(abs(vertex_pos_2D.x) - Chunk_CellCount - 1), float(abs(vertex_pos_2D.y) - Chunk_CellCount - 1)) - 1) / (Chunk_CellCount - 2), 0, 1);
 
-    float hl = imageLoad(img_input, ivec2(gl_GlobalInvocationID.xy) + ivec2(forward)).x;
-    float hr = imageLoad(img_input, ivec2(gl_GlobalInvocationID.xy) - ivec2(forward)).x;
+    // Neighbors may already have been fixed by another invocation : read their original height (y) to avoid races.
+    float hl = imageLoad(img_input, chunk_texel(ivec2(gl_GlobalInvocationID.xy) + ivec2(forward))).y;
+    float hr = imageLoad(img_input, chunk_texel(ivec2(gl_GlobalInvocationID.xy) - ivec2(forward))).y;
     float hc = h_base;
 
     float h0 = mix(hc, (hl + hr) / 2, weight);
 
-    imageStore(img_input, ivec2(gl_GlobalInvocationID.xy), vec4(h0, h_base, 0, 1));
+    imageStore(img_input, chunk_texel(gl_GlobalInvocationID.xy), vec4(h0, h_base, 0, 1));
 }
\ No newline at end of file
@@ -1,5 +1,8 @@
 #version 430 core
 #extension GL_ARB_explicit_uniform_location : enable
+#ifdef GL_ARB_bindless_texture
+#extension GL_ARB_bindless_texture : enable
+#endif
 precision highp float;
 
 #include "libs/deferred_output.cginc"
@@ -7,6 +10,7 @@ precision highp float;
 
 #include "libs/world_data.cginc"
 #include "libs/maths.cginc"
+#include "libs/landscape_layers.cginc"
 
 layout(location = 0) in vec3 g_LocalNormal;
 layout(location = 1) in vec3 position;
@@ -19,21 +23,6 @@ layout(location = 7) in vec3 g_Tangent;
 layout(location = 8) in vec3 g_BiTangent;
 layout(location = 9) in vec3 g_Normal_PS;
 
-layout(location = 9) uniform sampler2D grass_color;
-layout(location = 10) uniform sampler2D sand_color;
-layout(location = 11) uniform sampler2D rock_color;
-
-layout(location = 12) uniform sampler2D rock_normal;
-layout(location = 13) uniform sampler2D grass_normal;
-layout(location = 14) uniform sampler2D sand_normal;
-
-layout(location = 15) uniform sampler2D rock_mrao;
-layout(location = 16) uniform sampler2D grass_mrao;
-layout(location = 17) uniform sampler2D sand_mrao;
-
-layout(location = 18) uniform sampler2D water_normal;
-layout(location = 19) uniform sampler2D water_displacement;
-
 vec2 uv_from_sphere_pos(vec3 sphere_norm) {
     vec3 abs_norm = abs(sphere_norm);
     const float multiplier = 1 / PI * 2 * 1000;
@@ -89,10 +78,6 @@ struct LandData {
 	vec3 mrao;
 };
 
-vec3 load_normal(sampler2D tex, vec2 text_coords) {
-	return normalize(texture(tex, text_coords).rgb * 2 - 1);
-}
-
 LandData mix_ld(LandData a, LandData b, float value) {
 	value = clamp(value, 0, 1);
 	LandData res;
@@ -103,11 +88,12 @@ LandData mix_ld(LandData a, LandData b, float value) {
 }
 
 
-LandData make_ld_tex(sampler2D color, sampler2D normal, sampler2D mrao, vec2 tc) {
+LandData make_ld_layer(uint layer, vec2 coordinates) {
+	vec2 tc = coordinates * Layers[layer].MraoScale.w;
 	LandData res;
-	res.color = texture(color, tc).rgb;
-	res.normal = load_normal(normal, tc);
-	res.mrao = vec3(0, 1, 1);
+	res.color = layer_albedo(layer, tc);
+	res.normal = layer_normal(layer, tc);
+	res.mrao = Layers[layer].MraoScale.xyz;
 	return res;
 }
 
@@ -149,17 +135,10 @@ void main()
 
     // Earth suface
     if (planet_radius > 200000) {
-        float textures_scale = 40;
-        LandData rock = make_ld_tex(rock_color, rock_normal, rock_mrao, coordinates * textures_scale);
-        rock.mrao = make_mrao(0, 0.9, 0);
-        LandData grass = make_ld_tex(grass_color, grass_normal, grass_mrao, coordinates * textures_scale);
-        grass.mrao = make_mrao(0, 0.7, 0);
-        LandData sand = make_ld_tex(sand_color, sand_normal, sand_mrao, coordinates * textures_scale);
-        sand.mrao = make_mrao(0.2, 0.7, 0);
-
-        LandData ground = mix_ld(grass, rock, slope); // Grass rock
-        ground = mix_ld(ground, sand, (-altitude + 10) / 2); // Add beach
-        LandData result = ground;
+        // Every layer is sampled (no early out) to keep implicit derivatives valid
+        LandData result = make_ld_col(vec3(0.5));
+        for (uint layer = 0; layer < Layers.length(); ++layer)
+            result = mix_ld(result, make_ld_layer(layer, coordinates), layer_weight(layer, slope, altitude));
 
         gNormal = TBN * result.normal;
         gColor = result.color;
@@ -1,22 +1,46 @@
 #version 430 core
 #extension GL_ARB_enhanced_layouts : enable
 #extension GL_ARB_explicit_uniform_location : enable
+#extension GL_ARB_shader_draw_parameters : require
 
 #include "libs/world_data.cginc"
 #include "libs/maths.cginc"
+#include "libs/planet_grid.cginc"
 
 // Inputs
 layout(location = 0) in vec3 pos;
 
+// Per chunk parameters. Layout must match PlanetChunk::LandscapeDrawData
+struct DrawData {
+    mat4 MeshTransformWS;
+    mat4 MeshTransformCS;
+    mat4 MeshRotationPS;
+    mat4 SceneRotation;
+    vec4 MorphSettings;   // xy : geomorphing start / end distance, zw : camera position relative to the chunk center (in cells)
+    ivec2 GridOriginTexel;
+    ivec2 GridOriginWrap; // Chunk center on the grid, modulo 2 * map size
+    float Radius;
+    int CellCount;
+    int LodLayer;
+    int MorphLayer;       // Layer of the parent (coarser) LOD, -1 if geomorphing is disabled
+};
+
+// Every chunk of every planet sharing the same grid is drawn by a single glMultiDrawElementsIndirect : draw commands select their chunk with gl_DrawIDARB
+layout(std430, binding = 7) readonly buffer PLANET_DRAW_DATA
+{
+    DrawData Draws[];
+};
+
+layout(std430, binding = 8) readonly buffer PLANET_DRAW_CHUNKS
+{
+    uint DrawChunks[];
+};
+
+DrawData draw_data;
+
 // Uniforms
-layout(location = 1) uniform mat4 mesh_transform_ws;
-layout(location = 2) uniform mat4 mesh_transform_cs;
-layout(location = 3) uniform mat3 mesh_rotation_ps;
-layout(location = 4) uniform mat3 scene_rotation;
-layout(location = 5) uniform float radius;
-layout(location = 6) uniform int cell_count;
-layout(location = 7) uniform sampler2D height_map;
-layout(location = 8) uniform sampler2D normal_map;
+layout(location = 7) uniform sampler2DArray height_map;
+layout(location = 8) uniform sampler2DArray normal_map;
 layout(location = 21) uniform int ground_displacement;
 layout(location = 20) uniform vec4 debug_vector;
 
@@ -31,6 +55,7 @@ layout(location = 6) out vec3 g_Normal;
 layout(location = 7) out vec3 g_Tangent;
 layout(location = 8) out vec3 g_BiTangent;
 layout(location = 9) out vec3 g_Normal_PS;
+layout(location = 10) out float g_CellWidth;
 
 vec2 uv_from_sphere_pos(vec3 sphere_norm, vec3 world_norm, out vec3 tang, out vec3 bitang) {
 
@@ -92,8 +117,8 @@ vec2 uv_from_sphere_pos(vec3 sphere_norm, vec3 world_norm, out vec3 tang, out ve
     tang = vec3(xa, 0, zx);
     bitang = vec3(0, ya, zy);
 
-    tang = scene_rotation * tang;
-    bitang = scene_rotation * bitang;
+    tang = mat3(draw_data.SceneRotation) * tang;
+    bitang = mat3(draw_data.SceneRotation) * bitang;
 
     x = mod(x * 1000, 1);
     y = mod(y * 1000, 1);
@@ -110,19 +135,45 @@ struct LocalData {
     float absolute_altitude;
 };
 
+// Blend heights and normals toward the parent LOD when getting close to the outer border of the ring (CDLOD geomorphing)
+void apply_geomorphing(ivec2 grid_offset, inout vec2 altitudes, inout vec2 tang_bitang) {
+    if (draw_data.MorphLayer < 0)
+        return;
+
+    vec2 camera_offset = abs(vec2(grid_offset) - draw_data.MorphSettings.zw);
+    float morph = clamp((max(camera_offset.x, camera_offset.y) - draw_data.MorphSettings.x) / (draw_data.MorphSettings.y - draw_data.MorphSettings.x), 0, 1);
+    if (morph <= 0)
+        return;
+
+    // The parent grid is twice as large : odd vertices are interpolated between the two (or four) closest parent vertices
+    int map_size = draw_data.CellCount * 4 + 5;
+    ivec2 grid_pos = draw_data.GridOriginWrap + grid_offset + 2 * map_size;
+    ivec2 low = (grid_pos / 2) % map_size;
+    ivec2 high = ((grid_pos + 1) / 2) % map_size;
+
+    vec2 parent_altitudes = (texelFetch(height_map, ivec3(low.x, low.y, draw_data.MorphLayer), 0).rg + texelFetch(height_map, ivec3(high.x, low.y, draw_data.MorphLayer), 0).rg +
+                             texelFetch(height_map, ivec3(low.x, high.y, draw_data.MorphLayer), 0).rg + texelFetch(height_map, ivec3(high.x, high.y, draw_data.MorphLayer), 0).rg) * 0.25;
+    vec2 parent_tang_bitang = (texelFetch(normal_map, ivec3(low.x, low.y, draw_data.MorphLayer), 0).rg + texelFetch(normal_map, ivec3(high.x, low.y, draw_data.MorphLayer), 0).rg +
+                               texelFetch(normal_map, ivec3(low.x, high.y, draw_data.MorphLayer), 0).rg + texelFetch(normal_map, ivec3(high.x, high.y, draw_data.MorphLayer), 0).rg) * 0.25;
+
+    altitudes = mix(altitudes, parent_altitudes, morph);
+    tang_bitang = mix(tang_bitang, parent_tang_bitang, morph);
+}
+
 LocalData compute_local_space_data(int enable) {
     LocalData result;
-    ivec2 coords = ivec2(pos.xz + cell_count * 2 + 2);
+    ivec2 coords = chunk_vertex_to_texel(ivec2(pos.xz), draw_data.MeshTransformCS, draw_data.GridOriginTexel, draw_data.CellCount * 4 + 5);
+
+    result.pos2D = clamp((draw_data.MeshTransformCS * vec4(pos, 1)).xz, -draw_data.Radius * PI / 2, draw_data.Radius * PI / 2);
 
-    result.pos2D = clamp((mesh_transform_cs * vec4(pos, 1)).xz, -radius * PI / 2, radius * PI / 2);
+    // Load chunk heightmap
+    vec2 tang_bitang = texelFetch(normal_map, ivec3(coords, draw_data.LodLayer), 0).rg;
+    vec2 altitudes = texelFetch(height_map, ivec3(coords, draw_data.LodLayer), 0).rg;
+    apply_geomorphing(chunk_vertex_to_grid_offset(ivec2(pos.xz), draw_data.MeshTransformCS), altitudes, tang_bitang);
 
-    vec4 tang_bitang = texelFetch(normal_map, coords, 0);
     result.tangent = unpack_tangent_z(-tang_bitang.y);
     result.bitangent = unpack_bi_tangent_z(tang_bitang.x);
     result.normal = normalize(cross(result.tangent, result.bitangent));
-
-    // Load chunk heightmap
-    vec2 altitudes = texelFetch(height_map, coords, 0).rg;
     result.absolute_altitude = altitudes.g;
 
     if (enable != 0) {
@@ -148,12 +199,14 @@ void fix_tbn(inout vec3 tang, inout vec3 bitang, vec3 normal) {
 
 void main()
 {
+    draw_data = Draws[DrawChunks[gl_DrawIDARB]];
+
     LocalData local_space_data = compute_local_space_data(ground_displacement);             //OK
-	vec3 sphere_pos_local_offset = grid_to_sphere(local_space_data.pos2D, radius);          //OK
-    vec3 sphere_pos_local = sphere_pos_local_offset + vec3(radius, 0, 0);                   //OK
+	vec3 sphere_pos_local_offset = grid_to_sphere(local_space_data.pos2D, draw_data.Radius); //OK
+    vec3 sphere_pos_local = sphere_pos_local_offset + vec3(draw_data.Radius, 0, 0);         //OK
     vec3 local_sphere_normal = normalize(sphere_pos_local);                                 //OK
-    vec3 sphere_normal_world_space = mat3(mesh_transform_ws) * local_sphere_normal;         //OK
-    vec3 sphere_normal_planet_space = mesh_rotation_ps * local_sphere_normal;               //OK
+    vec3 sphere_normal_world_space = mat3(draw_data.MeshTransformWS) * local_sphere_normal; //OK
+    vec3 sphere_normal_planet_space = mat3(draw_data.MeshRotationPS) * local_sphere_normal; //OK
 
     /**
     /* Compute world space data
@@ -174,7 +227,7 @@ void main()
     // sphere_TBN = mat3(1);
 
     // Compute vertex position (with altitude)
-    vec4 world_position = mesh_transform_ws * vec4(sphere_pos_local_offset, 1) + vec4(sphere_TBN * vec3(0, 0, local_space_data.vertex_altitude), 0);
+    vec4 world_position = draw_data.MeshTransformWS * vec4(sphere_pos_local_offset, 1) + vec4(sphere_TBN * vec3(0, 0, local_space_data.vertex_altitude), 0);
     vec3 world_normals = sphere_TBN * local_space_data.normal;
     vec3 world_tangent = sphere_TBN * local_space_data.tangent;
     vec3 world_bi_tangent = sphere_TBN * local_space_data.bitangent;
@@ -189,13 +242,14 @@ void main()
 	g_WorldPosition = world_position.xyz;
     g_LocalNormal = local_space_data.normal;
     g_Altitude = local_space_data.absolute_altitude;
-    g_PlanetRadius = radius;
+    g_PlanetRadius = draw_data.Radius;
     g_TextureCoordinates = text_coords;
     
     g_Normal = world_normals;
     g_Tangent = world_tangent;
     g_BiTangent = world_bi_tangent;
     g_Normal_PS = sphere_normal_planet_space;
+    g_CellWidth = length(mat3(draw_data.MeshTransformCS)[0]);
     
     // Vertex position
 	gl_Position = pv_matrix * world_position; 
@@ -15,16 +15,15 @@ layout(location = 5) in vec3 g_DebugScalar[];
 layout(location = 6) in vec3 g_Normal[];
 layout(location = 7) in vec3 g_Tangent[];
 layout(location = 8) in vec3 g_BiTangent[];
+layout(location = 10) in float g_CellWidth[];
 
 out vec3 color; 
 
-layout(location = 2) uniform mat4 mesh_transform_cs;
-
 in VS_OUT {vec4 gl_Position;} gs_in[];
 
 void GenerateLine(int index)
 {
-    float MAGNITUDE = length((mat3(mesh_transform_cs) * vec3(1, 0, 0)).xyz) * 0.5;
+    float MAGNITUDE = g_CellWidth[index] * 0.5;
     color = vec3(0,0,1);
     gl_Position = gs_in[index].gl_Position;
     EmitVertex();
@@ -0,0 +1,87 @@
+#version 430
+precision highp float;
+
+#include "../libs/world_data.cginc"
+
+// Combined scene (see translucency_combine.fs)
+layout(location = 1) uniform sampler2D Translucency_depth;
+
+layout(location = 2) uniform float z_near;
+layout(location = 3) uniform vec3 sun_direction;
+layout(location = 4) uniform sampler2DArray atmosphere_transmittance_luts;
+layout(location = 5) uniform sampler2DArray atmosphere_sky_view_luts;
+
+layout(location = 0) in vec2 uv;
+
+// Light scattered by the atmospheres : added to the scene color by lighting.fs. This pass can run at a lower resolution (see GameSettings::effect_resolution)
+out vec3 oFragmentColor;
+
+// Permutation defines (see renderer_setup.cpp)
+#ifndef ATMOSPHERE_ENABLED
+#define ATMOSPHERE_ENABLED 1
+#endif
+#ifndef ATMOSPHERE_QUALITY
+#define ATMOSPHERE_QUALITY 8
+#endif
+
+// Constant sample counts let the compiler unroll the scatter loop
+const int NumScatterPoints = ATMOSPHERE_QUALITY;
+
+#include "../libs/atmosphere.cginc"
+
+vec3 getSceneWorldDirection() {
+    // compute clip space direction
+    vec4 clipSpacePosition = vec4(uv * 2.0 - 1.0, 1.0, 1.0);
+
+    // Transform local space to view space
+    vec4 viewSpacePosition = proj_matrix_inv * clipSpacePosition;
+
+    viewSpacePosition /= viewSpacePosition.w;
+
+    // Transform view space to world space
+    vec4 worldSpacePosition = view_matrix_inv * viewSpacePosition;
+    return normalize(worldSpacePosition.xyz);
+}
+
+vec3 add_atmosphere(vec3 base_color, AtmosphereParameters atmosphere, vec3 pixel_direction, vec3 view_pos, float scene_depth) {
+
+    // Early out : the ray misses the atmosphere shell
+    vec3 to_center = atmosphere.center - view_pos;
+    float closest_approach = dot(to_center, pixel_direction);
+    if (dot(to_center, to_center) - closest_approach * closest_approach > atmosphere.atmosphere_radius * atmosphere.atmosphere_radius)
+        return base_color;
+
+    RaySphereTraceResult hitInfo = raySphereIntersection(atmosphere.center, atmosphere.atmosphere_radius, pixel_direction, view_pos);
+
+    // From inside the atmosphere, the sky is read from the sky view LUT
+    if (atmosphere.has_sky_view != 0 && hitInfo.atmosphereDistanceIn <= 0.0 && scene_depth >= hitInfo.atmosphereDistanceOut) {
+        vec3 up = normalize(view_pos - atmosphere.center);
+        return base_color + texture(atmosphere_sky_view_luts, vec3(sky_view_uv(up, sun_direction, pixel_direction), atmosphere.lut_layer)).rgb;
+    }
+
+    float outMax = min(hitInfo.atmosphereDistanceOut, scene_depth);
+	float distance_to_atmosphere = hitInfo.atmosphereDistanceIn;
+    float distanceThroughAtmosphere = outMax - hitInfo.atmosphereDistanceIn;
+
+    // Early out : the shell is behind the camera or hidden by the scene
+    if (distanceThroughAtmosphere > 0.0) {
+        vec3 pointInAtmosphere = view_pos + pixel_direction * (distance_to_atmosphere - atmosphere.epsilon);
+        return base_color + atmosphere_scattering(atmosphere_transmittance_luts, atmosphere, pointInAtmosphere, pixel_direction, distanceThroughAtmosphere - atmosphere.epsilon, sun_direction, NumScatterPoints);
+	}
+
+    return base_color;
+}
+
+void main()
+{
+    oFragmentColor = vec3(0);
+
+#if ATMOSPHERE_ENABLED
+    vec3 world_direction = getSceneWorldDirection();
+    float translucent_depth = z_near / texture(Translucency_depth, uv).r;
+
+    // Only the atmospheres intersecting the view frustum are uploaded
+    for (uint i = 0; i < atmosphere_count; ++i)
+        oFragmentColor = add_atmosphere(oFragmentColor, atmospheres[i], world_direction, camera_pos, translucent_depth);
+#endif
+}
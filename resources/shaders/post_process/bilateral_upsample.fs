@@ -0,0 +1,56 @@
+#version 430
+precision highp float;
+
+/*
+ * Joint bilateral upsampling of the low resolution effects (atmosphere and reflections, see GameSettings::effect_resolution).
+ * Each pixel blends the 4 closest low resolution texels, weighted by the bilinear factor and by how close the depth they were computed at is to the depth of the pixel.
+ * This avoids bleeding the sky over the silhouettes of the terrain.
+ */
+
+layout(location = 0) in vec2 uv;
+layout(location = 0) out vec3 oAtmosphere;
+layout(location = 1) out vec4 oReflection;
+
+layout(location = 1) uniform sampler2D Scene_depth; // Full resolution
+layout(location = 2) uniform sampler2D Atmosphere_color;
+layout(location = 3) uniform ivec2 Atmosphere_color_Res;
+layout(location = 4) uniform sampler2D Reflection_color;
+layout(location = 5) uniform sampler2D Reflection_visibility;
+
+// Relative depth difference for which a texel weight is halved
+const float DEPTH_TOLERANCE = 0.02;
+
+void main() {
+    ivec2 full_res = textureSize(Scene_depth, 0);
+    ivec2 low_res = Atmosphere_color_Res;
+    ivec2 pixel = ivec2(uv * vec2(full_res));
+    // Depths are reversed z : proportional to the inverse of the distance, and 0 for the sky
+    float pixel_depth = texelFetch(Scene_depth, pixel, 0).r;
+
+    vec2 texel_pos = uv * vec2(low_res) - 0.5;
+    ivec2 base_texel = ivec2(floor(texel_pos));
+    vec2 bilinear = fract(texel_pos);
+
+    vec3 atmosphere = vec3(0);
+    vec4 reflection = vec4(0);
+    float total_weight = 0;
+    for (int i = 0; i < 4; ++i) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base_texel + offset, ivec2(0), low_res - 1);
+
+        // Depth the low resolution pass read for this texel (its depth input is sampled with nearest filtering)
+        ivec2 texel_pixel = min(ivec2((vec2(texel) + 0.5) / vec2(low_res) * vec2(full_res)), full_res - 1);
+        float texel_depth = texelFetch(Scene_depth, texel_pixel, 0).r;
+
+        float depth_difference = abs(texel_depth - pixel_depth) / max(max(texel_depth, pixel_depth), 1e-20);
+        float bilinear_weight = (offset.x == 1 ? bilinear.x : 1 - bilinear.x) * (offset.y == 1 ? bilinear.y : 1 - bilinear.y);
+        float weight = bilinear_weight / (1 + depth_difference / DEPTH_TOLERANCE) + 1e-5;
+
+        atmosphere += texelFetch(Atmosphere_color, texel, 0).rgb * weight;
+        reflection += vec4(texelFetch(Reflection_color, texel, 0).rgb, texelFetch(Reflection_visibility, texel, 0).r) * weight;
+        total_weight += weight;
+    }
+
+    oAtmosphere = atmosphere / total_weight;
+    oReflection = reflection / total_weight;
+}
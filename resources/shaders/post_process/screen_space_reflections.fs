@@ -3,7 +3,9 @@
 #include "../libs/world_data.cginc"
 #include "../libs/maths.cginc"
 
-out vec4 oFragmentColor;
+// Reflected color premultiplied by its visibility. This pass can run at a lower resolution (see GameSettings::effect_resolution)
+layout(location = 0) out vec3 oReflection;
+layout(location = 1) out float oVisibility;
 layout(location = 0) in vec2 uv;
 layout(location = 1) uniform ivec2 Input_normal_Res;
 layout(location = 2) uniform sampler2D Input_normal;
@@ -11,6 +13,12 @@ layout(location = 3) uniform sampler2D Input_mrao;
 layout(location = 4) uniform sampler2D Input_Depth;
 layout(location = 5) uniform int enabled;
 layout(location = 6) uniform float resolution;
+layout(location = 7) uniform sampler2D Input_color;
+
+// Permutation define : a constant bound for the ray march loop (selected from GameSettings::ssr_quality)
+#ifndef SSR_MAX_ITERATIONS
+#define SSR_MAX_ITERATIONS 200
+#endif
 
 vec3 getSceneWorldPosition(vec2 uvs) {
 	float linear_depth = texture(Input_Depth, uvs).r;
@@ -34,14 +42,15 @@ vec3 getSceneWorldDirection(vec2 uvs) {
 
 void main() {
 
-    if (enabled == 0) {
-        oFragmentColor = vec4(uv, 1, 1);
+    oReflection = vec3(0);
+    oVisibility = 0;
+
+    if (enabled == 0)
         return;
-    }
 
     /* PARAMS */
     float maxDistance = 1000000;
-    int max_iterations = int(500 * (resolution + 0.1));
+    const int max_iterations = SSR_MAX_ITERATIONS;
 
     /* World infos */
     vec3 world_position = getSceneWorldPosition(uv);
@@ -51,17 +60,15 @@ void main() {
 
     /* Skip pixel if not used with SSR */
     vec3 mrao = texture(Input_mrao, uv).rgb;    
-    if (length(world_position) <= 0.0 || mrao.g >= 0.2) { 
-        oFragmentColor = vec4(uv, 0, 1); return; 
-    }
+    if (length(world_position) <= 0.0 || mrao.g >= 0.2)
+        return;
 
     // Compute reflection end point from world space to screen space
     vec3 world_start = world_position;
     vec3 world_end = world_start + reflected_ray * maxDistance;
     
-    if (dot(camera_to_pixel, world_end) < 0) { 
-        oFragmentColor = vec4(uv, 0, 1); return; 
-    }
+    if (dot(camera_to_pixel, world_end) < 0)
+        return;
 
     /* compute ray start and end point in screen space */
     vec2 ray_start = uv;
@@ -96,7 +103,6 @@ void main() {
 
     visibility = clamp_01(visibility);
 
-    vec4 final_uvs = vec4(out_uv, 0, 0);
-    final_uvs.b = visibility;
-    oFragmentColor = final_uvs;
+    oReflection = texture(Input_color, out_uv).rgb * visibility;
+    oVisibility = visibility;
 }
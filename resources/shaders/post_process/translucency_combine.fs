@@ -22,9 +22,13 @@ layout(location = 8) uniform sampler2D Translucency_depth;
 layout(location = 9) uniform ivec2 Translucency_depth_Res;
 
 layout(location = 10) uniform float z_near;
-layout(location = 11) uniform int shading;
 layout(location = 12) uniform vec3 sun_direction;
 
+// Shading model, selected by permutation (see renderer_setup.cpp) : unused models are removed at compile time
+#ifndef SHADING
+#define SHADING 3
+#endif
+
 vec3 getSceneWorldDirection() {
     // compute clip space direction
     vec4 clipSpacePosition = vec4(uv * 2.0 - 1.0, 1.0, 1.0);
@@ -100,61 +104,6 @@ vec2 screen_space_refraction(vec2 uv_start, sampler2D depth_map, vec3 initial_po
     return out_uv;
 }
 
-vec2 screen_space_reflection(vec2 uv_start, sampler2D depth_map, vec3 initial_pos, vec3 initial_dir, vec3 normal, out bool valid_hit) {
-    const float maxDistance = 10000;
-    const vec2 Input_normal_Res = Translucency_depth_Res;
-    const int max_iterations = 100;
-    const float resolution = 0.3;
-
-    vec3 camera_to_pixel = initial_dir;
-    vec3 reflected_ray = reflect(camera_to_pixel, normal);
-
-    // Compute reflection end point from world space to screen space
-    vec3 world_start = initial_pos;
-    vec3 world_end = world_start + reflected_ray * maxDistance;
-
-    if (dot(camera_to_pixel, world_end) < 0) { 
-        return uv_start; 
-    }
-
-    
-    vec4 end_screen_space = pv_matrix * vec4(world_end, 1.0);
-    vec2 ray_end = (end_screen_space.xy / end_screen_space.w * 0.5 + 0.5);
-
-    float delta = max(abs(ray_end.x - uv_start.x) * Input_normal_Res.x, abs(ray_end.y - uv_start.y) * Input_normal_Res.y);
-    int sp_steps = min(max_iterations, int(delta * clamp_01(resolution)));
-
-    vec2 out_uv = uv;
-    int finished = 0;
-    float pixel_depth = 0;
-    
-    for (float i = 1; i <= sp_steps; ++i) {
-        // Compare pixel depth vs expected depth
-        vec3 expected_world_pos = mix(world_start, world_end, i / float(sp_steps));
-        vec4 screen_space_position = pv_matrix * vec4(expected_world_pos, 1);
-        out_uv = fma(screen_space_position.xy / screen_space_position.w, vec2(0.5), vec2(0.5));
-
-        float expected_depth = length(expected_world_pos);
-        pixel_depth = length(getSceneWorldPosition(out_uv, texture(Scene_depth, out_uv).r));
-
-        if (pixel_depth > 0 && pixel_depth < expected_depth) {
-            finished = 1;
-            break;
-        }
-    }
-    
-    float visibility = 
-            (finished + (pixel_depth <= 0 ? 1 : 0))
-            * (out_uv.x <= 0 || out_uv.x >= 1 ? 0 : 1)
-            * (out_uv.y <= 0 || out_uv.y >= 1 ? 0 : 1);
-    valid_hit = visibility == 0 ? false : true;
-
-    if (!valid_hit)
-        return uv;
-
-    return out_uv;
-}
-
 void main()
 {
 
@@ -168,9 +117,9 @@ void main()
     vec3 trans_mrao = texture(Translucency_mrao, uv).rgb;
 	float trans_depth = texture(Translucency_depth, uv).r;
 
-    vec3 ground_color = surface_shading(shading, scene_albedo, scene_normal, scene_mrao, sun_direction, getSceneWorldDirection());
+    vec3 ground_color = surface_shading(SHADING, scene_albedo, scene_normal, scene_mrao, sun_direction, getSceneWorldDirection());
 
-    vec3 trans_color = surface_shading(shading, trans_albedo.rgb, trans_normal, trans_mrao, sun_direction, getSceneWorldDirection());
+    vec3 trans_color = surface_shading(SHADING, trans_albedo.rgb, trans_normal, trans_mrao, sun_direction, getSceneWorldDirection());
 
 	oFragmentColor = vec4(ground_color, 1);
     oNormal = scene_normal;
@@ -185,27 +134,11 @@ void main()
         vec3 refracted_albedo = texture(Scene_color, refracted_uvs).rgb * mix(vec3(1), vec3(0.1, 0.55,1), pow(trans_albedo.a, 0.2));
         vec3 refracted_normal = normalize(texture(Scene_normal, refracted_uvs).rgb);
         vec3 refracted_mrao = texture(Scene_mrao, refracted_uvs).rgb;
-        vec3 refracted_color = surface_shading(shading, refracted_albedo, refracted_normal, refracted_mrao, sun_direction, getSceneWorldDirection());
+        vec3 refracted_color = surface_shading(SHADING, refracted_albedo, refracted_normal, refracted_mrao, sun_direction, getSceneWorldDirection());
 
         oFragmentColor = vec4(mix(refracted_color, trans_color, trans_albedo.a), 1);
         oNormal = trans_normal;
         oMrao = trans_mrao;
         oDepth = trans_depth;
     }
-
-    if (oMrao.g < 0.2) {
-        bool valid_reflections = false;
-        vec2 reflected_uvs = screen_space_reflection(uv, Scene_depth, getSceneWorldPosition(uv, oDepth), getSceneWorldDirection(), oNormal, valid_reflections);
-
-        if (!valid_reflections)
-            return;
-
-        vec3 reflected_albedo = texture(Scene_color, reflected_uvs).rgb;
-        vec3 reflected_normal = normalize(texture(Scene_normal, reflected_uvs).rgb);
-        vec3 reflected_mrao = texture(Scene_mrao, reflected_uvs).rgb;
-        
-        vec3 reflected_color = surface_shading(shading, reflected_albedo, reflected_normal, reflected_mrao, sun_direction, getSceneWorldDirection());
-        
-        oFragmentColor = vec4(mix(reflected_color, oFragmentColor.rgb, 0.5), 1);
-    }
 }
\ No newline at end of file
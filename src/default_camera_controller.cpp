@@ -134,9 +134,10 @@ void DefaultCameraController::tick(double delta_time) {
                                     input_add_y - input_sub_y) + get_camera()->world_up() * (input_add_z - input_sub_z)) * movement_speed * delta_time;
     
     if (get_parent()->get_class() == Class::of<Planet>()) {
-        Planet* planet = static_cast<Planet*>(get_parent());
-        if (camera_desired_position.norm() < get_camera()->get_local_position().normalized().norm() * (planet->get_radius() + 2.0)) {
-            camera_desired_position = camera_desired_position.normalized() * (planet->get_radius() + 2.0);
+        Planet*      planet       = static_cast<Planet*>(get_parent());
+        const double ground_level = planet->get_radius() + planet->get_ground_altitude(camera_desired_position) + 2.0;
+        if (camera_desired_position.norm() < ground_level) {
+            camera_desired_position = camera_desired_position.normalized() * ground_level;
         }
     }
 
@@ -153,7 +154,8 @@ void DefaultCameraController::teleport_to_ground() {
     if (get_parent()->get_class() == Class::of<Planet>()) {
         Planet* planet = static_cast<Planet*>(get_parent());
 
-        camera_desired_position = get_camera()->get_local_position().normalized() * (planet->get_radius() + 2);
+        const Eigen::Vector3d direction = get_camera()->get_local_position().normalized();
+        camera_desired_position         = direction * (planet->get_radius() + planet->get_ground_altitude(direction) + 2);
         movement_speed          = 100;
     }
 }
@@ -4,14 +4,28 @@
 
 #include "graphics/compute_shader.h"
 #include "graphics/material.h"
+#include "graphics/program_cache.h"
+#include "utils/file_watcher.h"
 #include "utils/profiler.h"
 
 void AssetManager::refresh_dirty_assets() const
 {
-	// Check if files have been modified for hot reload
+	// Reload the files modified since the last frame, then rebuild the programs using them
 	STAT_FRAME("Check asset updates");
+	FileWatcher::get().dispatch_events();
 	for (const auto& material : materials)
 		material->check_updates();
 	for (const auto& computes : compute_shaders)
 		computes->check_updates();
 }
+
+void AssetManager::compile_programs() const
+{
+	STAT_ACTION("Start shader compilation");
+	const auto start = std::chrono::steady_clock::now();
+	for (const auto& material : materials)
+		material->compile_async();
+	for (const auto& computes : compute_shaders)
+		computes->compile_async();
+	ProgramCache::get().track_startup(start);
+}
@@ -24,6 +24,11 @@ public:
 	[[nodiscard]] const std::vector<TextureBase*>& get_textures() const { return textures; }
 
 	void refresh_dirty_assets() const;
+
+	/**
+	 * \brief Start building every outdated shader program in the background (and report the startup compilation time once they are all ready)
+	 */
+	void compile_programs() const;
 private:
 	AssetManager() = default;
 	std::vector<Mesh*> meshes;
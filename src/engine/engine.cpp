@@ -8,6 +8,7 @@
 #include "asset_manager.h"
 #include "renderer.h"
 #include "utils/game_settings.h"
+#include "utils/trace_capture.h"
 #include "world/world.h"
 
 static std::unique_ptr<Engine> engine;
@@ -35,6 +36,17 @@ void Engine::init()
 	renderer = std::make_shared<Renderer>();
 	world = std::make_shared<World>();
 
+	glfwSetFramebufferSizeCallback(get().get_renderer().get_window(),
+	                               [](GLFWwindow* window, int width, int height)
+	                               {
+		                               get().on_window_resized.execute(window, width, height);
+	                               }
+	);
+
+	// Headless runs are not driven by the user : ignore the input events
+	if (GameSettings::get().headless)
+		return;
+
 	glfwSetKeyCallback(get().get_renderer().get_window(),
 	                   [](GLFWwindow* window, int key, int scan_code, int action, int mode)
 	                   {
@@ -46,6 +58,9 @@ void Engine::init()
 
 						   if (key == GLFW_KEY_F1 && action == GLFW_PRESS)
 							   GameSettings::get().wireframe = !GameSettings::get().wireframe;
+
+						   if (key == GLFW_KEY_F2 && action == GLFW_PRESS)
+							   TraceCapture::get().start({});
 	                   }
 	);
 
@@ -56,13 +71,6 @@ void Engine::init()
 	                         }
 	);
 
-	glfwSetFramebufferSizeCallback(get().get_renderer().get_window(),
-	                               [](GLFWwindow* window, int width, int height)
-	                               {
-		                               get().on_window_resized.execute(window, width, height);
-	                               }
-	);
-
 	glfwSetScrollCallback(get().get_renderer().get_window(),
 	                      [](GLFWwindow* window, double xoffset, double yoffset)
 	                      {
@@ -4,11 +4,13 @@
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 #include <iostream>
-#include <vao.h>
 #include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
 
 #include "engine.h"
+#include "graphics/buffer_arena.h"
+#include "graphics/gl_state.h"
+#include "graphics/gpu_profiler.h"
 #include "graphics/material.h"
 #include "utils/game_settings.h"
 #include "utils/gl_tools.h"
@@ -65,7 +67,7 @@ void Renderer::initialize() const {
         STAT_FRAME("Handle_Events");
         glfwPollEvents();
     }
-    EZCOGL::VAO::none()->bind();
+    GlState::get().bind_vertex_array(0);
 
     STAT_FRAME("Draw dock table");
     int w, h;
@@ -86,18 +88,19 @@ void Renderer::submit() const {
     {
         if (!GameSettings::get().fullscreen) // Bind back buffer to display UI
         {
-            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-            glDisable(GL_CULL_FACE);
-            glDisable(GL_DEPTH_TEST);
-            glDepthFunc(GL_LESS);
-            glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-            glFrontFace(GL_CCW);
+            GlState::get().bind_framebuffer(GL_DRAW_FRAMEBUFFER, 0);
+            GlState::get().set_enabled(GL_CULL_FACE, false);
+            GlState::get().set_enabled(GL_DEPTH_TEST, false);
+            GlState::get().set_depth_func(GL_LESS);
+            GlState::get().set_polygon_mode(GL_FILL);
+            GlState::get().set_front_face(GL_CCW);
             glClearColor(0, 0, 0, 0);
             glClearDepth(1.0);
             glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
         }
 
         STAT_FRAME("ImGui Render");
+        STAT_GPU("ImGui Render");
         {
             STAT_FRAME("ImGui pre-render");
             ImGui::Render();
@@ -105,12 +108,17 @@ void Renderer::submit() const {
         GL_CHECK_ERROR();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         while (glGetError() != GL_NO_ERROR);
+        // The ImGui backend modifies the GL state behind our back
+        GlState::get().invalidate();
         GL_CHECK_ERROR();
     }
     GL_CHECK_ERROR();
 
     STAT_FRAME("Swap_buffers");
     glfwSwapBuffers(main_window);
+    BufferArena::get().new_frame();
+    GpuProfiler::get().new_frame();
+    GlState::get().new_frame();
     GL_CHECK_ERROR();
 }
 
@@ -122,7 +130,7 @@ void Renderer::resize_framebuffer_internal(GLFWwindow*, int x, int y) {
     if (render_width == x && render_height == y || x <= 0 || y <= 0)
         return;
 
-    STAT_ACTION("Window size changed to " + std::to_string(x) + "x" + std::to_string(y));
+    STAT_ACTION("Window size changed to {}x{}", x, y);
 
     render_width  = x;
     render_height = y;
@@ -159,6 +167,8 @@ void Renderer::init_context() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minor);
 #endif
 
+    glfwWindowHint(GLFW_VISIBLE, GameSettings::get().headless ? GLFW_FALSE : GLFW_TRUE);
+
     {
         STAT_ACTION("Create main window");
         main_window = glfwCreateWindow(default_window_res.x(), default_window_res.y(), "Planet Engine", nullptr, nullptr);
@@ -169,7 +179,7 @@ void Renderer::init_context() {
     bool err = gl3wInit() != 0;
     if (err) { std::cerr << "Failed to initialize OpenGL loader!" << std::endl; }
 
-    glfwSwapInterval(1); // Enable vsync
+    glfwSwapInterval(GameSettings::get().v_sync ? 1 : 0);
     glfwSetWindowUserPointer(main_window, this);
 
     GL_CHECK_ERROR();
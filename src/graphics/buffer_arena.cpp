@@ -0,0 +1,103 @@
+#include "buffer_arena.h"
+
+#include "utils/gl_tools.h"
+
+#include <GL/gl3w.h>
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+static std::unique_ptr<BufferArena> buffer_arena_singleton = nullptr;
+
+// 4Mb is enough to hold a few frames of camera and chunk data
+static constexpr size_t default_arena_size = 4 * 1024 * 1024;
+
+BufferArena& BufferArena::get() {
+    if (!buffer_arena_singleton)
+        buffer_arena_singleton = std::unique_ptr<BufferArena>(new BufferArena(default_arena_size));
+    return *buffer_arena_singleton;
+}
+
+BufferArena::BufferArena(size_t size) {
+    GLint ubo_alignment = 0, ssbo_alignment = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ubo_alignment);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ssbo_alignment);
+    alignment   = std::max({static_cast<size_t>(ubo_alignment), static_cast<size_t>(ssbo_alignment), static_cast<size_t>(16)});
+    buffer_size = (size + alignment - 1) / alignment * alignment;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &buffer_id);
+    glNamedBufferStorage(buffer_id, static_cast<GLsizeiptr>(buffer_size), nullptr, flags);
+    mapped_data = static_cast<uint8_t*>(glMapNamedBufferRange(buffer_id, 0, static_cast<GLsizeiptr>(buffer_size), flags));
+    GL_CHECK_ERROR();
+}
+
+BufferArena::~BufferArena() {
+    for (const auto& frame : frames)
+        glDeleteSync(static_cast<GLsync>(frame.fence));
+    glUnmapNamedBuffer(buffer_id);
+    glDeleteBuffers(1, &buffer_id);
+}
+
+void BufferArena::Allocation::bind(uint32_t target, uint32_t binding) const {
+    glBindBufferRange(target, binding, buffer_id, static_cast<GLintptr>(offset), static_cast<GLsizeiptr>(size));
+}
+
+bool BufferArena::retire_frames(bool wait) {
+    bool released = false;
+    while (!frames.empty()) {
+        const auto   fence  = static_cast<GLsync>(frames.front().fence);
+        const GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, wait && !released ? 1000000000 : 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+        if (wait && !released && status == GL_CONDITION_SATISFIED)
+            stats.stall_count++;
+        glDeleteSync(fence);
+        used -= frames.front().bytes;
+        frames.pop_front();
+        released = true;
+    }
+    return released;
+}
+
+BufferArena::Allocation BufferArena::allocate(size_t size) {
+    const size_t aligned_size = (std::max(size, static_cast<size_t>(1)) + alignment - 1) / alignment * alignment;
+
+    // Skip the end of the buffer if the allocation doesn't fit in
+    const size_t padding = head + aligned_size > buffer_size ? buffer_size - head : 0;
+
+    retire_frames(false);
+    while (buffer_size - used < aligned_size + padding) {
+        if (!retire_frames(true)) {
+            std::cerr << "BufferArena : cannot allocate " << size << " bytes (" << frame_bytes << " already allocated this frame)" << std::endl;
+            return {};
+        }
+    }
+
+    used += aligned_size + padding;
+    frame_bytes += aligned_size + padding;
+    if (padding != 0)
+        head = 0;
+
+    const Allocation allocation{.buffer_id = buffer_id, .offset = head, .size = size, .data = mapped_data + head};
+    head = (head + aligned_size) % buffer_size;
+    stats.allocation_count++;
+    return allocation;
+}
+
+BufferArena::Allocation BufferArena::push_raw(const void* data_ptr, size_t data_size) {
+    const Allocation allocation = allocate(data_size);
+    if (allocation.data)
+        std::memcpy(allocation.data, data_ptr, data_size);
+    return allocation;
+}
+
+void BufferArena::new_frame() {
+    if (frame_bytes > 0)
+        frames.emplace_back(FrameFence{glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0), frame_bytes});
+
+    stats.frame_bytes = frame_bytes;
+    last_frame_stats  = stats;
+    stats             = {};
+    frame_bytes       = 0;
+}
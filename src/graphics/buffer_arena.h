@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+
+/**
+ * \brief Persistently mapped ring buffer used to upload per-frame uniform / storage data.
+ * Allocations are only valid for the current frame : the memory is reused once the GPU is done with the frame that used it (guarded by fences).
+ * This avoid creating and orphaning small GL buffers each time some data changes.
+ */
+class BufferArena {
+public:
+    ~BufferArena();
+
+    static BufferArena& get();
+
+    struct Allocation {
+        uint32_t buffer_id = 0;
+        size_t   offset    = 0;
+        size_t   size      = 0;
+        void*    data      = nullptr;
+
+        /**
+         * \brief Bind this range to an indexed target (GL_UNIFORM_BUFFER or GL_SHADER_STORAGE_BUFFER)
+         */
+        void bind(uint32_t target, uint32_t binding) const;
+    };
+
+    /**
+     * \brief Reserve size bytes for the current frame. Block only if the GPU is still using the requested range.
+     */
+    Allocation allocate(size_t size);
+
+    /**
+     * \brief Allocate and copy data
+     */
+    template <typename Struct_T>
+    Allocation push(const Struct_T& data) {
+        return push_raw(&data, sizeof(Struct_T));
+    }
+
+    Allocation push_raw(const void* data_ptr, size_t data_size);
+
+    /**
+     * \brief Mark the end of the current frame's allocations. Should be called once per frame after submitting draw calls.
+     */
+    void new_frame();
+
+    struct Stats {
+        size_t   frame_bytes      = 0; // bytes allocated during the last frame
+        uint64_t allocation_count = 0;
+        uint64_t stall_count      = 0; // allocations that had to wait for the GPU
+    };
+
+    [[nodiscard]] const Stats& get_stats() const { return last_frame_stats; }
+    [[nodiscard]] size_t       capacity() const { return buffer_size; }
+
+private:
+    BufferArena(size_t size);
+
+    struct FrameFence {
+        void*  fence;
+        size_t bytes; // Bytes to release when the fence is signaled
+    };
+
+    bool retire_frames(bool wait);
+
+    uint32_t               buffer_id   = 0;
+    uint8_t*               mapped_data = nullptr;
+    size_t                 buffer_size = 0;
+    size_t                 alignment   = 256;
+    size_t                 head        = 0; // Next free byte
+    size_t                 used        = 0; // Bytes that may still be read by the GPU (including the current frame)
+    size_t                 frame_bytes = 0; // Bytes allocated since the last new_frame()
+    std::deque<FrameFence> frames;
+    Stats                  stats;
+    Stats                  last_frame_stats;
+};
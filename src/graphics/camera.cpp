@@ -1,13 +1,12 @@
 #include "camera.h"
 
-#include "uniform_buffer.h"
+#include "buffer_arena.h"
 
 #include <imgui.h>
 #include <iostream>
+#include <GL/gl3w.h>
 #include <GLFW/glfw3.h>
 
-static std::shared_ptr<UniformBuffer> camera_ubo;
-
 struct WorldDataStructure {
     alignas(16) Eigen::Matrix4f proj_matrix;
     alignas(16) Eigen::Matrix4f view_matrix;
@@ -23,8 +22,6 @@ struct WorldDataStructure {
 Camera::Camera()
     : SceneComponent("camera"), res({800, 600}), camera_fov(45), camera_near(0.1), pitch(0), yaw(0), roll(0) {
     update_rotation();
-    if (!camera_ubo)
-        camera_ubo = UniformBuffer::create("camera UBO");
 }
 
 Eigen::Matrix4d Camera::reversed_z_projection_matrix() const {
@@ -53,6 +50,20 @@ Eigen::Matrix4d Camera::view_matrix() {
     return mat_trans.matrix();
 }
 
+Frustum Camera::get_frustum() {
+    const Eigen::Matrix4d pv_matrix = reversed_z_projection_matrix() * view_matrix();
+
+    // Gribb / Hartmann : left, right, bottom, top
+    Frustum frustum;
+    frustum.planes[0] = pv_matrix.row(3) + pv_matrix.row(0);
+    frustum.planes[1] = pv_matrix.row(3) - pv_matrix.row(0);
+    frustum.planes[2] = pv_matrix.row(3) + pv_matrix.row(1);
+    frustum.planes[3] = pv_matrix.row(3) - pv_matrix.row(1);
+    for (auto& plane : frustum.planes)
+        plane /= plane.head<3>().norm();
+    return frustum;
+}
+
 Eigen::Quaterniond Camera::get_world_rotation() {
     return SceneComponent::get_world_rotation();
     if (get_parent())
@@ -114,7 +125,7 @@ void Camera::use() {
         .camera_pos = get_world_position().cast<float>(),
         .camera_forward = world_forward().cast<float>(),
     };
-    camera_ubo->set_data(world_data);
+    BufferArena::get().push(world_data).bind(GL_UNIFORM_BUFFER, 0);
 }
 
 void Camera::update_rotation() {
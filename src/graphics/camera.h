@@ -2,6 +2,22 @@
 
 #include "world/scene_component.h"
 
+#include <array>
+
+/**
+ * \brief Side planes of a view frustum, in camera relative world space (the camera is at the origin). Normals point inward.
+ */
+struct Frustum {
+    std::array<Eigen::Vector4d, 4> planes;
+
+    [[nodiscard]] bool intersects_sphere(const Eigen::Vector3d& center, double radius) const {
+        for (const auto& plane : planes)
+            if (plane.head<3>().dot(center) + plane.w() < -radius)
+                return false;
+        return true;
+    }
+};
+
 class Camera : public SceneComponent {
 public:
     Camera();
@@ -16,6 +32,11 @@ public:
      */
     Eigen::Matrix4d view_matrix();
 
+    /**
+     * \brief Compute frustum planes from the current view and projection matrices
+     */
+    Frustum get_frustum();
+
     Eigen::Quaterniond get_world_rotation() override;
     Eigen::Vector3d get_world_position() const override;
     /**
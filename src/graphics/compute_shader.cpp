@@ -1,16 +1,20 @@
 #include "compute_shader.h"
 
-#include <shader_program.h>
+#include <algorithm>
 #include <GL/gl3w.h>
 
+#include "gl_state.h"
+#include "program_cache.h"
 #include "texture_image.h"
 #include "engine/asset_manager.h"
 #include "engine/engine.h"
 #include "utils/gl_tools.h"
+#include "utils/profiler.h"
 
 ComputeShader::~ComputeShader() {
     auto& computes = Engine::get().get_asset_manager().compute_shaders;
     computes.erase(std::find(computes.begin(), computes.end(), this));
+    GlState::get().on_program_deleted(compute_shader_id);
     glDeleteProgram(compute_shader_id);
 }
 
@@ -24,22 +28,26 @@ std::shared_ptr<ComputeShader> ComputeShader::create(const std::string& name, co
 }
 
 void ComputeShader::check_updates() {
-    if (!auto_reload)
-        return;
-    compute_source.check_update();
-    if (is_dirty)
-        reload_internal();
+    if (auto_reload && has_source_changes)
+        start_build();
+
+    // Pick up background builds as soon as the driver is done
+    if (pending_build && pending_build->is_ready())
+        finish_build();
 }
 
 void ComputeShader::bind() {
     GL_CHECK_ERROR();
     if (is_dirty)
-        reload_internal();
+        start_build();
+    // Dispatches can't be skipped : wait for the build
+    if (pending_build)
+        finish_build();
 
     if (compilation_error)
         return;
 
-    glUseProgram(compute_shader_id);
+    GlState::get().use_program(compute_shader_id);
     GL_CHECK_ERROR();
 }
 
@@ -48,7 +56,7 @@ void ComputeShader::execute(int x, int y, int z) const {
         return;
 
     GL_CHECK_ERROR();
-    glDispatchCompute(x, y, z);
+    glDispatchCompute((x + workgroup_size[0] - 1) / workgroup_size[0], (y + workgroup_size[1] - 1) / workgroup_size[1], (z + workgroup_size[2] - 1) / workgroup_size[2]);
     GL_CHECK_ERROR();
     glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
     GL_CHECK_ERROR();
@@ -67,7 +75,7 @@ void ComputeShader::bind_texture(const std::shared_ptr<TextureBase>& texture, Bi
         in_out = GL_READ_WRITE;
         break;
     }
-    glBindImageTexture(binding, texture->id(), 0, GL_FALSE, 0, in_out, static_cast<GLenum>(texture->internal_format()));
+    glBindImageTexture(binding, texture->id(), 0, texture->is_layered() ? GL_TRUE : GL_FALSE, 0, in_out, static_cast<GLenum>(texture->internal_format()));
 }
 
 ComputeShader::ComputeShader(const std::string& in_name, const std::string& compute_path)
@@ -75,75 +83,33 @@ ComputeShader::ComputeShader(const std::string& in_name, const std::string& comp
     Engine::get().get_asset_manager().compute_shaders.emplace_back(this);
 
     compute_source.set_source_path(compute_path);
-    compute_source.on_data_changed.add_object(this, &ComputeShader::mark_dirty);
+    compute_source.on_data_changed.add_object(this, &ComputeShader::on_source_changed);
     mark_dirty();
 }
 
-void ComputeShader::reload_internal() {
-    GL_CHECK_ERROR();
-    // Destroy existing handle
-    if (compute_shader_id)
-        glDeleteProgram(compute_shader_id);
-
-    compute_shader_id = glCreateProgram();
-
-    compilation_error.reset();
-    std::string fragment_error;
-    size_t      fragment_error_line;
-
-    // Load shader
-    GL_CHECK_ERROR();
-    std::unique_ptr<EZCOGL::Shader> program_compute = std::make_unique<EZCOGL::Shader>(GL_COMPUTE_SHADER);
-    GL_CHECK_ERROR();
-    // Compile shader
-    if (!program_compute->compile(compute_source.get_source_code(), name, fragment_error, fragment_error_line)) {
-        // Error occurred during compilation
-        size_t local_line;
-        compilation_error = {
-            .error = fragment_error,
-            .line = 0,
-            .file = compute_source.get_file_at_line(fragment_error_line, local_line),
-            .is_fragment = true,
-        };
-        compilation_error->line = local_line;
-        is_dirty                = false;
-        return;
-    }
+void ComputeShader::start_build() {
+    // Replaces any unfinished build
+    pending_build      = std::make_unique<ProgramBuild>(name, std::vector<ProgramStage>{{GL_COMPUTE_SHADER, &compute_source}});
+    is_dirty           = false;
+    has_source_changes = false;
+}
 
-    // Link shader
-    GL_CHECK_ERROR();
-    glAttachShader(compute_shader_id, program_compute->shaderId());
-    glLinkProgram(compute_shader_id);
-    glDetachShader(compute_shader_id, program_compute->shaderId());
+void ComputeShader::finish_build() {
+    STAT_ACTION("Compile compute shader [{}]", name);
     GL_CHECK_ERROR();
+    const uint32_t new_program = pending_build->finish(compilation_error);
+    pending_build              = nullptr;
 
-    // Check link errors
-    int info_log_length = 0;
-    glGetProgramiv(compute_shader_id, GL_INFO_LOG_LENGTH, &info_log_length);
-    if (info_log_length > 1) {
-        char* info_log      = new char[info_log_length];
-        int   chars_written = 0;
-        glGetProgramInfoLog(compute_shader_id, info_log_length, &chars_written, info_log);
-        compilation_error = {
-            .error = info_log,
-            .line = 0,
-            .file = "",
-            .is_fragment = false,
-        };
-        delete[] info_log;
+    // Destroy existing handle
+    if (compute_shader_id) {
+        GlState::get().on_program_deleted(compute_shader_id);
         glDeleteProgram(compute_shader_id);
-        compute_shader_id = 0;
-        is_dirty          = false;
-        return;
     }
-    if (compilation_error) {
-        glDeleteProgram(compute_shader_id);
-        compute_shader_id = 0;
-        glUseProgram(0);
-        GL_CHECK_ERROR();
+    compute_shader_id = new_program;
+    if (compilation_error)
         return;
-    }
-    GL_CHECK_ERROR();
+
+    glGetProgramiv(compute_shader_id, GL_COMPUTE_WORK_GROUP_SIZE, workgroup_size.data());
 
     // Make world data uniform accessible by any shader
     const int world_data_id = glGetUniformBlockIndex(compute_shader_id, "WorldData");
@@ -151,19 +117,10 @@ void ComputeShader::reload_internal() {
         glUniformBlockBinding(compute_shader_id, world_data_id, 0);
     GL_CHECK_ERROR();
 
-    // Get bindings (to avoid openGL calls later)
-    int uniform_count;
-    glGetProgramiv(compute_shader_id, GL_ACTIVE_UNIFORMS, &uniform_count);
-    for (int i = 0; i < uniform_count; ++i) {
-        GLchar uniform_name[256];
-        int    length;
-        int    type_size;
-        GLenum type_type;
-        glGetActiveUniform(compute_shader_id, static_cast<GLuint>(i), 256, &length, &type_size, &type_type,
-                           uniform_name);
-    }
-    GL_CHECK_ERROR();
-
-    is_dirty = false;
     on_reload.execute();
 }
+
+void ComputeShader::compile_async() {
+    if (is_dirty)
+        start_build();
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <array>
 #include <memory>
 #include <optional>
 #include <string>
@@ -8,6 +9,7 @@
 
 DECLARE_DELEGATE_MULTICAST(EventReloadShader);
 
+class ProgramBuild;
 class TextureBase;
 
 enum class BindingMode {
@@ -26,7 +28,8 @@ public:
     static std::shared_ptr<ComputeShader> create(const std::string& name, const std::string& compute_path);
     
     /**
-     * \brief Check if source file have been changed.
+     * \brief Start a rebuild if a source file changed (and auto_reload is enabled), and pick up finished background builds.
+     * File changes are detected by the FileWatcher : this doesn't access the disk.
      */
     void check_updates();
 
@@ -46,15 +49,26 @@ public:
     bool                                auto_reload = false;
 
     /**
-     * \brief Bind shader
+     * \brief Bind shader. Waits for the build if it is not finished yet.
      */
     void bind();
 
+    /**
+     * \brief Start building the program in the background if it is outdated (see ProgramBuild)
+     */
+    void compile_async();
+
     /**
      * \brief Run compute shader program.
+     * \param x, y, z number of invocations (ex : texels) in each dimension. The workgroup count is deduced from the shader's local size.
      */
     void execute(int x, int y, int z) const;
 
+    /**
+     * \brief local_size_x/y/z declared in the shader
+     */
+    [[nodiscard]] const std::array<int, 3>& get_workgroup_size() const { return workgroup_size; }
+
     /**
      * \brief Bind given texture to this shader
      * \param mode hove it is used
@@ -69,8 +83,14 @@ private:
     ComputeShader(const std::string& in_name, const std::string& compute_path);
     ShaderSource compute_source;
 
-    void     reload_internal();
-    void     mark_dirty() { is_dirty = true; }
-    bool     is_dirty = true;
-    uint32_t compute_shader_id;
+    void start_build();
+    void finish_build();
+    void mark_dirty() { is_dirty = true; }
+    void on_source_changed() { has_source_changes = true; }
+
+    bool                          is_dirty           = true;
+    bool                          has_source_changes = false; // Only rebuilt if auto_reload is enabled
+    std::unique_ptr<ProgramBuild> pending_build;
+    uint32_t                      compute_shader_id;
+    std::array<int, 3>            workgroup_size = {1, 1, 1};
 };
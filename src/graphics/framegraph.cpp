@@ -1,5 +1,6 @@
 #include "framegraph.h"
 
+#include "gpu_profiler.h"
 #include "render_pass.h"
 #include "utils/profiler.h"
 
@@ -13,6 +14,7 @@ void FrameGraph::render(bool to_back_buffer, uint32_t in_width, uint32_t in_heig
     resize(in_width, in_height);
 
     STAT_FRAME("Render framegraph");
+    STAT_GPU("Render framegraph");
     if (width == 0 || height == 0)
         return;
 
@@ -32,7 +34,7 @@ void FrameGraph::resize(uint32_t in_width, uint32_t in_height) {
     if (in_height == height && in_width == width || in_height == 0 || in_width == 0)
         return;
 
-    STAT_FRAME("Resize framegraph to " + std::to_string(in_width) + " x " + std::to_string(height));
+    STAT_FRAME("Resize framegraph to {} x {}", in_width, height);
     width   = in_width;
     height  = in_height;
     resized = true;
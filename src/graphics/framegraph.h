@@ -23,6 +23,11 @@ public:
      */
     void resize(uint32_t width, uint32_t height);
 
+    /**
+     * \brief Recompute the resolution of every pass on the next render (when the result of a RenderPass::on_compute_resolution() callback changed)
+     */
+    void invalidate_resolution() { resized = true; }
+
     /**
      * \brief This is the last render pass
      */
@@ -0,0 +1,170 @@
+#include "gl_state.h"
+
+
+#include <GL/gl3w.h>
+#include <memory>
+
+static std::unique_ptr<GlState> gl_state_singleton = nullptr;
+
+GlState& GlState::get() {
+    if (!gl_state_singleton)
+        gl_state_singleton = std::unique_ptr<GlState>(new GlState());
+    return *gl_state_singleton;
+}
+
+GlState::GlState() {
+    invalidate();
+}
+
+bool GlState::filter(uint32_t& current, uint32_t value) {
+    if (current == value) {
+        stats.skipped++;
+        return false;
+    }
+    current = value;
+    stats.issued++;
+    return true;
+}
+
+void GlState::use_program(uint32_t in_program) {
+    if (filter(program, in_program))
+        glUseProgram(in_program);
+}
+
+void GlState::bind_vertex_array(uint32_t vao) {
+    if (filter(vertex_array, vao))
+        glBindVertexArray(vao);
+}
+
+void GlState::bind_texture(uint32_t unit, uint32_t texture) {
+    if (unit >= texture_units.size()) {
+        stats.issued++;
+        glBindTextureUnit(unit, texture);
+        return;
+    }
+    if (filter(texture_units[unit], texture))
+        glBindTextureUnit(unit, texture);
+}
+
+void GlState::bind_framebuffer(uint32_t target, uint32_t framebuffer) {
+    switch (target) {
+    case GL_DRAW_FRAMEBUFFER:
+        if (filter(draw_framebuffer, framebuffer))
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+        break;
+    case GL_READ_FRAMEBUFFER:
+        if (filter(read_framebuffer, framebuffer))
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        break;
+    default:
+        if (draw_framebuffer == framebuffer && read_framebuffer == framebuffer) {
+            stats.skipped++;
+            break;
+        }
+        draw_framebuffer = framebuffer;
+        read_framebuffer = framebuffer;
+        stats.issued++;
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+        break;
+    }
+}
+
+void GlState::set_enabled(uint32_t capability, bool enabled) {
+    int index = -1;
+    switch (capability) {
+    case GL_CULL_FACE:
+        index = Capability_CullFace;
+        break;
+    case GL_DEPTH_TEST:
+        index = Capability_DepthTest;
+        break;
+    case GL_BLEND:
+        index = Capability_Blend;
+        break;
+    case GL_SCISSOR_TEST:
+        index = Capability_ScissorTest;
+        break;
+    default:
+        break;
+    }
+    if (index >= 0 && !filter(capabilities[index], enabled ? 1 : 0))
+        return;
+    if (index < 0)
+        stats.issued++;
+    if (enabled)
+        glEnable(capability);
+    else
+        glDisable(capability);
+}
+
+void GlState::set_depth_func(uint32_t func) {
+    if (filter(depth_func, func))
+        glDepthFunc(func);
+}
+
+void GlState::set_polygon_mode(uint32_t mode) {
+    if (filter(polygon_mode, mode))
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+}
+
+void GlState::set_front_face(uint32_t mode) {
+    if (filter(front_face, mode))
+        glFrontFace(mode);
+}
+
+void GlState::set_viewport(int32_t x, int32_t y, int32_t width, int32_t height) {
+    const std::array<int32_t, 4> value = {x, y, width, height};
+    if (viewport_known && viewport == value) {
+        stats.skipped++;
+        return;
+    }
+    viewport       = value;
+    viewport_known = true;
+    stats.issued++;
+    glViewport(x, y, width, height);
+}
+
+void GlState::invalidate() {
+    program          = unknown;
+    vertex_array     = unknown;
+    draw_framebuffer = unknown;
+    read_framebuffer = unknown;
+    depth_func       = unknown;
+    polygon_mode     = unknown;
+    front_face       = unknown;
+    viewport_known   = false;
+    capabilities.fill(unknown);
+    invalidate_textures();
+}
+
+void GlState::invalidate_textures() {
+    texture_units.fill(unknown);
+}
+
+void GlState::on_program_deleted(uint32_t in_program) {
+    if (program == in_program)
+        program = unknown;
+}
+
+void GlState::on_vertex_array_deleted(uint32_t vao) {
+    if (vertex_array == vao)
+        vertex_array = unknown;
+}
+
+void GlState::on_texture_deleted(uint32_t texture) {
+    for (auto& unit : texture_units)
+        if (unit == texture)
+            unit = unknown;
+}
+
+void GlState::on_framebuffer_deleted(uint32_t framebuffer) {
+    if (draw_framebuffer == framebuffer)
+        draw_framebuffer = unknown;
+    if (read_framebuffer == framebuffer)
+        read_framebuffer = unknown;
+}
+
+void GlState::new_frame() {
+    last_frame_stats = stats;
+    stats            = {};
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+/**
+ * \brief Shadow copy of the current OpenGL bindings and raster state : calls that wouldn't change anything are not sent to the driver.
+ * Code that modifies this state with direct GL calls (ie : ImGui backend, texture uploads) must call invalidate() or the matching invalidate_*() function afterward.
+ */
+class GlState {
+public:
+    static GlState& get();
+
+    void use_program(uint32_t program);
+    void bind_vertex_array(uint32_t vao);
+
+    /**
+     * \brief Bind a texture to a texture unit (glBindTextureUnit : the active texture unit is left unchanged)
+     */
+    void bind_texture(uint32_t unit, uint32_t texture);
+
+    /**
+     * \param target GL_FRAMEBUFFER, GL_DRAW_FRAMEBUFFER or GL_READ_FRAMEBUFFER
+     */
+    void bind_framebuffer(uint32_t target, uint32_t framebuffer);
+
+    /**
+     * \param capability GL_CULL_FACE, GL_DEPTH_TEST, GL_BLEND or GL_SCISSOR_TEST (other capabilities are not filtered)
+     */
+    void set_enabled(uint32_t capability, bool enabled);
+    void set_depth_func(uint32_t func);
+    void set_polygon_mode(uint32_t mode); // GL_FRONT_AND_BACK
+    void set_front_face(uint32_t mode);
+    void set_viewport(int32_t x, int32_t y, int32_t width, int32_t height);
+
+    /**
+     * \brief Forget the whole state : the next call of each kind will always be issued.
+     */
+    void invalidate();
+    void invalidate_textures();
+
+    /**
+     * \brief Must be called before deleting a GL object : its name may be reused by the driver for a new object.
+     */
+    void on_program_deleted(uint32_t program);
+    void on_vertex_array_deleted(uint32_t vao);
+    void on_texture_deleted(uint32_t texture);
+    void on_framebuffer_deleted(uint32_t framebuffer);
+
+    struct Stats {
+        uint64_t issued  = 0; // State changes sent to the driver
+        uint64_t skipped = 0; // Redundant state changes filtered out
+    };
+
+    /**
+     * \brief Statistics of the last complete frame
+     */
+    [[nodiscard]] const Stats& get_stats() const { return last_frame_stats; }
+
+    /**
+     * \brief Should be called once per frame
+     */
+    void new_frame();
+
+private:
+    GlState();
+
+    static constexpr uint32_t unknown = UINT32_MAX;
+
+    enum Capability { Capability_CullFace, Capability_DepthTest, Capability_Blend, Capability_ScissorTest, Capability_Count };
+
+    bool filter(uint32_t& current, uint32_t value);
+
+    uint32_t                               program          = unknown;
+    uint32_t                               vertex_array     = unknown;
+    uint32_t                               draw_framebuffer = unknown;
+    uint32_t                               read_framebuffer = unknown;
+    uint32_t                               depth_func       = unknown;
+    uint32_t                               polygon_mode     = unknown;
+    uint32_t                               front_face       = unknown;
+    std::array<uint32_t, 32>               texture_units;
+    std::array<uint32_t, Capability_Count> capabilities;
+    std::array<int32_t, 4>                 viewport;
+    bool                                   viewport_known   = false;
+    Stats                                  stats;
+    Stats                                  last_frame_stats;
+};
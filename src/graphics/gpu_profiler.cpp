@@ -0,0 +1,108 @@
+#include "gpu_profiler.h"
+
+#include "utils/gl_tools.h"
+
+#include <GL/gl3w.h>
+
+static std::unique_ptr<GpuProfiler> gpu_profiler_singleton = nullptr;
+
+// Frames the GPU is allowed to lag behind before their events are dropped
+static constexpr size_t max_pending_frames = 8;
+
+GpuProfiler& GpuProfiler::get() {
+    if (!gpu_profiler_singleton)
+        gpu_profiler_singleton = std::unique_ptr<GpuProfiler>(new GpuProfiler());
+    return *gpu_profiler_singleton;
+}
+
+GpuProfiler::~GpuProfiler() {
+    if (!all_queries.empty())
+        glDeleteQueries(static_cast<GLsizei>(all_queries.size()), all_queries.data());
+}
+
+uint32_t GpuProfiler::acquire_query() {
+    if (free_queries.empty()) {
+        // Grow by blocks : the pool stabilizes after a few frames
+        std::vector<uint32_t> new_queries(64);
+        glGenQueries(static_cast<GLsizei>(new_queries.size()), new_queries.data());
+        all_queries.insert(all_queries.end(), new_queries.begin(), new_queries.end());
+        free_queries.insert(free_queries.end(), new_queries.begin(), new_queries.end());
+    }
+    const uint32_t query = free_queries.back();
+    free_queries.pop_back();
+    return query;
+}
+
+uint64_t GpuProfiler::begin_event(const char* format, const StatArgs& args) {
+    const uint32_t query = acquire_query();
+    glQueryCounter(query, GL_TIMESTAMP);
+    current_frame.events.emplace_back(Event{format, args, query, 0, std::chrono::steady_clock::now(), std::this_thread::get_id()});
+    current_frame.last_query = query;
+    return current_frame.events.size() - 1;
+}
+
+void GpuProfiler::end_event(uint64_t event) {
+    const uint32_t query = acquire_query();
+    glQueryCounter(query, GL_TIMESTAMP);
+    current_frame.events[event].end_query = query;
+    current_frame.last_query              = query;
+}
+
+void GpuProfiler::new_frame() {
+    if (!current_frame.events.empty())
+        pending_frames.emplace_back(std::move(current_frame));
+    current_frame = {};
+
+    while (!pending_frames.empty()) {
+        // Very late frames are dropped : issuing their queries again discards the pending results
+        if (!resolve_frame(pending_frames.front()) && pending_frames.size() <= max_pending_frames)
+            break;
+        for (const auto& event : pending_frames.front().events) {
+            free_queries.emplace_back(event.begin_query);
+            if (event.end_query != 0)
+                free_queries.emplace_back(event.end_query);
+        }
+        pending_frames.pop_front();
+    }
+    GL_CHECK_ERROR();
+}
+
+bool GpuProfiler::resolve_frame(const Frame& frame) {
+    // Timestamps complete in submission order : once the last issued query is available, every query of the frame is
+    GLint available = GL_FALSE;
+    glGetQueryObjectiv(frame.last_query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available)
+        return false;
+
+    const auto& events = frame.events;
+
+    GLuint64 frame_begin = 0;
+    glGetQueryObjectui64v(events.front().begin_query, GL_QUERY_RESULT, &frame_begin);
+
+    // GPU times are relative to the first event of the frame, placed on the CPU timeline when its commands were submitted
+    std::vector<Record> records;
+    records.reserve(events.size());
+    for (const auto& event : events) {
+        // Skip the scopes that were still open at the end of the frame
+        if (event.end_query == 0)
+            continue;
+        GLuint64 begin = 0, end = 0;
+        glGetQueryObjectui64v(event.begin_query, GL_QUERY_RESULT, &begin);
+        glGetQueryObjectui64v(event.end_query, GL_QUERY_RESULT, &end);
+        const auto origin = events.front().cpu_begin;
+        records.emplace_back(Record{
+            event.format,
+            event.args,
+            origin + std::chrono::nanoseconds(begin - frame_begin),
+            origin + std::chrono::nanoseconds(end - frame_begin),
+            event.thread_id,
+        });
+    }
+    Profiler::get().set_last_gpu_frame(std::move(records));
+    return true;
+}
+
+GpuEventRecord::~GpuEventRecord() {
+    if (self_ref >= 0)
+        GpuProfiler::get().end_event(self_ref);
+}
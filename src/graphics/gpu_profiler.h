@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "utils/profiler.h"
+
+#define STAT_GPU(format, ...) GpuEventRecord CONCAT_2(gpu_event_recorder_, __LINE__)(format __VA_OPT__(,) __VA_ARGS__)
+
+/**
+ * \brief GPU side of the frame events : each scope writes a pair of GL_TIMESTAMP queries around its commands.
+ * Unlike GL_TIME_ELAPSED queries (see GpuTimer), timestamps can be nested. The queries of a frame are resolved a few frames later, once the GPU reached them,
+ * and the results are handed to the Profiler as a Record tree (see Profiler::get_last_gpu_frame()). The pipeline is never stalled.
+ */
+class GpuProfiler {
+public:
+    ~GpuProfiler();
+
+    static GpuProfiler& get();
+
+    uint64_t begin_event(const char* format, const StatArgs& args);
+    void     end_event(uint64_t event);
+
+    /**
+     * \brief Close the events of the current frame and resolve the oldest frames whose queries are available. Should be called once per frame after submitting draw calls.
+     */
+    void new_frame();
+
+private:
+    GpuProfiler() = default;
+
+    struct Event {
+        const char*     format;
+        StatArgs        args;
+        uint32_t        begin_query;
+        uint32_t        end_query;
+        TimeType        cpu_begin; // Anchor the GPU timeline on the CPU clock
+        std::thread::id thread_id;
+    };
+
+    struct Frame {
+        std::vector<Event> events;
+        uint32_t           last_query = 0; // Last query issued during the frame (the end of the outermost scope is not the last one with nested scopes)
+    };
+
+    uint32_t acquire_query();
+    bool     resolve_frame(const Frame& frame);
+
+    Frame                 current_frame;
+    std::deque<Frame>     pending_frames;
+    std::vector<uint32_t> free_queries;
+    std::vector<uint32_t> all_queries;
+};
+
+class GpuEventRecord final {
+public:
+    template <typename... Args_T>
+    GpuEventRecord(const char* format, const Args_T&... args)
+        : self_ref(-1) {
+        if (!Profiler::is_enabled())
+            return;
+        StatArgs stat_args;
+        (stat_args.push(args), ...);
+        self_ref = static_cast<int64_t>(GpuProfiler::get().begin_event(format, stat_args));
+    }
+
+    ~GpuEventRecord();
+
+private:
+    int64_t self_ref;
+};
@@ -0,0 +1,53 @@
+#include "gpu_timer.h"
+
+#include "utils/gl_tools.h"
+
+#include <GL/gl3w.h>
+#include <algorithm>
+
+GpuTimer::GpuTimer(std::string in_name, size_t ring_size) : name(std::move(in_name)) {
+    queries.resize(std::max(ring_size, static_cast<size_t>(1)));
+    glCreateQueries(GL_TIME_ELAPSED, static_cast<GLsizei>(queries.size()), queries.data());
+    GL_CHECK_ERROR();
+}
+
+GpuTimer::~GpuTimer() {
+    glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+}
+
+void GpuTimer::begin() {
+    resolve();
+    if (pending_count == queries.size())
+        return;
+    glBeginQuery(GL_TIME_ELAPSED, queries[(first_pending + pending_count) % queries.size()]);
+    running = true;
+}
+
+void GpuTimer::end() {
+    if (!running)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    running = false;
+    pending_count++;
+    GL_CHECK_ERROR();
+}
+
+void GpuTimer::resolve() {
+    // Queries complete in submission order : stop at the first one that is still running
+    while (pending_count > 0) {
+        const uint32_t query     = queries[first_pending];
+        GLint          available = GL_FALSE;
+        glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            break;
+
+        GLuint64 elapsed_ns = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed_ns);
+        last_result_ms    = static_cast<double>(elapsed_ns) / 1000000.0;
+        average_result_ms = resolved_count == 0 ? last_result_ms : average_result_ms * 0.9 + last_result_ms * 0.1;
+        resolved_count++;
+
+        first_pending = (first_pending + 1) % queries.size();
+        pending_count--;
+    }
+}
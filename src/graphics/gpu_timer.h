@@ -0,0 +1,51 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * \brief Measure the GPU execution time of a sequence of commands with GL_TIME_ELAPSED queries.
+ * Queries are stored in a small ring and resolved a few frames later without stalling the pipeline.
+ * Time elapsed queries can't be nested : only one GpuTimer can be running at a time.
+ */
+class GpuTimer {
+public:
+    ~GpuTimer();
+
+    static std::shared_ptr<GpuTimer> create(const std::string& name, size_t ring_size = 4) {
+        return std::shared_ptr<GpuTimer>(new GpuTimer(name, ring_size));
+    }
+
+    /**
+     * \brief Start measuring. Does nothing if every query of the ring is still waiting for its result.
+     */
+    void begin();
+    void end();
+
+    /**
+     * \brief Last resolved measure in milliseconds
+     */
+    [[nodiscard]] double last_ms() const { return last_result_ms; }
+
+    /**
+     * \brief Exponential moving average of the resolved measures in milliseconds
+     */
+    [[nodiscard]] double average_ms() const { return average_result_ms; }
+
+    [[nodiscard]] uint64_t sample_count() const { return resolved_count; }
+
+    const std::string name;
+
+private:
+    GpuTimer(std::string name, size_t ring_size);
+
+    void resolve();
+
+    std::vector<uint32_t> queries;
+    size_t                first_pending     = 0;
+    size_t                pending_count     = 0;
+    bool                  running           = false;
+    double                last_result_ms    = 0;
+    double                average_result_ms = 0;
+    uint64_t              resolved_count    = 0;
+};
@@ -1,10 +1,11 @@
 #include "material.h"
 
 #include <filesystem>
+#include <ranges>
 #include <GL/gl3w.h>
 
-#include <shader_program.h>
-
+#include "gl_state.h"
+#include "program_cache.h"
 #include "texture_image.h"
 #include "engine/asset_manager.h"
 #include "engine/engine.h"
@@ -22,9 +23,7 @@ int Material::binding(const std::string& binding_name) const {
 bool Material::set_texture(const std::string& bind_name, const std::shared_ptr<TextureBase>& texture) const {
     const int bp = binding(bind_name);
     if (bp > 0) {
-        glUniform1i(bp, bp);
-        GL_CHECK_ERROR();
-        texture->bind(bp);
+        upload(bp, texture);
         return true;
     }
     return false;
@@ -33,8 +32,7 @@ bool Material::set_texture(const std::string& bind_name, const std::shared_ptr<T
 bool Material::set_float(const std::string& bind_name, float value) const {
     const int bp = binding(bind_name);
     if (bp >= 0) {
-        glUniform1f(bp, value);
-        GL_CHECK_ERROR();
+        upload(bp, value);
         return true;
     }
     return false;
@@ -43,8 +41,7 @@ bool Material::set_float(const std::string& bind_name, float value) const {
 bool Material::set_int(const std::string& bind_name, int value) const {
     const int bp = binding(bind_name);
     if (bp >= 0) {
-        glUniform1i(bp, value);
-        GL_CHECK_ERROR();
+        upload(bp, value);
         return true;
     }
     return false;
@@ -53,8 +50,7 @@ bool Material::set_int(const std::string& bind_name, int value) const {
 bool Material::set_rotation(const std::string& bind_name, const Eigen::Quaterniond& value) const {
     const int bp = binding(bind_name);
     if (bp >= 0) {
-        glUniformMatrix3fv(bp, 1, false, value.cast<float>().matrix().data());
-        GL_CHECK_ERROR();
+        upload(bp, value);
         return true;
     }
     return false;
@@ -63,8 +59,7 @@ bool Material::set_rotation(const std::string& bind_name, const Eigen::Quaternio
 bool Material::set_transform(const std::string& bind_name, const Eigen::Affine3d& value) const {
     const int bp = binding(bind_name);
     if (bp >= 0) {
-        glUniformMatrix4fv(bp, 1, false, value.cast<float>().matrix().data());
-        GL_CHECK_ERROR();
+        upload(bp, value);
         return true;
     }
     return false;
@@ -73,8 +68,7 @@ bool Material::set_transform(const std::string& bind_name, const Eigen::Affine3d
 bool Material::set_vec4(const std::string& bind_name, const Eigen::Vector4f& value) const {
     const int bp = binding(bind_name);
     if (bp >= 0) {
-        glUniform4fv(bp, 1, value.data());
-        GL_CHECK_ERROR();
+        upload(bp, value);
         return true;
     }
     return false;
@@ -83,142 +77,139 @@ bool Material::set_vec4(const std::string& bind_name, const Eigen::Vector4f& val
 bool Material::set_vec3(const std::string& bind_name, const Eigen::Vector3f& value) const {
     const int bp = binding(bind_name);
     if (bp >= 0) {
-        glUniform3fv(bp, 1, value.data());
-        GL_CHECK_ERROR();
+        upload(bp, value);
+        return true;
+    }
+    return false;
+}
+
+bool Material::set_ivec2(const std::string& bind_name, const Eigen::Vector2i& value) const {
+    const int bp = binding(bind_name);
+    if (bp >= 0) {
+        upload(bp, value);
         return true;
     }
     return false;
 }
 
+void Material::upload(int location, float value) {
+    glUniform1f(location, value);
+    GL_CHECK_ERROR();
+}
+
+void Material::upload(int location, int value) {
+    glUniform1i(location, value);
+    GL_CHECK_ERROR();
+}
+
+void Material::upload(int location, const Eigen::Quaterniond& value) {
+    glUniformMatrix3fv(location, 1, false, value.cast<float>().matrix().data());
+    GL_CHECK_ERROR();
+}
+
+void Material::upload(int location, const Eigen::Affine3d& value) {
+    glUniformMatrix4fv(location, 1, false, value.cast<float>().matrix().data());
+    GL_CHECK_ERROR();
+}
+
+void Material::upload(int location, const Eigen::Vector4f& value) {
+    glUniform4fv(location, 1, value.data());
+    GL_CHECK_ERROR();
+}
+
+void Material::upload(int location, const Eigen::Vector3f& value) {
+    glUniform3fv(location, 1, value.data());
+    GL_CHECK_ERROR();
+}
+
+void Material::upload(int location, const Eigen::Vector2i& value) {
+    glUniform2iv(location, 1, value.data());
+    GL_CHECK_ERROR();
+}
+
+// Texture units match uniform locations (sampler units are assigned once after linking)
+void Material::upload(int location, const std::shared_ptr<TextureBase>& texture) {
+    texture->bind(location);
+}
+
+static bool is_sampler_type(GLenum type) {
+    switch (type) {
+    case GL_SAMPLER_1D:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_SHADOW:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_ARRAY_SHADOW:
+    case GL_SAMPLER_CUBE_SHADOW:
+    case GL_SAMPLER_CUBE_MAP_ARRAY:
+    case GL_SAMPLER_2D_MULTISAMPLE:
+    case GL_SAMPLER_BUFFER:
+    case GL_INT_SAMPLER_2D:
+    case GL_INT_SAMPLER_2D_ARRAY:
+    case GL_INT_SAMPLER_3D:
+    case GL_UNSIGNED_INT_SAMPLER_2D:
+    case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+    case GL_UNSIGNED_INT_SAMPLER_3D:
+        return true;
+    default:
+        return false;
+    }
+}
+
 Material::Material(const std::string& in_name, const std::string& vertex_path, const std::string& fragment_path, const std::optional<std::string>& geometry_path)
     : name(in_name), shader_program_id(0) {
     Engine::get().get_asset_manager().materials.emplace_back(this);
 
     vertex_source.set_source_path(vertex_path);
-    vertex_source.on_data_changed.add_object(this, &Material::mark_dirty);
+    vertex_source.on_data_changed.add_object(this, &Material::on_source_changed);
 
     if (geometry_path) {
-        geometry_source = ShaderSource();
+        geometry_source.emplace();
         geometry_source->set_source_path(*geometry_path);
-        geometry_source->on_data_changed.add_object(this, &Material::mark_dirty);
+        geometry_source->on_data_changed.add_object(this, &Material::on_source_changed);
     }
 
     fragment_source.set_source_path(fragment_path);
-    fragment_source.on_data_changed.add_object(this, &Material::mark_dirty);
+    fragment_source.on_data_changed.add_object(this, &Material::on_source_changed);
 
     mark_dirty();
 
 }
 
-void Material::reload_internal() {
-    STAT_ACTION("Compile shader [" + name + "]");
-    GL_CHECK_ERROR();
-    if (shader_program_id != 0)
-        glDeleteProgram(shader_program_id);
+void Material::start_build() {
+    std::vector<ProgramStage> stages = {{GL_VERTEX_SHADER, &vertex_source}};
+    if (geometry_source)
+        stages.push_back({GL_GEOMETRY_SHADER, &*geometry_source});
+    stages.push_back({GL_FRAGMENT_SHADER, &fragment_source});
+    // Replaces any unfinished build
+    pending_build      = std::make_unique<ProgramBuild>(permutation_key.empty() ? name : name + " [" + permutation_key + "]", std::move(stages), defines);
+    is_dirty           = false;
+    has_source_changes = false;
+}
 
+void Material::finish_build() {
+    STAT_ACTION("Compile shader [{}]", name);
     GL_CHECK_ERROR();
-    compilation_error.reset();
-    bindings.clear();
-    // Compile shader
-    shader_program_id = glCreateProgram();
-
-    const std::unique_ptr<EZCOGL::Shader> program_vertex = std::make_unique<EZCOGL::Shader>(GL_VERTEX_SHADER);
-    std::string                           vertex_error;
-    size_t                                vertex_error_line;
-    if (!program_vertex->compile(vertex_source.get_source_code(), name, vertex_error, vertex_error_line)) {
-        size_t local_line;
-        compilation_error = {
-            .error = vertex_error,
-            .line = 0,
-            .file = vertex_source.get_file_at_line(vertex_error_line, local_line),
-            .is_fragment = false,
-        };
-        compilation_error->line = local_line;
-        glDeleteProgram(shader_program_id);
-        shader_program_id = 0;
-        is_dirty          = false;
-        return;
-    }
-    GL_CHECK_ERROR();
+    const uint32_t new_program = pending_build->finish(compilation_error);
+    pending_build              = nullptr;
+    wait_for_build             = false;
 
-    std::unique_ptr<EZCOGL::Shader> program_geometry = nullptr;
-    if (geometry_source) {
-        program_geometry = std::make_unique<EZCOGL::Shader>(GL_GEOMETRY_SHADER);
-        std::string geometry_error;
-        size_t      geometry_error_line;
-        if (!program_geometry->compile(geometry_source->get_source_code(), name, geometry_error, geometry_error_line)) {
-            size_t local_line;
-            compilation_error = {
-                .error = geometry_error,
-                .line = 0,
-                .file = geometry_source->get_file_at_line(geometry_error_line, local_line),
-                .is_fragment = false,
-            };
-            compilation_error->line = local_line;
-            glDeleteProgram(shader_program_id);
-            shader_program_id = 0;
-            is_dirty          = false;
-            return;
-        }
-    }
-
-    std::string                     fragment_error;
-    size_t                          fragment_error_line;
-    std::unique_ptr<EZCOGL::Shader> program_fragment = std::make_unique<EZCOGL::Shader>(GL_FRAGMENT_SHADER);
-    if (!program_fragment->compile(fragment_source.get_source_code(), name, fragment_error, fragment_error_line)) {
-        size_t local_line;
-        compilation_error = {
-            .error = fragment_error,
-            .line = 0,
-            .file = fragment_source.get_file_at_line(fragment_error_line, local_line),
-            .is_fragment = true,
-        };
-        compilation_error->line = local_line;
-        glDeleteProgram(shader_program_id);
-        shader_program_id = 0;
-        is_dirty          = false;
+    // Keep drawing with the previous program (and its bindings) until the sources are fixed
+    if (compilation_error) {
+        if (new_program != 0)
+            glDeleteProgram(new_program);
         return;
     }
 
-    // Link shader
-    glAttachShader(shader_program_id, program_vertex->shaderId());
-    glAttachShader(shader_program_id, program_fragment->shaderId());
-    if (program_geometry)
-        glAttachShader(shader_program_id, program_geometry->shaderId());
-
-    glLinkProgram(shader_program_id);
-
-    if (program_geometry)
-        glDetachShader(shader_program_id, program_geometry->shaderId());
-    glDetachShader(shader_program_id, program_vertex->shaderId());
-    glDetachShader(shader_program_id, program_fragment->shaderId());
-
-    // Check link errors
-    GL_CHECK_ERROR();
-    int infologLength = 0;
-    glGetProgramiv(shader_program_id, GL_INFO_LOG_LENGTH, &infologLength);
-    if (infologLength > 1) {
-        char* infoLog      = new char[infologLength];
-        int   charsWritten = 0;
-        glGetProgramInfoLog(shader_program_id, infologLength, &charsWritten, infoLog);
-        compilation_error = {
-            .error = infoLog,
-            .line = 0,
-            .file = "",
-            .is_fragment = false,
-        };
-        delete[] infoLog;
+    // The previous program was used until the new one was ready
+    if (shader_program_id != 0) {
+        GlState::get().on_program_deleted(shader_program_id);
         glDeleteProgram(shader_program_id);
-        shader_program_id = 0;
-        is_dirty          = false;
-        return;
     }
-    if (compilation_error) {
-        glDeleteProgram(shader_program_id);
-        shader_program_id = 0;
-        glUseProgram(0);
-    }
-    GL_CHECK_ERROR();
+    shader_program_id = new_program;
+    bindings.clear();
+    program_version++;
 
     // Make world data uniform accessible by any shader
     const int world_data_id = glGetUniformBlockIndex(shader_program_id, "WorldData");
@@ -236,16 +227,65 @@ void Material::reload_internal() {
         GLenum type_type;
         glGetActiveUniform(shader_program_id, static_cast<GLuint>(i), 256, &length, &type_size, &type_type,
                            uniform_name);
-        bindings.insert({uniform_name, glGetUniformLocation(shader_program_id, uniform_name)});
+        const int location = glGetUniformLocation(shader_program_id, uniform_name);
+        bindings.insert({uniform_name, location});
+        if (location >= 0 && is_sampler_type(type_type))
+            glProgramUniform1i(shader_program_id, location, location);
     }
     GL_CHECK_ERROR();
+}
 
-    is_dirty = false;
+void Material::compile_async() {
+    if (is_dirty)
+        start_build();
+}
+
+void Material::set_defines(const ShaderDefines& new_defines) {
+    std::string key = shader_defines_key(new_defines);
+    if (key == permutation_key)
+        return;
+    STAT_ACTION("Select permutation [{} : {}]", name, key);
+
+    // Keep the current permutation, unless it was never built
+    const bool was_built = shader_program_id != 0;
+    if (was_built || pending_build)
+        permutations[permutation_key] = Permutation{
+            .program = shader_program_id,
+            .pending_build = std::move(pending_build),
+            .compilation_error = std::move(compilation_error),
+            .bindings = std::move(bindings),
+            .is_dirty = is_dirty,
+        };
+
+    Permutation next;
+    if (const auto cached = permutations.find(key); cached != permutations.end()) {
+        next = std::move(cached->second);
+        permutations.erase(cached);
+    }
+    shader_program_id = next.program;
+    pending_build     = std::move(next.pending_build);
+    compilation_error = std::move(next.compilation_error);
+    bindings          = std::move(next.bindings);
+    is_dirty          = next.is_dirty;
+    defines           = new_defines;
+    permutation_key   = std::move(key);
+    wait_for_build    = was_built;
+    program_version++;
+}
+
+void Material::clear_permutations() {
+    for (auto& permutation : permutations | std::views::values) {
+        GlState::get().on_program_deleted(permutation.program);
+        glDeleteProgram(permutation.program);
+    }
+    permutations.clear();
 }
 
 Material::~Material() {
     auto& materials = Engine::get().get_asset_manager().materials;
     materials.erase(std::find(materials.begin(), materials.end(), this));
+    clear_permutations();
+    GlState::get().on_program_deleted(shader_program_id);
     glDeleteProgram(shader_program_id);
 }
 
@@ -264,25 +304,27 @@ std::shared_ptr<Material> Material::create(const std::string&                nam
 bool Material::bind() {
     GL_CHECK_ERROR();
     if (is_dirty)
-        reload_internal();
+        start_build();
+    if (pending_build && (wait_for_build || pending_build->is_ready()))
+        finish_build();
 
-    if (compilation_error)
+    // Not built yet : nothing is drawn with this material until the first successful build
+    if (shader_program_id == 0)
         return false;
 
-    glUseProgram(shader_program_id);
+    GlState::get().use_program(shader_program_id);
     GL_CHECK_ERROR();
     return true;
 }
 
 void Material::check_updates() {
-    if (!auto_reload)
-        return;
-
-    vertex_source.check_update();
-    fragment_source.check_update();
-    if (geometry_source)
-        geometry_source->check_update();
+    if (auto_reload && has_source_changes) {
+        // Other permutations are outdated too : they will be rebuilt when selected
+        clear_permutations();
+        start_build();
+    }
 
-    if (is_dirty)
-        reload_internal();
+    // Pick up background builds as soon as the driver is done
+    if (pending_build && pending_build->is_ready())
+        finish_build();
 }
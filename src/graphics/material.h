@@ -1,5 +1,6 @@
 #pragma once
 
+#include <memory>
 #include <optional>
 #include <GL/gl3w.h>
 #include <unordered_map>
@@ -8,7 +9,9 @@
 #include "shader_source.h"
 
 
+class ProgramBuild;
 class TextureBase;
+template <typename Value_T> class UniformHandle;
 
 class Material final {
 public:
@@ -18,7 +21,8 @@ public:
                                             const std::optional<std::string>& geometry_path = {});
 
     /**
-     * \brief Check if source file have been changed.
+     * \brief Start a rebuild if a source file changed (and auto_reload is enabled), and pick up finished background builds.
+     * File changes are detected by the FileWatcher : this doesn't access the disk.
      */
     void check_updates();
 
@@ -46,10 +50,30 @@ public:
     [[nodiscard]] uint32_t program_id() const { return shader_program_id; }
 
     /**
-     * \brief Bind shader. Return false if shader could not be bound. (ie : compilation error)
+     * \brief Bind shader. Return false if shader could not be bound. (ie : the first build failed or is not finished)
+     * During a hot reload, the previous program stays bound until the new one is ready, or while the new sources don't compile.
      */
     bool bind();
 
+    /**
+     * \brief Start building the program in the background if it is outdated (see ProgramBuild)
+     */
+    void compile_async();
+
+    /**
+     * \brief Select the permutation compiled with the given definitions (see ShaderSource::get_source_code()).
+     * Previously used permutations stay cached. Selecting a new one after the material was built stalls the next bind() until it is compiled
+     * (or loaded from the ProgramCache), so that draws are never skipped because of a settings change.
+     */
+    void set_defines(const ShaderDefines& defines);
+
+    [[nodiscard]] const ShaderDefines& get_defines() const { return defines; }
+
+    /**
+     * \brief Key of the active permutation (see shader_defines_key())
+     */
+    [[nodiscard]] const std::string& get_permutation_key() const { return permutation_key; }
+
     /**
      * \brief Enable or disable hot reload for this material
      */
@@ -74,6 +98,7 @@ public:
     bool set_vec4(const std::string& bind_name, const Eigen::Vector4f& value) const;
     bool set_vec3(const std::string& binding, const Eigen::Vector3d& value) const { return set_vec3(binding, static_cast<Eigen::Vector3f>(value.cast<float>())); }
     bool set_vec3(const std::string& bind_name, const Eigen::Vector3f& value) const;
+    bool set_ivec2(const std::string& bind_name, const Eigen::Vector2i& value) const;
     bool set_texture(const std::string& bind_name, const std::shared_ptr<TextureBase>& texture) const;
 
     /**
@@ -81,7 +106,34 @@ public:
      */
     bool set_model_transform(const Eigen::Affine3d& transformation) { return set_transform("model", transformation); }
 
+    /**
+     * \brief Typed handle to a uniform of this material. Its location is only looked up once per compilation : prefer it to the set_*() functions for per-draw values.
+     * The handle must not outlive this material.
+     */
+    template <typename Value_T> [[nodiscard]] UniformHandle<Value_T> uniform(const std::string& bind_name) const { return UniformHandle<Value_T>(this, bind_name); }
+
+    /**
+     * \brief Incremented each time the program is recompiled or the permutation changes (uniform locations may have changed)
+     */
+    [[nodiscard]] uint64_t get_program_version() const { return program_version; }
+
+    /**
+     * \brief Active uniforms of the current program (name -> location)
+     */
+    [[nodiscard]] const std::unordered_map<std::string, int>& get_bindings() const { return bindings; }
+
 private:
+    template <typename> friend class UniformHandle;
+
+    static void upload(int location, float value);
+    static void upload(int location, int value);
+    static void upload(int location, const Eigen::Quaterniond& value);
+    static void upload(int location, const Eigen::Affine3d& value);
+    static void upload(int location, const Eigen::Vector4f& value);
+    static void upload(int location, const Eigen::Vector3f& value);
+    static void upload(int location, const Eigen::Vector2i& value);
+    static void upload(int location, const std::shared_ptr<TextureBase>& texture);
+
     Material(const std::string& name, const std::string& vertex_path, const std::string& fragment_path, const std::optional<std::string>& geometry_path = {});
 
     // GL Handle
@@ -92,9 +144,73 @@ private:
     ShaderSource                fragment_source;
     std::optional<ShaderSource> geometry_source;
 
-    void reload_internal();
+    void start_build();
+    void finish_build();
     void mark_dirty() { is_dirty = true; }
+    void on_source_changed() { has_source_changes = true; }
+
+    // State of an inactive permutation
+    struct Permutation {
+        uint32_t                             program = 0;
+        std::unique_ptr<ProgramBuild>        pending_build;
+        std::optional<CompilationErrorInfo>  compilation_error;
+        std::unordered_map<std::string, int> bindings;
+        bool                                 is_dirty = true;
+    };
+
+    void clear_permutations();
+
+    ShaderDefines                                defines;
+    std::string                                  permutation_key;
+    std::unordered_map<std::string, Permutation> permutations;
+    bool                                         wait_for_build = false;
 
     bool                                 is_dirty;
+    bool                                 has_source_changes = false; // Only rebuilt if auto_reload is enabled
+    std::unique_ptr<ProgramBuild>        pending_build;
     std::unordered_map<std::string, int> bindings;
+    uint64_t                             program_version = 0;
+};
+
+/**
+ * \brief Uniform location of a Material cached on first use (see Material::uniform()). Automatically resolved again after the material is recompiled (hot reload).
+ */
+template <typename Value_T> class UniformHandle {
+public:
+    UniformHandle() = default;
+
+    /**
+     * \brief Set the uniform value. The material must be bound.
+     * \return false if the uniform is not used by the current program
+     */
+    bool set(const Value_T& value) const {
+        const int bp = location();
+        if (bp < 0)
+            return false;
+        Material::upload(bp, value);
+        return true;
+    }
+
+    [[nodiscard]] int location() const {
+        if (!material)
+            return -1;
+        if (resolved_version != material->program_version) {
+            cached_location  = material->binding(bind_name);
+            resolved_version = material->program_version;
+        }
+        return cached_location;
+    }
+
+    [[nodiscard]] const std::string& name() const { return bind_name; }
+
+private:
+    friend class Material;
+
+    UniformHandle(const Material* in_material, std::string in_name) : material(in_material), bind_name(std::move(in_name)) {
+    }
+
+    const Material*  material = nullptr;
+    std::string      bind_name;
+    mutable int      cached_location  = -1;
+    mutable uint64_t resolved_version = 0;
 };
@@ -7,6 +7,7 @@
 
 #include "engine/asset_manager.h"
 #include "engine/engine.h"
+#include "graphics/gl_state.h"
 #include "utils/gl_tools.h"
 #include "utils/profiler.h"
 
@@ -14,6 +15,7 @@ Mesh::~Mesh()
 {
 	auto& meshes = Engine::get().get_asset_manager().meshes;
 	meshes.erase(std::find(meshes.begin(), meshes.end(), this));
+	GlState::get().on_vertex_array_deleted(vao);
 	glDeleteVertexArrays(1, &vao);
 	glDeleteBuffers(1, &ebo);
 	glDeleteBuffers(1, &vbo);
@@ -21,7 +23,7 @@ Mesh::~Mesh()
 
 void Mesh::set_positions(std::vector<Eigen::Vector3f> in_positions, int location, bool no_update)
 {
-	STAT_ACTION("Set mesh positions : [" + name + "]");
+	STAT_ACTION("Set mesh positions : [{}]", name);
 	positions = std::move(in_positions);
 	att_pos = location;
 	if (!no_update)
@@ -30,7 +32,7 @@ void Mesh::set_positions(std::vector<Eigen::Vector3f> in_positions, int location
 
 void Mesh::set_texture_coordinates(std::vector<Eigen::Vector2f> in_texture_coordinates, int location, bool no_update)
 {
-	STAT_ACTION("Set mesh texture coordinates : [" + name + "]");
+	STAT_ACTION("Set mesh texture coordinates : [{}]", name);
 	texture_coordinates = std::move(in_texture_coordinates);
 	att_text_coords = location;
 	if (!no_update)
@@ -39,7 +41,7 @@ void Mesh::set_texture_coordinates(std::vector<Eigen::Vector2f> in_texture_coord
 
 void Mesh::set_normals(std::vector<Eigen::Vector3f> in_normals, int location, bool no_update)
 {
-	STAT_ACTION("Set mesh texture normals : [" + name + "]");
+	STAT_ACTION("Set mesh texture normals : [{}]", name);
 	normals = std::move(in_normals);
 	att_norms = location;
 	if (!no_update)
@@ -48,7 +50,7 @@ void Mesh::set_normals(std::vector<Eigen::Vector3f> in_normals, int location, bo
 
 void Mesh::set_tangents(std::vector<Eigen::Vector3f> in_tangents, int location, bool no_update)
 {
-	STAT_ACTION("Set mesh texture tangents : [" + name + "]");
+	STAT_ACTION("Set mesh texture tangents : [{}]", name);
 	tangents = std::move(in_tangents);
 	att_tang = location;
 	if (!no_update)
@@ -57,7 +59,7 @@ void Mesh::set_tangents(std::vector<Eigen::Vector3f> in_tangents, int location,
 
 void Mesh::set_colors(std::vector<Eigen::Vector3f> in_colors, int location, bool no_update)
 {
-	STAT_ACTION("Set mesh texture colors : [" + name + "]");
+	STAT_ACTION("Set mesh texture colors : [{}]", name);
 	colors = std::move(in_colors);
 	att_colors = location;
 	if (!no_update)
@@ -66,7 +68,7 @@ void Mesh::set_colors(std::vector<Eigen::Vector3f> in_colors, int location, bool
 
 void Mesh::set_indices(std::vector<uint32_t> in_indices, bool no_update)
 {
-	STAT_ACTION("Set mesh texture indices : [" + name + "]");
+	STAT_ACTION("Set mesh texture indices : [{}]", name);
 	indices = std::move(in_indices);
 	if (!no_update)
 		rebuild_mesh_data();
@@ -75,11 +77,43 @@ void Mesh::set_indices(std::vector<uint32_t> in_indices, bool no_update)
 void Mesh::draw() const
 {
 	GL_CHECK_ERROR();
-	glBindVertexArray(vao);
+	GlState::get().bind_vertex_array(vao);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
 	glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(indices.size()), GL_UNSIGNED_INT, nullptr);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-	glBindVertexArray(0);
+	GL_CHECK_ERROR();
+}
+
+void Mesh::draw_ranges(const std::vector<IndexRange>& ranges) const
+{
+	if (ranges.empty())
+		return;
+
+	std::vector<GLsizei>     counts(ranges.size());
+	std::vector<const void*> offsets(ranges.size());
+	for (size_t i = 0; i < ranges.size(); ++i)
+	{
+		counts[i]  = static_cast<GLsizei>(ranges[i].index_count);
+		offsets[i] = reinterpret_cast<const void*>(static_cast<uintptr_t>(ranges[i].first_index) * sizeof(uint32_t));
+	}
+
+	GL_CHECK_ERROR();
+	GlState::get().bind_vertex_array(vao);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), static_cast<GLsizei>(ranges.size()));
+	GL_CHECK_ERROR();
+}
+
+void Mesh::draw_indirect(uint32_t indirect_buffer, size_t offset, uint32_t draw_count) const
+{
+	if (draw_count == 0)
+		return;
+
+	GL_CHECK_ERROR();
+	GlState::get().bind_vertex_array(vao);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(offset), static_cast<GLsizei>(draw_count), sizeof(DrawElementsIndirectCommand));
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
 	GL_CHECK_ERROR();
 }
 
@@ -97,9 +131,9 @@ Mesh::Mesh(const std::string& in_name, const std::string& path) : Mesh(in_name)
 
 void Mesh::rebuild_mesh_data() const
 {
-	STAT_ACTION("Submit mesh data : [" + name + "]");
+	STAT_ACTION("Submit mesh data : [{}]", name);
 	GL_CHECK_ERROR();
-	glBindVertexArray(vao);
+	GlState::get().bind_vertex_array(vao);
 
 	size_t structure_size = 0;
 	size_t vertex_count = 0;
@@ -206,6 +240,6 @@ void Mesh::rebuild_mesh_data() const
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size()) * sizeof(uint32_t), indices.data(),
 	             GL_STATIC_DRAW);
 
-	glBindVertexArray(0);
+	GlState::get().bind_vertex_array(0);
 	GL_CHECK_ERROR();
 }
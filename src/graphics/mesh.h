@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <Eigen/Dense>
 
@@ -39,6 +40,34 @@ public:
 
 	void draw() const;
 
+	struct IndexRange
+	{
+		uint32_t first_index;
+		uint32_t index_count;
+	};
+
+	/**
+	 * \brief Draw a subset of the index buffer in a single call (glMultiDrawElements)
+	 */
+	void draw_ranges(const std::vector<IndexRange>& ranges) const;
+
+	/**
+	 * \brief Layout of the commands read by draw_indirect()
+	 */
+	struct DrawElementsIndirectCommand
+	{
+		uint32_t index_count;
+		uint32_t instance_count;
+		uint32_t first_index;
+		int32_t  base_vertex;
+		uint32_t base_instance;
+	};
+
+	/**
+	 * \brief Draw draw_count commands stored in indirect_buffer at the given byte offset (glMultiDrawElementsIndirect)
+	 */
+	void draw_indirect(uint32_t indirect_buffer, size_t offset, uint32_t draw_count) const;
+
 	void rebuild_mesh_data() const;
 
 	[[nodiscard]] size_t index_count() const { return indices.size(); }
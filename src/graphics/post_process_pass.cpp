@@ -1,7 +1,8 @@
 #include "post_process_pass.h"
 
-#include <vao.h>
-
+#include "gl_state.h"
+#include "gpu_profiler.h"
+#include "gpu_timer.h"
 #include "material.h"
 #include "engine/renderer.h"
 #include "utils/gl_tools.h"
@@ -14,32 +15,49 @@ static std::unordered_map<std::string, std::shared_ptr<Material>> post_process_m
 void PostProcessPass::render(bool to_back_buffer) {
     if (!pre_render())
         return;
-    STAT_FRAME("Post processing pass [" + name + "]");
+    STAT_FRAME("Post processing pass [{}]", name);
+    STAT_GPU("Post processing pass [{}]", name);
     GL_CHECK_ERROR();
     bind(to_back_buffer);
     GL_CHECK_ERROR();
     glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
-    glDepthFunc(GL_GREATER);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glFrontFace(GL_CCW);
+    GlState::get().set_enabled(GL_CULL_FACE, false);
+    GlState::get().set_enabled(GL_DEPTH_TEST, false);
+    GlState::get().set_depth_func(GL_GREATER);
+    GlState::get().set_polygon_mode(GL_FILL);
+    GlState::get().set_front_face(GL_CCW);
     glClearColor(1, 0, 1, 1);
     glClearDepth(0.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     GL_CHECK_ERROR();
-    EZCOGL::VAO::bind_none();
+    GlState::get().bind_vertex_array(0);
     GL_CHECK_ERROR();
-    pass_material->bind();
+    if (select_permutation)
+        pass_material->set_defines(select_permutation());
+    if (!pass_material->bind()) {
+        GlState::get().bind_framebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        return;
+    }
 
     GL_CHECK_ERROR();
     bind_dependencies_to_material(pass_material);
     on_bind_material.execute(pass_material);
 
     GL_CHECK_ERROR();
+    auto& timer = gpu_timers[pass_material->get_permutation_key()];
+    if (!timer)
+        timer = GpuTimer::create(name + (pass_material->get_permutation_key().empty() ? "" : " [" + pass_material->get_permutation_key() + "]"));
+    timer->begin();
     glDrawArrays(GL_TRIANGLES, 0, 3);
+    timer->end();
     GL_CHECK_ERROR();
-    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    GlState::get().bind_framebuffer(GL_DRAW_FRAMEBUFFER, 0);
+}
+
+void PostProcessPass::on_select_permutation(const std::function<ShaderDefines()>& callback) {
+    select_permutation = callback;
+    if (select_permutation)
+        pass_material->set_defines(select_permutation());
 }
 
 PostProcessPass::PostProcessPass(std::string in_name, uint32_t width, uint32_t height, const std::string& fragment_shader, TextureCreateInfos create_infos)
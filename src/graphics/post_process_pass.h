@@ -3,9 +3,13 @@
 #include <memory>
 #include <string>
 
+#include <unordered_map>
+
 #include "render_pass.h"
+#include "shader_source.h"
 #include "texture_image.h"
 
+class GpuTimer;
 class Renderer;
 
 class Material;
@@ -26,7 +30,21 @@ public:
 
     EventBindMaterial on_bind_material;
 
+    /**
+     * \brief Called before each draw to select the permutation of the material (see Material::set_defines()). Also applied immediately.
+     * Passes sharing the same fragment shader share their material : they should select the same permutation.
+     */
+    void on_select_permutation(const std::function<ShaderDefines()>& callback);
+
+    /**
+     * \brief GPU time of this pass for each permutation that was drawn (key : Material::get_permutation_key())
+     */
+    [[nodiscard]] const std::unordered_map<std::string, std::shared_ptr<GpuTimer>>& get_gpu_timers() const { return gpu_timers; }
+
 private:
     PostProcessPass(std::string in_name, uint32_t width, uint32_t height, const std::string& fragment_shader, TextureCreateInfos create_infos);
     std::shared_ptr<Material> pass_material;
+
+    std::function<ShaderDefines()>                             select_permutation = nullptr;
+    std::unordered_map<std::string, std::shared_ptr<GpuTimer>> gpu_timers;
 };
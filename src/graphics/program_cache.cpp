@@ -0,0 +1,287 @@
+#include "program_cache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+#include "gl_state.h"
+#include "utils/gl_tools.h"
+#include "utils/profiler.h"
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+// Same parsing as EZCOGL::Shader::compile() : errors are formatted as "0(line) : error ..."
+static size_t parse_error_line(const std::string& log) {
+    std::istringstream stream(log);
+    std::string        line;
+    while (std::getline(stream, line)) {
+        const size_t open  = line.find('(');
+        const size_t close = line.find(')', open);
+        if (open == std::string::npos || close == std::string::npos)
+            continue;
+        const std::string number = line.substr(open + 1, close - open - 1);
+        char*             end    = nullptr;
+        const long        value  = strtol(number.c_str(), &end, 10);
+        if (!number.empty() && *end == 0)
+            return static_cast<size_t>(value);
+    }
+    return 0;
+}
+
+ProgramBuild::ProgramBuild(std::string in_name, std::vector<ProgramStage> in_stages, const ShaderDefines& defines)
+    : name(std::move(in_name)), stages(std::move(in_stages)) {
+    STAT_ACTION("Start shader build [{}]", name);
+    auto& cache = ProgramCache::get();
+
+    std::vector<std::string> sources;
+    for (const auto& stage : stages)
+        sources.emplace_back(stage.source->get_source_code(defines));
+    key = cache.make_key(stages, sources);
+
+    program    = glCreateProgram();
+    from_cache = cache.load(program, key);
+    cache.on_build_started(from_cache);
+    if (from_cache)
+        return;
+
+    // A failed glProgramBinary leaves the program in an undefined state
+    glDeleteProgram(program);
+    program = glCreateProgram();
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    // Status are only queried in finish() : the driver may compile every stage asynchronously
+    for (size_t i = 0; i < stages.size(); ++i) {
+        const uint32_t shader = glCreateShader(stages[i].type);
+        const char*    code   = sources[i].c_str();
+        glShaderSource(shader, 1, &code, nullptr);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        shaders.emplace_back(shader);
+    }
+    glLinkProgram(program);
+    GL_CHECK_ERROR();
+}
+
+ProgramBuild::~ProgramBuild() {
+    for (const auto& shader : shaders)
+        glDeleteShader(shader);
+    if (program)
+        glDeleteProgram(program);
+    ProgramCache::get().on_build_ended();
+}
+
+bool ProgramBuild::is_ready() const {
+    if (from_cache || !ProgramCache::get().is_parallel_compile_supported())
+        return true;
+    int completed = GL_FALSE;
+    glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &completed);
+    return completed == GL_TRUE;
+}
+
+uint32_t ProgramBuild::finish(std::optional<CompilationErrorInfo>& error) {
+    STAT_ACTION("Finish shader build [{}]", name);
+    error.reset();
+
+    // Check compilation errors. Warnings are only reported.
+    for (size_t i = 0; i < shaders.size() && !error; ++i) {
+        int info_log_length = 0;
+        glGetShaderiv(shaders[i], GL_INFO_LOG_LENGTH, &info_log_length);
+        if (info_log_length <= 1)
+            continue;
+        std::string info_log(info_log_length, '\0');
+        glGetShaderInfoLog(shaders[i], info_log_length, nullptr, info_log.data());
+        int compile_status = GL_FALSE;
+        glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &compile_status);
+        if (compile_status == GL_TRUE) {
+            std::cerr << "Shader warnings [" << name << "] :\n" << info_log.c_str() << std::endl;
+            continue;
+        }
+        size_t local_line = 0;
+        error             = {
+            .error = info_log.c_str(),
+            .line = 0,
+            .file = stages[i].source->get_file_at_line(parse_error_line(info_log), local_line),
+            .is_fragment = stages[i].type != GL_VERTEX_SHADER && stages[i].type != GL_GEOMETRY_SHADER,
+        };
+        error->line = local_line;
+    }
+
+    // Check link errors
+    if (!error) {
+        int info_log_length = 0;
+        glGetProgramiv(program, GL_INFO_LOG_LENGTH, &info_log_length);
+        int link_status = GL_FALSE;
+        glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+        std::string info_log(std::max(info_log_length, 1), '\0');
+        if (info_log_length > 1)
+            glGetProgramInfoLog(program, info_log_length, nullptr, info_log.data());
+        if (link_status == GL_TRUE && info_log_length > 1)
+            std::cerr << "Program link warnings [" << name << "] :\n" << info_log.c_str() << std::endl;
+        else if (link_status != GL_TRUE) {
+            error = {
+                .error = info_log.c_str(),
+                .line = 0,
+                .file = "",
+                .is_fragment = false,
+            };
+        }
+    }
+
+    for (const auto& shader : shaders) {
+        glDetachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    shaders.clear();
+    GL_CHECK_ERROR();
+
+    if (error) {
+        GlState::get().on_program_deleted(program);
+        glDeleteProgram(program);
+        program = 0;
+        return 0;
+    }
+
+    if (!from_cache)
+        ProgramCache::get().store(program, key);
+
+    const uint32_t result = program;
+    program               = 0;
+    return result;
+}
+
+static std::unique_ptr<ProgramCache> program_cache_singleton = nullptr;
+
+ProgramCache& ProgramCache::get() {
+    if (!program_cache_singleton)
+        program_cache_singleton = std::unique_ptr<ProgramCache>(new ProgramCache());
+    return *program_cache_singleton;
+}
+
+ProgramCache::ProgramCache() {
+    // Binaries are only valid for the driver that produced them
+    driver = std::string(reinterpret_cast<const char*>(glGetString(GL_VENDOR))) + reinterpret_cast<const char*>(glGetString(GL_RENDERER)) +
+             reinterpret_cast<const char*>(glGetString(GL_VERSION));
+
+    // Not loaded by gl3w
+    using MaxShaderCompilerThreads = void (APIENTRYP)(GLuint count);
+    MaxShaderCompilerThreads max_compiler_threads = nullptr;
+    if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+        max_compiler_threads = reinterpret_cast<MaxShaderCompilerThreads>(glfwGetProcAddress("glMaxShaderCompilerThreadsKHR"));
+    else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+        max_compiler_threads = reinterpret_cast<MaxShaderCompilerThreads>(glfwGetProcAddress("glMaxShaderCompilerThreadsARB"));
+    if (max_compiler_threads) {
+        max_compiler_threads(0xFFFFFFFF); // Let the driver choose
+        parallel_compile = true;
+    }
+
+    int binary_format_count = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binary_format_count);
+    if (binary_format_count == 0)
+        std::cerr << "Program binaries are not supported by the driver : shaders will always be compiled" << std::endl;
+    GL_CHECK_ERROR();
+}
+
+uint64_t ProgramCache::make_key(const std::vector<ProgramStage>& stages, const std::vector<std::string>& sources) const {
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ull;
+    const auto hash_bytes = [&](const void* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= static_cast<const uint8_t*>(data)[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    hash_bytes(driver.data(), driver.size());
+    for (size_t i = 0; i < stages.size(); ++i) {
+        hash_bytes(&stages[i].type, sizeof(uint32_t));
+        hash_bytes(sources[i].data(), sources[i].size());
+    }
+    return hash;
+}
+
+std::string ProgramCache::file_path(uint64_t key) const {
+    char file_name[32];
+    snprintf(file_name, sizeof(file_name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return cache_directory + "/" + file_name;
+}
+
+bool ProgramCache::load(uint32_t program, uint64_t key) const {
+    std::ifstream file(file_path(key), std::ios::binary | std::ios::ate);
+    if (!file)
+        return false;
+
+    const auto file_size = static_cast<size_t>(file.tellg());
+    if (file_size <= sizeof(uint32_t))
+        return false;
+    file.seekg(0);
+    uint32_t          format = 0;
+    std::vector<char> binary(file_size - sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(&format), sizeof(uint32_t));
+    file.read(binary.data(), static_cast<std::streamsize>(binary.size()));
+    if (!file)
+        return false;
+
+    glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+    // Rejected after a driver update : compile again
+    int link_status = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+    while (glGetError() != GL_NO_ERROR);
+    return link_status == GL_TRUE;
+}
+
+void ProgramCache::store(uint32_t program, uint64_t key) const {
+    int binary_length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binary_length);
+    if (binary_length <= 0)
+        return;
+
+    GLenum            format = 0;
+    std::vector<char> binary(binary_length);
+    glGetProgramBinary(program, binary_length, nullptr, &format, binary.data());
+    GL_CHECK_ERROR();
+
+    std::error_code error;
+    std::filesystem::create_directories(cache_directory, error);
+    std::ofstream file(file_path(key), std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cerr << "failed to write program binary " << file_path(key) << std::endl;
+        return;
+    }
+    const uint32_t stored_format = format;
+    file.write(reinterpret_cast<const char*>(&stored_format), sizeof(uint32_t));
+    file.write(binary.data(), static_cast<std::streamsize>(binary.size()));
+}
+
+void ProgramCache::on_build_started(bool cache_hit) {
+    running_builds++;
+    if (cache_hit)
+        stats.cache_hits++;
+    else
+        stats.cache_misses++;
+}
+
+void ProgramCache::on_build_ended() {
+    running_builds--;
+    if (running_builds == 0 && startup_start)
+        report_startup();
+}
+
+void ProgramCache::track_startup(std::chrono::steady_clock::time_point start) {
+    startup_start = start;
+    if (running_builds == 0)
+        report_startup();
+}
+
+void ProgramCache::report_startup() {
+    stats.startup_milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - *startup_start).count();
+    stats.warm_startup         = stats.cache_misses == 0;
+    startup_start.reset();
+    std::cout << "Shader programs ready in " << stats.startup_milliseconds << " ms (" << (stats.warm_startup ? "warm" : "cold") << " startup : " << stats.cache_hits
+        << " loaded from cache, " << stats.cache_misses << " compiled)" << std::endl;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "shader_source.h"
+
+struct ProgramStage {
+    uint32_t            type; // GL_VERTEX_SHADER, GL_FRAGMENT_SHADER...
+    const ShaderSource* source;
+};
+
+/**
+ * \brief Build of a shader program running in the background.
+ * The program is loaded from the on-disk binary cache when possible (glProgramBinary). Otherwise its shaders are compiled and linked without querying their status,
+ * which lets the driver compile them in parallel when GL_KHR_parallel_shader_compile is supported.
+ */
+class ProgramBuild {
+public:
+    /**
+     * \param defines definitions injected in every stage (see ShaderSource::get_source_code())
+     */
+    ProgramBuild(std::string name, std::vector<ProgramStage> stages, const ShaderDefines& defines = {});
+    ~ProgramBuild();
+
+    /**
+     * \brief Return true when finish() won't stall (always true without GL_KHR_parallel_shader_compile)
+     */
+    [[nodiscard]] bool is_ready() const;
+
+    /**
+     * \brief Wait for the build to complete, check errors and store the program binary into the cache.
+     * \return the linked program (now owned by the caller), or 0 if the build failed (error is then set)
+     */
+    uint32_t finish(std::optional<CompilationErrorInfo>& error);
+
+    const std::string name;
+
+private:
+    std::vector<ProgramStage> stages;
+    std::vector<uint32_t>     shaders;
+    uint32_t                  program    = 0;
+    uint64_t                  key        = 0;
+    bool                      from_cache = false;
+};
+
+/**
+ * \brief Program binaries stored on disk, keyed by a hash of the expanded shader sources and of the driver
+ */
+class ProgramCache {
+public:
+    static ProgramCache& get();
+
+    struct Stats {
+        uint32_t cache_hits           = 0;
+        uint32_t cache_misses         = 0;
+        double   startup_milliseconds = -1;    // Time until every program requested at startup was ready, -1 while pending
+        bool     warm_startup         = false; // Every startup program was loaded from the cache
+    };
+
+    [[nodiscard]] const Stats& get_stats() const { return stats; }
+
+    /**
+     * \brief Report the startup time once every running build is finished
+     * \param start time at which the startup builds were requested
+     */
+    void track_startup(std::chrono::steady_clock::time_point start);
+
+    [[nodiscard]] bool is_parallel_compile_supported() const { return parallel_compile; }
+
+private:
+    friend class ProgramBuild;
+
+    ProgramCache();
+
+    [[nodiscard]] uint64_t    make_key(const std::vector<ProgramStage>& stages, const std::vector<std::string>& sources) const;
+    [[nodiscard]] std::string file_path(uint64_t key) const;
+    [[nodiscard]] bool        load(uint32_t program, uint64_t key) const;
+    void                      store(uint32_t program, uint64_t key) const;
+
+    void on_build_started(bool cache_hit);
+    void on_build_ended();
+    void report_startup();
+
+    std::string                                          driver;
+    std::string                                          cache_directory  = "shader_cache";
+    bool                                                 parallel_compile = false;
+    uint32_t                                             running_builds   = 0;
+    std::optional<std::chrono::steady_clock::time_point> startup_start;
+    Stats                                                stats;
+};
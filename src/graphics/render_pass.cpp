@@ -6,6 +6,8 @@
 #include <utility>
 #include <GL/gl3w.h>
 
+#include "gl_state.h"
+#include "gpu_profiler.h"
 #include "texture_image.h"
 #include "utils/gl_tools.h"
 #include "utils/profiler.h"
@@ -15,9 +17,9 @@ TextureAttachment::TextureAttachment(std::string framebuffer_name, std::string i
     : Attachment(std::move(in_name), in_format, in_binding_index) {
     render_target = Texture2D::create(framebuffer_name + "_" + name, create_infos);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GlState::get().bind_framebuffer(GL_FRAMEBUFFER, framebuffer);
     glFramebufferTexture2D(GL_FRAMEBUFFER, is_depth_format(format) ? GL_DEPTH_ATTACHMENT : GL_COLOR_ATTACHMENT0 + binding_index, GL_TEXTURE_2D, render_target->id(), 0);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GlState::get().bind_framebuffer(GL_FRAMEBUFFER, 0);
 }
 
 void TextureAttachment::init(uint32_t width, uint32_t height) {
@@ -28,9 +30,9 @@ RenderBufferAttachment::RenderBufferAttachment(std::string in_name, ImageFormat
     : Attachment(std::move(in_name), in_format, binding_index), rbo(0) {
     glGenRenderbuffers(1, &rbo);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    GlState::get().bind_framebuffer(GL_FRAMEBUFFER, framebuffer);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, is_depth_format(format) ? GL_DEPTH_ATTACHMENT : GL_COLOR_ATTACHMENT0 + binding_index, GL_RENDERBUFFER, rbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    GlState::get().bind_framebuffer(GL_FRAMEBUFFER, 0);
 }
 
 RenderBufferAttachment::~RenderBufferAttachment() {
@@ -101,7 +103,7 @@ bool RenderPass::pre_render() {
     for (const auto& dep : dependencies)
         dep->render(false);
 
-    STAT_FRAME("Prepare pass [" + name + "]");
+    STAT_FRAME("Prepare pass [{}]", name);
     if (is_dirty)
         init_attachments();
 
@@ -111,17 +113,16 @@ bool RenderPass::pre_render() {
 void RenderPass::bind(bool back_buffer) {
     GL_CHECK_ERROR();
     if (back_buffer) {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        GlState::get().bind_framebuffer(GL_FRAMEBUFFER, 0);
     } else {
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer_id);
+        GlState::get().bind_framebuffer(GL_DRAW_FRAMEBUFFER, framebuffer_id);
 
         std::vector<uint32_t> attachment_ids(color_attachments.size());
         for (int i            = 0; i < color_attachments.size(); ++i)
             attachment_ids[i] = GL_COLOR_ATTACHMENT0 + i;
         glDrawBuffers(static_cast<GLsizei>(attachment_ids.size()), attachment_ids.data());
     }
-    glViewport(0, 0, width, height);
+    GlState::get().set_viewport(0, 0, static_cast<int32_t>(width), static_cast<int32_t>(height));
     GL_CHECK_ERROR();
 }
 
@@ -131,7 +132,7 @@ RenderPass::RenderPass(std::string name, uint32_t in_width, uint32_t in_height)
 }
 
 void RenderPass::init_attachments() {
-    STAT_ACTION("Resize framebuffer [" + name + "] to " + std::to_string(width) + "x" + std::to_string(height));
+    STAT_ACTION("Resize framebuffer [{}] to {}x{}", name, width, height);
     if (depth_attachment)
         depth_attachment->init(width, height);
     for (const auto& color_attachment : color_attachments)
@@ -141,6 +142,7 @@ void RenderPass::init_attachments() {
 }
 
 RenderPass::~RenderPass() {
+    GlState::get().on_framebuffer_deleted(framebuffer_id);
     glDeleteFramebuffers(1, &framebuffer_id);
 }
 
@@ -148,19 +150,20 @@ void RenderPass::render(bool to_back_buffer) {
     if (!pre_render())
         return;
     {
-        STAT_FRAME("Bind render pass [" + name + "]");
+        STAT_FRAME("Bind render pass [{}]", name);
         bind(to_back_buffer);
         glClipControl(GL_LOWER_LEFT, GL_ZERO_TO_ONE);
-        glEnable(GL_CULL_FACE);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_GREATER);
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-        glFrontFace(GL_CCW);
+        GlState::get().set_enabled(GL_CULL_FACE, true);
+        GlState::get().set_enabled(GL_DEPTH_TEST, true);
+        GlState::get().set_depth_func(GL_GREATER);
+        GlState::get().set_polygon_mode(GL_FILL);
+        GlState::get().set_front_face(GL_CCW);
         glClearColor(0, 0, 0, 0);
         glClearDepth(0.0);
         glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
     }
-    STAT_FRAME("Draw render pass [" + name + "]");
+    STAT_FRAME("Draw render pass [{}]", name);
+    STAT_GPU("Render pass [{}]", name);
     on_draw.execute();
 }
 
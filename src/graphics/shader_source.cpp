@@ -1,8 +1,13 @@
 #include "shader_source.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <unordered_map>
+
+#include "utils/file_watcher.h"
 
 struct StdFileTimeType : public ShaderSource::FileTimeType {
     void*                           get() override { return &time_var; }
@@ -13,11 +18,96 @@ ShaderSource::ShaderSource() {
     last_file_update = std::make_shared<StdFileTimeType>();
 }
 
-std::string ShaderSource::get_source_code() const {
-    std::string source_code;
-    for (const auto& item : content)
-        source_code += item->get_content();
-    return source_code;
+ShaderSource::~ShaderSource() {
+    if (!source_path.empty())
+        FileWatcher::get().unwatch(source_path, this);
+    unlink_dependencies();
+}
+
+static std::unordered_map<std::string, std::weak_ptr<ShaderSource>> include_cache;
+
+std::shared_ptr<ShaderSource> ShaderSource::get_include(const std::string& path) {
+    const std::string key = FileWatcher::canonical_path(path);
+
+    if (auto existing = include_cache[key].lock())
+        return existing;
+
+    // Registered before parsing, so that recursive includes find it
+    auto source        = std::make_shared<ShaderSource>();
+    include_cache[key] = source;
+    source->set_source_path(path);
+    return source;
+}
+
+const ShaderSource::Expansion& ShaderSource::get_expansion() const {
+    if (!expansion.valid) {
+        expansion = Expansion();
+        std::vector<std::string> defined_guards;
+        expand(expansion, defined_guards);
+        expansion.valid = true;
+    }
+    return expansion;
+}
+
+void ShaderSource::expand(Expansion& out_expansion, std::vector<std::string>& defined_guards) const {
+    // The preprocessor would discard the whole file anyway
+    if (!include_guard.empty()) {
+        if (std::ranges::find(defined_guards, include_guard) != defined_guards.end())
+            return;
+        defined_guards.emplace_back(include_guard);
+    }
+
+    for (const auto& chunk : content) {
+        if (const auto* dependency = chunk->get_dependency()) {
+            dependency->expand(out_expansion, defined_guards);
+            continue;
+        }
+        out_expansion.lines.emplace_back(LineRange{
+            .first_line = out_expansion.line_count,
+            .line_count = chunk->get_line_count(),
+            .file = this,
+            .file_line = chunk->get_first_line(),
+        });
+        out_expansion.code += chunk->get_content();
+        out_expansion.line_count += chunk->get_line_count();
+    }
+}
+
+const std::string& ShaderSource::get_source_code() const {
+    return get_expansion().code;
+}
+
+std::string shader_defines_key(const ShaderDefines& defines) {
+    std::string key;
+    for (const auto& [name, value] : defines)
+        key += (key.empty() ? "" : ";") + name + "=" + value;
+    return key;
+}
+
+std::string ShaderSource::get_source_code(const ShaderDefines& defines) const {
+    const std::string& code = get_source_code();
+    if (defines.empty())
+        return code;
+
+    // #version must stay the first directive
+    size_t insert_position = 0;
+    size_t next_line       = 1;
+    const size_t version   = code.find("#version");
+    if (version != std::string::npos) {
+        const size_t line_end = code.find('\n', version);
+        insert_position       = line_end == std::string::npos ? code.size() : line_end + 1;
+        next_line             = 1 + std::count(code.begin(), code.begin() + static_cast<std::ptrdiff_t>(insert_position), '\n');
+    }
+
+    std::string header;
+    for (const auto& [name, value] : defines)
+        header += "#define " + name + " " + value + "\n";
+    header += "#line " + std::to_string(next_line) + "\n";
+
+    std::string result = code.substr(0, insert_position);
+    if (!result.empty() && result.back() != '\n')
+        result += '\n';
+    return result + header + code.substr(insert_position);
 }
 
 void ShaderSource::check_update() {
@@ -25,7 +115,9 @@ void ShaderSource::check_update() {
     if (source_path.empty()) {
         if (!content.empty()) {
             // File have been removed
+            unlink_dependencies();
             content.clear();
+            expansion.valid = false;
             on_data_changed.execute();
         }
         return;
@@ -47,10 +139,23 @@ void ShaderSource::check_update() {
     reload_internal();
 }
 
+void ShaderSource::on_file_changed() {
+    // Includes are watched individually : only this file needs to be checked
+    std::error_code error;
+    const auto      time = std::filesystem::last_write_time(source_path, error);
+    if (error || time == last_file_update->get<std::filesystem::file_time_type>())
+        return;
+    reload_internal();
+}
+
 void ShaderSource::set_source_path(const std::string& in_source_path) {
     if (source_path == in_source_path)
         return;
+    if (!source_path.empty())
+        FileWatcher::get().unwatch(source_path, this);
     source_path = in_source_path;
+    if (!source_path.empty())
+        FileWatcher::get().watch(source_path).add_object(this, &ShaderSource::on_file_changed);
     reload_internal();
 }
 
@@ -67,31 +172,54 @@ std::vector<const ShaderSource*> ShaderSource::get_dependencies() const {
 }
 
 size_t ShaderSource::get_line_count() const {
-    size_t line_count = 0;
-    for (const auto& dep : content)
-        line_count += dep->get_line_count();
-    return line_count;
+    return get_expansion().line_count;
 }
 
 std::string ShaderSource::get_file_at_line(size_t line, size_t& local_line) const {
-    std::string file = get_path();
+    const auto& lines = get_expansion().lines;
 
-    size_t current_start = 0;
-    size_t include_size  = 0;
-    for (const auto& chunk : content) {
-        if (line < current_start + chunk->get_line_count()) {
-            if (const auto* dep = chunk->get_dependency())
-                return dep->get_file_at_line(line - current_start, local_line);
-            local_line = line - include_size;
-            return file;
-        }
-        if (chunk->get_dependency())
-            include_size += chunk->get_line_count();
-        current_start += chunk->get_line_count();
+    // Last range starting before this line
+    auto range = std::upper_bound(lines.begin(), lines.end(), line, [](size_t value, const LineRange& item) { return value < item.first_line; });
+    if (range == lines.begin()) {
+        local_line = line;
+        return get_path();
     }
+    --range;
+    local_line = range->file_line + line - range->first_line;
+    return range->file->get_path();
+}
 
-    local_line = line - include_size;
-    return file;
+void ShaderSource::on_dependency_changed() {
+    expansion.valid = false;
+    on_data_changed.execute();
+}
+
+void ShaderSource::unlink_dependencies() {
+    // Includes are shared : only remove this listener
+    for (const auto& dep : content)
+        if (dep->get_dependency())
+            dep->get_dependency()->on_data_changed.clear_object(this);
+}
+
+// Macro of a "#ifndef X / #define X / ... / #endif" include guard, or an empty string
+static std::string find_include_guard(const std::vector<std::string>& lines) {
+    std::vector<std::string> directives;
+    for (const auto& line : lines)
+        if (line.find_first_not_of(" \t\r") != std::string::npos)
+            directives.emplace_back(line);
+    if (directives.size() < 3)
+        return "";
+
+    std::istringstream ifndef_line(directives[0]);
+    std::istringstream define_line(directives[1]);
+    std::istringstream endif_line(directives.back());
+    std::string        ifndef_token, ifndef_macro, define_token, define_macro, endif_token;
+    ifndef_line >> ifndef_token >> ifndef_macro;
+    define_line >> define_token >> define_macro;
+    endif_line >> endif_token;
+    if (ifndef_token != "#ifndef" || define_token != "#define" || endif_token != "#endif" || ifndef_macro != define_macro)
+        return "";
+    return ifndef_macro;
 }
 
 void ShaderSource::reload_internal() {
@@ -104,10 +232,10 @@ void ShaderSource::reload_internal() {
     last_file_update->get<std::filesystem::file_time_type>() = std::filesystem::last_write_time(source_path);
 
     // Unlink dependencies
-    for (const auto& dep : content)
-        if (dep->get_dependency())
-            dep->get_dependency()->on_data_changed.clear();
+    unlink_dependencies();
     content.clear();
+    include_guard.clear();
+    expansion.valid = false;
 
     // Open file
     std::ifstream file(source_path, std::ios_base::in);
@@ -115,18 +243,25 @@ void ShaderSource::reload_internal() {
         return;
     }
 
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(file, line);)
+        lines.emplace_back(line);
+    include_guard = find_include_guard(lines);
+
     std::string shader_text_code;
     size_t      line_count = 0;
-    // Read file line by line
-    for (std::string line; std::getline(file, line);) {
-        bool is_include = false;
+    size_t      first_line = 0;
+    for (size_t line_index = 0; line_index < lines.size(); ++line_index) {
+        const std::string& line       = lines[line_index];
+        bool               is_include = false;
         for (size_t i = 0; i < line.length(); ++i) {
             if (line.substr(i, 8) == "#include") {
                 // We encountered include directive. Store parsed data into new chunk.
                 if (!shader_text_code.empty())
-                    content.emplace_back(std::make_shared<SourceChunkText>(shader_text_code, line_count));
+                    content.emplace_back(std::make_shared<SourceChunkText>(shader_text_code, line_count, first_line));
                 shader_text_code.clear();
                 line_count = 0;
+                first_line = line_index + 1;
 
                 is_include = true;
 
@@ -139,10 +274,9 @@ void ShaderSource::reload_internal() {
 
                 include_path = std::filesystem::path(get_path()).parent_path().concat("/").concat(include_path).
                                                                  string();
-                const auto new_dep = std::make_shared<SourceChunkDependency>();
-                new_dep->dependency.set_source_path(include_path);
-                new_dep->dependency.on_data_changed.add_object(this, &ShaderSource::reload_internal);
-                content.emplace_back(new_dep);
+                const auto dependency = get_include(include_path);
+                dependency->on_data_changed.add_object(this, &ShaderSource::on_dependency_changed);
+                content.emplace_back(std::make_shared<SourceChunkDependency>(dependency));
                 break;
             }
             // Not an include directive
@@ -156,9 +290,7 @@ void ShaderSource::reload_internal() {
     }
 
     if (!shader_text_code.empty())
-        content.emplace_back(std::make_shared<SourceChunkText>(shader_text_code, line_count));
-    shader_text_code.clear();
-    line_count = 0;
+        content.emplace_back(std::make_shared<SourceChunkText>(shader_text_code, line_count, first_line));
 
     on_data_changed.execute();
 }
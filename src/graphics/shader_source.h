@@ -1,11 +1,25 @@
 #pragma once
+#include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "utils/event_manager.h"
 
 class ShaderSource;
 DECLARE_DELEGATE_MULTICAST(Event_ShaderFileUpdate);
 
+/**
+ * \brief Preprocessor definitions (name -> value) injected at the top of a shader to build one of its permutations.
+ * Sorted by name, so that equal sets always produce the same key.
+ */
+using ShaderDefines = std::map<std::string, std::string>;
+
+/**
+ * \brief Unique string of a set of definitions ("NAME=VALUE;..."), empty if there is no definition
+ */
+[[nodiscard]] std::string shader_defines_key(const ShaderDefines& defines);
+
 struct CompilationErrorInfo {
     std::string error;
     size_t      line;
@@ -19,8 +33,12 @@ struct CompilationErrorInfo {
  */
 class ISourceChunk {
 public:
-    virtual std::string get_content() = 0;
-    virtual size_t      get_line_count() = 0;
+    virtual ~ISourceChunk() = default;
+
+    // Only for text chunk type.
+    virtual const std::string& get_content() = 0;
+    virtual size_t             get_line_count() = 0;
+    virtual size_t             get_first_line() = 0;
 
     // Only for include chunk type.
     virtual ShaderSource* get_dependency() = 0;
@@ -29,24 +47,36 @@ public:
 
 /**
  * \brief Read and parse shader source code. Also handles includes directives and hot reloads.
+ * Included files are parsed once and shared by every includer (see get_include()). The expanded code is cached until this file or one of its includes changes.
+ * Every file is registered to the FileWatcher : modifications are reloaded when FileWatcher::dispatch_events() is called.
  */
 class ShaderSource final {
 public:
     ShaderSource();
-    ~ShaderSource() = default;
+    ~ShaderSource();
+    ShaderSource(const ShaderSource&)            = delete;
+    ShaderSource& operator=(const ShaderSource&) = delete;
 
     /**
      * \brief Get parser result. The resulting string can be compiled.
+     * Files protected by an include guard (#ifndef X / #define X ... #endif) are only expanded once.
      */
-    [[nodiscard]] std::string get_source_code() const;
+    [[nodiscard]] const std::string& get_source_code() const;
 
     /**
-     * \brief When source code have been modified (hot reload or new source file)
+     * \brief Source code with the given definitions inserted right after the #version directive.
+     * A #line directive follows them, so that line numbers of compilation errors are unchanged.
+     */
+    [[nodiscard]] std::string get_source_code(const ShaderDefines& defines) const;
+
+    /**
+     * \brief When source code have been modified (hot reload, new source file, or modified include)
      */
     Event_ShaderFileUpdate on_data_changed;
 
     /**
-     * \brief Reload file if any changes have been detected
+     * \brief Compare the timestamps of this file and of its includes, and reload the modified ones.
+     * Not needed for hot reload (see FileWatcher), but forces a check of every file.
      */
     void check_update();
 
@@ -77,6 +107,11 @@ public:
     [[nodiscard]] const std::string& get_path() const { return source_path; }
     [[nodiscard]] std::string        get_file_name() const;
 
+    /**
+     * \brief Shared source of an included file : there is only one instance per canonical path.
+     */
+    static std::shared_ptr<ShaderSource> get_include(const std::string& path);
+
     struct FileTimeType {
         virtual void* get() = 0;
         template <typename T> T& get() { return *static_cast<T*>(get()); }
@@ -86,10 +121,34 @@ private:
     std::vector<std::shared_ptr<ISourceChunk>> content;
 
     std::string source_path;
+    std::string include_guard; // Macro of the include guard of this file, empty if none
 
     std::shared_ptr<FileTimeType> last_file_update = nullptr;
 
+    // Lines of the expanded code coming from a text chunk
+    struct LineRange {
+        size_t              first_line; // In the expanded code
+        size_t              line_count;
+        const ShaderSource* file;
+        size_t              file_line; // Line of first_line in file
+    };
+
+    struct Expansion {
+        std::string            code;
+        std::vector<LineRange> lines;
+        size_t                 line_count = 0;
+        bool                   valid      = false;
+    };
+
+    void expand(Expansion& expansion, std::vector<std::string>& defined_guards) const;
+    const Expansion& get_expansion() const;
+
+    mutable Expansion expansion;
+
     void reload_internal();
+    void on_file_changed();
+    void on_dependency_changed();
+    void unlink_dependencies();
 };
 
 /**
@@ -97,17 +156,19 @@ private:
  */
 class SourceChunkText : public ISourceChunk {
 public:
-    SourceChunkText(std::string in_text, size_t line_count)
-        : text(std::move(in_text)), line_count(line_count) { return; }
+    SourceChunkText(std::string in_text, size_t in_line_count, size_t in_first_line)
+        : line_count(in_line_count), first_line(in_first_line), text(std::move(in_text)) { return; }
 
-    size_t      get_line_count() override { return line_count; }
-    std::string get_content() override { return text; }
+    const std::string& get_content() override { return text; }
+    size_t             get_line_count() override { return line_count; }
+    size_t             get_first_line() override { return first_line; }
 
     ShaderSource* get_dependency() override { return nullptr; }
     void          check_update() override { return void(); }
 
 private:
     size_t            line_count = 0;
+    size_t            first_line = 0;
     const std::string text;
 };
 
@@ -116,9 +177,15 @@ private:
  */
 class SourceChunkDependency : public ISourceChunk {
 public:
-    std::string   get_content() override { return dependency.get_source_code(); }
-    void          check_update() override { dependency.check_update(); }
-    ShaderSource* get_dependency() override { return &dependency; }
-    size_t        get_line_count() override { return dependency.get_line_count(); }
-    ShaderSource  dependency;
+    SourceChunkDependency(std::shared_ptr<ShaderSource> in_dependency)
+        : dependency(std::move(in_dependency)) { return; }
+
+    const std::string& get_content() override { return dependency->get_source_code(); }
+    size_t             get_line_count() override { return dependency->get_line_count(); }
+    size_t             get_first_line() override { return 0; }
+
+    void          check_update() override { dependency->check_update(); }
+    ShaderSource* get_dependency() override { return dependency.get(); }
+
+    const std::shared_ptr<ShaderSource> dependency;
 };
@@ -12,6 +12,12 @@ void StorageBuffer::set_data_raw(const void* data_ptr, size_t data_size) {
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 }
 
+void StorageBuffer::get_data_raw(void* data_ptr, size_t data_size) const {
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssbo_id);
+    glGetBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, data_size, data_ptr);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
 StorageBuffer::StorageBuffer(const std::string& in_name) {
     glGenBuffers(1, &ssbo_id);
 }
@@ -17,6 +17,11 @@ public:
         set_data_raw(&data, sizeof(Struct_T));
     }
 
+    /**
+     * \brief Read back buffer content. (Stall until the GPU is done with this buffer)
+     */
+    void get_data_raw(void* data_ptr, size_t data_size) const;
+
     [[nodiscard]] uint32_t id() const { return ssbo_id; }
 
     const std::string name;
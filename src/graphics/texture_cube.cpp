@@ -3,6 +3,7 @@
 #include <imgui.h>
 #include <texture2d.h>
 
+#include "gl_state.h"
 #include "utils/gl_tools.h"
 #include "utils/profiler.h"
 
@@ -26,7 +27,7 @@ void TextureCube::from_file(const std::string& file_top, const std::string&  fil
     for (size_t i = 0; i < files.size(); ++i) {
         async_load_thread[i] = std::thread(
             [&, files, i, force_nb_channel] {
-                STAT_ACTION("load cubemap [" + files[i] + "]::" + std::to_string(i));
+                STAT_ACTION("load cubemap [{}]::{}", files[i], i);
                 finished_loading[i] = false;
                 loaded_image_ptr[i] = new EZCOGL::GLImage(files[i], EZCOGL::Texture::flip_y_on_load, force_nb_channel);
                 if (!static_cast<EZCOGL::GLImage*>(loaded_image_ptr[i])->data())
@@ -37,7 +38,7 @@ void TextureCube::from_file(const std::string& file_top, const std::string&  fil
 }
 
 void TextureCube::set_data(int32_t w, int32_t h, ImageFormat in_image_format, uint32_t index, const void* image_data) {
-    STAT_ACTION("set cubemap data [" + name + "]::" + std::to_string(index));
+    STAT_ACTION("set cubemap data [{}]::{}", name, index);
     image_format    = in_image_format;
     const auto tf   = EZCOGL::Texture::texture_formats[static_cast<int>(image_format)];
     external_format = tf.first;
@@ -50,6 +51,7 @@ void TextureCube::set_data(int32_t w, int32_t h, ImageFormat in_image_format, ui
     glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + index, 0, GL_SRGB, w, h, 0, external_format, data_format,
                  (w * h > 0) ? image_data : nullptr);
     glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    GlState::get().invalidate_textures();
     GL_CHECK_ERROR();
 }
 
@@ -76,7 +78,7 @@ uint32_t TextureCube::id() {
             complete |= 1 << i;
             GL_CHECK_ERROR();
             if (complete == 0b111111) {
-                STAT_ACTION("Rebuild cubemap mipmaps : [" + name + "]");
+                STAT_ACTION("Rebuild cubemap mipmaps : [{}]", name);
                 GL_CHECK_ERROR();
                 glBindTexture(GL_TEXTURE_CUBE_MAP, TextureBase::id());
                 GL_CHECK_ERROR();
@@ -84,6 +86,7 @@ uint32_t TextureCube::id() {
                 glGetError(); // GL_CHECK_ERROR();
                 //@TODO Mipmaps with cubemaps cause errors, but are required to work.. Why ????
                 glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+                GlState::get().invalidate_textures();
                 GL_CHECK_ERROR();
             }
             GL_CHECK_ERROR();
@@ -7,6 +7,7 @@
 #include <texture2d.h>
 #include <GL/gl3w.h>
 
+#include "gl_state.h"
 #include "utils/gl_tools.h"
 #include "utils/profiler.h"
 
@@ -44,16 +45,14 @@ std::string image_format_to_string(ImageFormat format) {
 }
 
 TextureBase::~TextureBase() {
+    GlState::get().on_texture_deleted(texture_id);
     glDeleteTextures(1, &texture_id);
     texture_id = 0;
 }
 
 void TextureBase::bind(uint32_t unit) {
-    if (id() != 0) {
-        glActiveTexture(GL_TEXTURE0 + unit);
-        glBindTexture(texture_type, id());
-        GL_CHECK_ERROR();
-    }
+    if (id() != 0)
+        GlState::get().bind_texture(unit, id());
 }
 
 TextureBase::TextureBase(std::string in_name, int32_t in_texture_type, const TextureCreateInfos& params)
@@ -116,6 +115,7 @@ TextureBase::TextureBase(std::string in_name, int32_t in_texture_type, const Tex
     glTexParameteri(texture_type, GL_TEXTURE_WRAP_S, wrapping);
     glTexParameteri(texture_type, GL_TEXTURE_WRAP_T, wrapping);
     glTexParameteri(texture_type, GL_TEXTURE_WRAP_R, wrapping);
+    GlState::get().invalidate_textures();
     GL_CHECK_ERROR();
 }
 
@@ -147,20 +147,21 @@ void Texture2D::set_data(uint32_t w, uint32_t h, ImageFormat in_image_format, co
     image_height    = h;
     data_format     = tf.second;
     GL_CHECK_ERROR();
-    bind();
+    glBindTexture(texture_type, TextureBase::id());
     GL_CHECK_ERROR();
     glTexImage2D(texture_type, 0, data_ptr ? (parameters.srgb ? GL_SRGB : static_cast<int>(in_image_format)) : static_cast<int>(image_format), w, h, 0, external_format,
                  data_format,
                  (w * h > 0) ? data_ptr : nullptr);
     GL_CHECK_ERROR();
     glBindTexture(texture_type, 0);
+    GlState::get().invalidate_textures();
 
     GL_CHECK_ERROR();
 }
 
 uint32_t Texture2D::id() {
     if (finished_loading) {
-        STAT_ACTION("set texture data [" + name + "]");
+        STAT_ACTION("set texture data [{}]", name);
         std::lock_guard lock_guard(load_mutex);
         finished_loading = false;
 
@@ -182,9 +183,10 @@ uint32_t Texture2D::id() {
             return 0;
         }
 
-        bind();
+        glBindTexture(texture_type, TextureBase::id());
         glGenerateMipmap(texture_type);
         glBindTexture(texture_type, 0);
+        GlState::get().invalidate_textures();
 
         GL_CHECK_ERROR();
         delete image;
@@ -208,9 +210,30 @@ Texture2D::Texture2D(std::string name, const std::string& file, const TextureCre
 
     async_load_thread = std::thread([&, file] {
         std::lock_guard lock_guard(load_mutex);
-        STAT_ACTION("Load texture data [" + file + "]");
+        STAT_ACTION("Load texture data [{}]", file);
         finished_loading  = false;
         loading_image_ptr = new EZCOGL::GLImage(file, EZCOGL::Texture::flip_y_on_load);
         finished_loading  = true;
     });
 }
+
+void Texture2DArray::set_data(uint32_t w, uint32_t h, uint32_t layers, ImageFormat in_image_format) {
+    image_format    = in_image_format;
+    const auto tf   = EZCOGL::Texture::texture_formats[static_cast<int>(image_format)];
+    external_format = tf.first;
+    data_format     = tf.second;
+    image_width     = w;
+    image_height    = h;
+    image_depth     = layers;
+    GL_CHECK_ERROR();
+    glBindTexture(texture_type, TextureBase::id());
+    const int internal_format = parameters.srgb && image_format == ImageFormat::RGBA_U8 ? GL_SRGB8_ALPHA8 : static_cast<int>(image_format);
+    glTexImage3D(texture_type, 0, internal_format, w, h, layers, 0, external_format, data_format, nullptr);
+    glBindTexture(texture_type, 0);
+    GlState::get().invalidate_textures();
+    GL_CHECK_ERROR();
+}
+
+Texture2DArray::Texture2DArray(std::string name, const TextureCreateInfos& params)
+    : TextureBase(name, GL_TEXTURE_2D_ARRAY, params) {
+}
@@ -64,15 +64,16 @@ public:
     [[nodiscard]] virtual uint32_t depth() const { return image_depth; }
     [[nodiscard]] virtual uint32_t id() { return texture_id; }
     [[nodiscard]] ImageFormat      internal_format() const { return image_format; }
+    [[nodiscard]] bool             is_layered() const { return texture_type == GL_TEXTURE_2D_ARRAY || texture_type == GL_TEXTURE_CUBE_MAP; }
     virtual void                   bind(uint32_t unit = 0);
 
     const std::string        name;
     const TextureCreateInfos parameters;
 protected:
     TextureBase(std::string name, int32_t in_texture_type, const TextureCreateInfos& params = {});
-    uint32_t    image_width;
-    uint32_t    image_height;
-    uint32_t    image_depth;
+    uint32_t    image_width  = 0;
+    uint32_t    image_height = 0;
+    uint32_t    image_depth  = 0;
     uint32_t    texture_id = 0;
     ImageFormat image_format;
     uint32_t    external_format;
@@ -105,3 +106,18 @@ protected:
     Texture2D(std::string name, const TextureCreateInfos& params = {});
     Texture2D(std::string name, const std::string& file, const TextureCreateInfos& params = {});
 };
+
+class Texture2DArray : public TextureBase {
+public:
+    static std::shared_ptr<Texture2DArray> create(const std::string& name, const TextureCreateInfos& params = {}) {
+        return std::shared_ptr<Texture2DArray>(new Texture2DArray(name, params));
+    }
+
+    /**
+     * \brief Allocate storage for all layers (content is undefined). RGBA_U8 layers are stored as sRGB if parameters.srgb is set.
+     */
+    void set_data(uint32_t w, uint32_t h, uint32_t layers, ImageFormat image_format);
+
+protected:
+    Texture2DArray(std::string name, const TextureCreateInfos& params = {});
+};
@@ -0,0 +1,110 @@
+#include "texture_readback.h"
+
+#include "texture_image.h"
+#include "utils/gl_tools.h"
+
+#include <GL/gl3w.h>
+#include <algorithm>
+#include <cstring>
+
+TextureReadback::TextureReadback(std::string in_name, size_t ring_size) : name(std::move(in_name)) {
+    slots.resize(std::max(ring_size, static_cast<size_t>(1)));
+}
+
+TextureReadback::~TextureReadback() {
+    for (auto& slot : slots) {
+        if (slot.fence)
+            glDeleteSync(static_cast<GLsync>(slot.fence));
+        if (slot.pbo_id) {
+            glUnmapNamedBuffer(slot.pbo_id);
+            glDeleteBuffers(1, &slot.pbo_id);
+        }
+    }
+}
+
+void TextureReadback::reserve_slot(Slot& slot, size_t size) {
+    if (slot.capacity >= size)
+        return;
+
+    if (slot.pbo_id) {
+        glUnmapNamedBuffer(slot.pbo_id);
+        glDeleteBuffers(1, &slot.pbo_id);
+    }
+
+    constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glCreateBuffers(1, &slot.pbo_id);
+    glNamedBufferStorage(slot.pbo_id, static_cast<GLsizeiptr>(size), nullptr, flags);
+    slot.mapped   = glMapNamedBufferRange(slot.pbo_id, 0, static_cast<GLsizeiptr>(size), flags);
+    slot.capacity = size;
+    GL_CHECK_ERROR();
+}
+
+uint64_t TextureReadback::request(const std::shared_ptr<TextureBase>& texture, uint32_t external_format, uint32_t data_type, size_t bytes_per_pixel, uint32_t layer) {
+    stats.requested++;
+    if (pending_count == slots.size() || !texture || texture->id() == 0 || (texture->is_layered() && layer >= texture->depth())) {
+        stats.dropped++;
+        return 0;
+    }
+
+    auto&        slot = slots[(first_pending + pending_count) % slots.size()];
+    const size_t size = static_cast<size_t>(texture->width()) * texture->height() * bytes_per_pixel;
+    reserve_slot(slot, size);
+
+    // Make previous image stores (compute shaders) visible to the pixel transfer
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, slot.pbo_id);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    if (texture->is_layered())
+        glGetTextureSubImage(texture->id(), 0, 0, 0, static_cast<GLint>(layer), static_cast<GLsizei>(texture->width()), static_cast<GLsizei>(texture->height()), 1, external_format,
+                             data_type, static_cast<GLsizei>(size), nullptr);
+    else
+        glGetTextureImage(texture->id(), 0, external_format, data_type, static_cast<GLsizei>(size), nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    slot.fence      = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot.size       = size;
+    slot.width      = texture->width();
+    slot.height     = texture->height();
+    slot.ticket     = next_ticket++;
+    slot.frame      = frame_index;
+    slot.issue_time = std::chrono::steady_clock::now();
+    pending_count++;
+    GL_CHECK_ERROR();
+    return slot.ticket;
+}
+
+uint64_t TextureReadback::poll() {
+    frame_index++;
+    uint64_t    last_ticket = 0;
+    const Slot* last_slot   = nullptr;
+    // Transfers complete in submission order : stop at the first one that is still running
+    while (pending_count > 0) {
+        auto&        slot   = slots[first_pending];
+        const GLenum status = glClientWaitSync(static_cast<GLsync>(slot.fence), GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(static_cast<GLsync>(slot.fence));
+        slot.fence = nullptr;
+
+        last_slot   = &slot;
+        last_ticket = slot.ticket;
+
+        stats.completed++;
+        stats.bytes_transferred += slot.size;
+        stats.last_latency_ms     = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - slot.issue_time).count();
+        stats.last_latency_frames = static_cast<uint32_t>(frame_index - slot.frame);
+
+        first_pending = (first_pending + 1) % slots.size();
+        pending_count--;
+    }
+
+    // Only the most recent result is kept. The slot can't be overwritten before the next request().
+    if (last_slot) {
+        data.resize(last_slot->size);
+        std::memcpy(data.data(), last_slot->mapped, last_slot->size);
+        data_width  = last_slot->width;
+        data_height = last_slot->height;
+    }
+    return last_ticket;
+}
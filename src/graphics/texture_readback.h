@@ -0,0 +1,83 @@
+#pragma once
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TextureBase;
+
+/**
+ * \brief Asynchronous GPU -> CPU texture transfer.
+ * Textures are copied into a bounded ring of persistently mapped pixel buffers, each guarded by a fence.
+ * Results are consumed a few frames later from poll(), which never blocks.
+ */
+class TextureReadback {
+public:
+    ~TextureReadback();
+
+    static std::shared_ptr<TextureReadback> create(const std::string& name, size_t ring_size = 3) {
+        return std::shared_ptr<TextureReadback>(new TextureReadback(name, ring_size));
+    }
+
+    /**
+     * \brief Enqueue a copy of the texture's first mip level.
+     * \param external_format, data_type pixel layout of the read data (ex : GL_RED / GL_FLOAT to only retrieve the first channel)
+     * \param bytes_per_pixel size of one pixel in the given layout
+     * \param layer layer to copy for array textures (ignored otherwise)
+     * \return ticket identifying this request, or 0 if the ring is full (nothing was enqueued)
+     */
+    uint64_t request(const std::shared_ptr<TextureBase>& texture, uint32_t external_format, uint32_t data_type, size_t bytes_per_pixel, uint32_t layer = 0);
+
+    /**
+     * \brief Retrieve the oldest finished transfers. Should be called once per frame.
+     * \return ticket of the most recent completed request, or 0 if nothing completed since the last call
+     */
+    uint64_t poll();
+
+    [[nodiscard]] const std::vector<uint8_t>& get_data() const { return data; }
+    [[nodiscard]] uint32_t                    width() const { return data_width; }
+    [[nodiscard]] uint32_t                    height() const { return data_height; }
+    [[nodiscard]] size_t                      in_flight() const { return pending_count; }
+    [[nodiscard]] size_t                      capacity() const { return slots.size(); }
+
+    struct Stats {
+        uint64_t requested           = 0;
+        uint64_t completed           = 0;
+        uint64_t dropped             = 0; // Requests refused because the ring was full
+        uint64_t bytes_transferred   = 0;
+        double   last_latency_ms     = 0;
+        uint32_t last_latency_frames = 0;
+    };
+
+    [[nodiscard]] const Stats& get_stats() const { return stats; }
+
+    const std::string name;
+
+private:
+    TextureReadback(std::string name, size_t ring_size);
+
+    struct Slot {
+        uint32_t                              pbo_id    = 0;
+        void*                                 mapped    = nullptr;
+        size_t                                capacity  = 0;
+        size_t                                size      = 0;
+        uint32_t                              width     = 0;
+        uint32_t                              height    = 0;
+        void*                                 fence     = nullptr;
+        uint64_t                              ticket    = 0;
+        uint64_t                              frame     = 0;
+        std::chrono::steady_clock::time_point issue_time;
+    };
+
+    void reserve_slot(Slot& slot, size_t size);
+
+    std::vector<Slot>    slots;
+    size_t               first_pending = 0;
+    size_t               pending_count = 0;
+    uint64_t             next_ticket   = 1;
+    uint64_t             frame_index   = 0;
+    std::vector<uint8_t> data;
+    uint32_t             data_width    = 0;
+    uint32_t             data_height   = 0;
+    Stats                stats;
+};
@@ -1,5 +1,6 @@
 #include "default_camera_controller.h"
 #include "renderer_setup.h"
+#include "scene_setup.h"
 #include "engine/asset_manager.h"
 #include "engine/engine.h"
 #include "engine/renderer.h"
@@ -12,14 +13,24 @@
 #include "ui/session_frontend.h"
 #include "ui/viewport.h"
 #include "ui/world_outliner.h"
+#include "utils/frame_stats.h"
 #include "utils/game_settings.h"
 #include "utils/profiler.h"
+#include "utils/trace_capture.h"
 #include "world/planet.h"
-#include "world/planet_ocean.h"
 #include "world/world.h"
 
-int main() {
-    std::unique_ptr<ActionRecord> main_initialization = std::make_unique<ActionRecord>("main initialization");
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; ++i)
+        if (std::string(argv[i]) == "--headless")
+            GameSettings::get().headless = true;
+
+    // A headless run only exists to be profiled
+    auto trace_settings = TraceCapture::settings_from_command_line(argc, argv);
+    if (!trace_settings && GameSettings::get().headless)
+        trace_settings = TraceCaptureSettings{};
+
+    std::unique_ptr<StatRecord> main_initialization = std::make_unique<StatRecord>(StatType::Action, "main initialization");
     Engine::get().get_renderer().set_icon("resources/textures/icon.png");
 
     const auto main_camera = std::make_shared<Camera>();
@@ -33,25 +44,7 @@ int main() {
     ImGuiWindow::create_window<SessionFrontend>();
     ImGuiWindow::create_window<WorldOutliner>(&Engine::get().get_world());
 
-    // Create planet
-    const auto earth = Planet::create("earth", main_camera);
-    Engine::get().get_world().get_scene_root().add_child(earth);
-    earth->set_radius(600000);
-    earth->set_max_lods(15);
-    earth->set_cell_count(30);
-    earth->set_rotation_speed(0);
-
-    const auto earth_ocean = std::make_shared<PlanetOcean>(earth);
-    earth->add_child(earth_ocean);
-
-    const auto moon = Planet::create("moon", main_camera);
-    Engine::get().get_world().get_scene_root().add_child(moon);
-    moon->set_radius(170000);
-    moon->set_max_lods(14);
-    moon->set_cell_count(30);
-    moon->set_orbit_distance(3000000.f);
-    moon->set_orbit_speed(0.02f);
-    moon->set_rotation_speed(0.05f);
+    const auto earth = setup_scene(main_camera);
 
     // Create camera controller
     const auto camera_controller = std::make_shared<DefaultCameraController>();
@@ -59,8 +52,17 @@ int main() {
     camera_controller->teleport_to({0, 0, earth->get_radius() + 2});
     earth->add_child(camera_controller);
 
+    // Every shader is compiled in parallel instead of on first use
+    Engine::get().get_asset_manager().compile_programs();
+
     main_initialization = nullptr;
+    if (trace_settings)
+        TraceCapture::get().start(*trace_settings);
+
     while (!Engine::get().get_renderer().should_close()) {
+        if (GameSettings::get().headless && TraceCapture::get().completed_captures() > 0)
+            break;
+
         Engine::get().get_asset_manager().refresh_dirty_assets();
         {
             STAT_FRAME("Game_loop");
@@ -70,7 +72,7 @@ int main() {
             Engine::get().get_world().tick_world();
 
             // Rendering
-            if (GameSettings::get().fullscreen)
+            if (GameSettings::get().fullscreen || GameSettings::get().headless)
                 framegraph->render(true, Engine::get().get_renderer().window_width(), Engine::get().get_renderer().window_height());
             else
                 framegraph->render(false, viewport->width(), viewport->height());
@@ -82,4 +84,6 @@ int main() {
         }
         Profiler::get().new_frame();
     }
+
+    FrameStats::get().write("frame_stats.json");
 }
@@ -9,9 +9,13 @@
 #include "graphics/texture_image.h"
 #include "graphics/framegraph.h"
 #include "utils/game_settings.h"
+#include "world/atmosphere.h"
 #include "world/planet.h"
 #include "world/world.h"
 
+#include <algorithm>
+#include <cmath>
+
 std::shared_ptr<FrameGraph> setup_renderer(const std::shared_ptr<Camera>& main_camera) {
 
     /*
@@ -49,12 +53,61 @@ std::shared_ptr<FrameGraph> setup_renderer(const std::shared_ptr<Camera>& main_c
     translucency_combine->add_attachment("Translucency_depth", ImageFormat::R_F32, {.filtering_min = TextureMinFilter::Nearest});
     translucency_combine->link_dependency(g_buffer_pass, {"Scene_color", "Scene_normal", "Scene_mrao", "Scene_depth"});
     translucency_combine->link_dependency(translucency, {"Translucency_color", "Translucency_normal", "Translucency_mrao", "Translucency_depth"});
+    translucency_combine->on_select_permutation([] {
+        return ShaderDefines{{"SHADING", std::to_string(static_cast<int>(GameSettings::get().shading))}};
+    });
     translucency_combine->on_bind_material.add_lambda([main_camera](std::shared_ptr<Material> material) {
         material->set_float("z_near", static_cast<float>(main_camera->z_near()));
-        material->set_int("shading", static_cast<int>(GameSettings::get().shading));
         material->set_vec3("sun_direction", Eigen::Vector3f((GameSettings::get().sun_direction * Eigen::Vector3d(1, 0, 0)).cast<float>()));
     });
 
+    /*
+     * LOW RESOLUTION EFFECTS
+     */
+    const auto effect_resolution = [](uint32_t& x, uint32_t& y) {
+        const auto divisor = static_cast<uint32_t>(GameSettings::get().effect_resolution);
+        x                  = std::max(1u, x / divisor);
+        y                  = std::max(1u, y / divisor);
+    };
+
+    const auto atmosphere = PostProcessPass::create("Atmosphere", 1, 1, "resources/shaders/post_process/atmosphere.fs");
+    atmosphere->link_dependency(translucency_combine, {"Translucency_color", "Translucency_normal", "Translucency_mrao", "Translucency_depth"});
+    atmosphere->on_compute_resolution(effect_resolution);
+    // Scatter loops are unrolled at compile time : each quality level is a permutation
+    atmosphere->on_select_permutation([] {
+        return ShaderDefines{
+            {"ATMOSPHERE_ENABLED", GameSettings::get().enable_atmosphere ? "1" : "0"},
+            {"ATMOSPHERE_QUALITY", std::to_string(GameSettings::get().atmosphere_quality)},
+        };
+    });
+    const auto atmosphere_uniforms = std::make_shared<Atmosphere::Uniforms>(*atmosphere->material());
+    atmosphere->on_bind_material.add_lambda([main_camera, atmosphere_uniforms](std::shared_ptr<Material> material) {
+        material->set_float("z_near", static_cast<float>(main_camera->z_near()));
+        material->set_vec3("sun_direction", Eigen::Vector3f((GameSettings::get().sun_direction * Eigen::Vector3d(1, 0, 0)).cast<float>()));
+        Atmosphere::bind_visible(*atmosphere_uniforms, *main_camera);
+    });
+
+    const auto reflections = PostProcessPass::create("Screen_space_reflections", 1, 1, "resources/shaders/post_process/screen_space_reflections.fs");
+    reflections->add_attachment("Visibility", ImageFormat::R_F16, {.filtering_min = TextureMinFilter::Nearest});
+    reflections->link_dependency(translucency_combine, {"Input_color", "Input_normal", "Input_mrao", "Input_Depth"});
+    reflections->on_compute_resolution(effect_resolution);
+    // Ray march bound : 500 * (quality + 0.1) iterations. The quality is rounded to tenths to limit the number of permutations.
+    reflections->on_select_permutation([] {
+        const float quality = std::round(std::clamp(GameSettings::get().ssr_quality, 0.f, 1.f) * 10) / 10;
+        return ShaderDefines{{"SSR_MAX_ITERATIONS", std::to_string(static_cast<int>(500 * (quality + 0.1f)))}};
+    });
+    reflections->on_bind_material.add_lambda([](std::shared_ptr<Material> material) {
+        material->set_int("enabled", GameSettings::get().screen_space_reflections ? 1 : 0);
+        material->set_float("resolution", GameSettings::get().ssr_quality);
+    });
+
+    // Back to full resolution, without bleeding across depth discontinuities
+    const auto effect_upsample = PostProcessPass::create("Effect_upsample", 1, 1, "resources/shaders/post_process/bilateral_upsample.fs");
+    effect_upsample->add_attachment("Reflection", ImageFormat::RGBA_F16, {.filtering_min = TextureMinFilter::Nearest});
+    effect_upsample->link_dependency(translucency_combine, {"Combined_color", "Combined_normal", "Combined_mrao", "Scene_depth"});
+    effect_upsample->link_dependency(atmosphere, {"Atmosphere_color"});
+    effect_upsample->link_dependency(reflections, {"Reflection_color", "Reflection_visibility"});
+
     /*
      * LIGHTING
      */
@@ -66,11 +119,9 @@ std::shared_ptr<FrameGraph> setup_renderer(const std::shared_ptr<Camera>& main_c
     const auto lighting = PostProcessPass::create("lighting", 1, 1, "resources/shaders/post_process/lighting.fs");
     lighting->link_dependency(g_buffer_pass, {"Scene_color", "Scene_normal", "Scene_mrao", "Scene_depth"});
     lighting->link_dependency(translucency_combine, {"Translucency_color", "Translucency_normal","Translucency_mrao", "Translucency_depth"});
+    lighting->link_dependency(effect_upsample, {"Atmosphere_light", "Input_SSR_Color"});
     lighting->on_bind_material.add_lambda([cubemap, main_camera](std::shared_ptr<Material> material) {
         material->set_float("z_near", static_cast<float>(main_camera->z_near()));
-        material->set_int("enable_atmosphere", GameSettings::get().enable_atmosphere ? 1 : 0);
-        material->set_int("atmosphere_quality", GameSettings::get().atmosphere_quality);
-        material->set_int("shading", static_cast<int>(GameSettings::get().shading));
         material->set_texture("WORLD_Cubemap", cubemap);
         material->set_vec3("sun_direction", Eigen::Vector3f((GameSettings::get().sun_direction * Eigen::Vector3d(1, 0, 0)).cast<float>()));
     });
@@ -0,0 +1,30 @@
+#include "scene_setup.h"
+
+#include "engine/engine.h"
+#include "graphics/camera.h"
+#include "world/planet.h"
+#include "world/planet_ocean.h"
+#include "world/world.h"
+
+std::shared_ptr<Planet> setup_scene(const std::shared_ptr<Camera>& main_camera) {
+    const auto earth = Planet::create("earth", main_camera);
+    Engine::get().get_world().get_scene_root().add_child(earth);
+    earth->set_radius(600000);
+    earth->set_max_lods(15);
+    earth->set_cell_count(30);
+    earth->set_rotation_speed(0);
+
+    const auto earth_ocean = std::make_shared<PlanetOcean>(earth);
+    earth->add_child(earth_ocean);
+
+    const auto moon = Planet::create("moon", main_camera);
+    Engine::get().get_world().get_scene_root().add_child(moon);
+    moon->set_radius(170000);
+    moon->set_max_lods(14);
+    moon->set_cell_count(30);
+    moon->set_orbit_distance(3000000.f);
+    moon->set_orbit_speed(0.02f);
+    moon->set_rotation_speed(0.05f);
+
+    return earth;
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <memory>
+
+class Camera;
+class Planet;
+
+/**
+ * \brief Add the default planets (earth with its ocean, and the moon) to the world. Return the earth.
+ */
+std::shared_ptr<Planet> setup_scene(const std::shared_ptr<Camera>& main_camera);
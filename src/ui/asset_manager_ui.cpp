@@ -1,5 +1,6 @@
 #include "asset_manager_ui.h"
 
+#include <chrono>
 #include <filesystem>
 
 #include "engine/asset_manager.h"
@@ -103,6 +104,52 @@ void display_file_hierarchy(const ShaderSource& source) {
     }
 }
 
+/**
+ * \brief Micro-benchmark of uniform location lookups : by name (Material::set_*()) versus cached UniformHandle, over every active uniform of every material.
+ * Only the lookups are measured : both paths issue the same glUniform call afterward.
+ */
+static void uniform_lookup_benchmark() {
+    static int     iterations       = 10000;
+    static double  string_lookup_ns = 0;
+    static double  handle_lookup_ns = 0;
+    static size_t  uniform_count    = 0;
+    static int64_t checksum         = 0; // Keeps the lookups from being optimized out
+
+    ImGui::SliderInt("iterations", &iterations, 100, 100000);
+    ImGui::SameLine();
+    if (ImGui::Button("Benchmark uniform lookups")) {
+        std::vector<std::pair<const Material*, std::string>> names;
+        std::vector<UniformHandle<int>>                      handles;
+        for (const auto& material : Engine::get().get_asset_manager().get_materials())
+            for (const auto& binding : material->get_bindings()) {
+                names.emplace_back(material, binding.first);
+                handles.emplace_back(material->uniform<int>(binding.first));
+            }
+        uniform_count = names.size();
+        checksum      = 0;
+
+        // Draw code passes string literals : a std::string is constructed for each call
+        auto begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+            for (const auto& [material, name] : names)
+                checksum += material->binding(name.c_str());
+        const auto string_duration = std::chrono::steady_clock::now() - begin;
+
+        begin = std::chrono::steady_clock::now();
+        for (int i = 0; i < iterations; ++i)
+            for (const auto& handle : handles)
+                checksum += handle.location();
+        const auto handle_duration = std::chrono::steady_clock::now() - begin;
+
+        const double lookups = static_cast<double>(std::max(uniform_count, static_cast<size_t>(1))) * iterations;
+        string_lookup_ns     = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(string_duration).count()) / lookups;
+        handle_lookup_ns     = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(handle_duration).count()) / lookups;
+    }
+    if (uniform_count > 0)
+        ImGui::Text("%d uniforms : by name = %.2f ns, handle = %.2f ns (x%.1f)", static_cast<int>(uniform_count), string_lookup_ns, handle_lookup_ns,
+                    handle_lookup_ns > 0 ? string_lookup_ns / handle_lookup_ns : 0.0);
+}
+
 static void material_manager() {
     size_t      unique_id   = 0;
     const float total_width = ImGui::GetContentRegionAvail().x;
@@ -236,6 +283,9 @@ static void material_manager() {
         }
         ImGui::EndGroup();
     }
+
+    ImGui::Separator();
+    uniform_lookup_benchmark();
 }
 
 static void texture_manager() {
@@ -2,9 +2,12 @@
 
 #include "widgets.h"
 #include "graphics/framegraph.h"
+#include "graphics/gpu_timer.h"
+#include "graphics/post_process_pass.h"
 #include "graphics/render_pass.h"
 #include "graphics/texture_image.h"
 
+#include <ranges>
 #include <imgui.h>
 #include <GLFW/glfw3.h>
 
@@ -50,6 +53,18 @@ static const char* shading_to_string(Shading shading) {
     return nullptr;
 }
 
+static const char* effect_resolution_to_string(EffectResolution resolution) {
+    switch (resolution) {
+    case EffectResolution::Full:
+        return "Full";
+    case EffectResolution::Half:
+        return "Half";
+    case EffectResolution::Quarter:
+        return "Quarter";
+    }
+    return nullptr;
+}
+
 void GraphicDebugger::draw() {
     if (ImGui::BeginTabBar("GraphicSettingsTab")) {
         if (ImGui::BeginTabItem("Framegraph visualizer")) {
@@ -144,6 +159,42 @@ void GraphicDebugger::draw() {
             ImGui::Checkbox("Enable SSR", &GameSettings::get().screen_space_reflections);
             ImGui::SliderFloat("SSR quality", &GameSettings::get().ssr_quality, 0, 1);
 
+            // Atmosphere and reflections
+            if (ImGui::BeginCombo("effect resolution", effect_resolution_to_string(GameSettings::get().effect_resolution))) {
+                for (const auto resolution : {EffectResolution::Full, EffectResolution::Half, EffectResolution::Quarter})
+                    if (ImGui::MenuItem(effect_resolution_to_string(resolution)) && GameSettings::get().effect_resolution != resolution) {
+                        GameSettings::get().effect_resolution = resolution;
+                        for (const auto& item : FrameGraph::registry())
+                            item->invalidate_resolution();
+                    }
+                ImGui::EndCombo();
+            }
+
+            // GPU time of each shader permutation, to compare quality settings
+            ImGui::Separator();
+            ImGui::Text("Post process GPU time");
+            if (ImGui::BeginTable("Permutation timers", 3)) {
+                ImGui::TableSetupColumn("permutation");
+                ImGui::TableSetupColumn("last");
+                ImGui::TableSetupColumn("average");
+                ImGui::TableHeadersRow();
+                for (const auto& render_pass : node_map | std::views::keys) {
+                    const auto post_process = std::dynamic_pointer_cast<PostProcessPass>(render_pass);
+                    if (!post_process)
+                        continue;
+                    for (const auto& timer : post_process->get_gpu_timers() | std::views::values) {
+                        ImGui::TableNextRow();
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%s", timer->name.c_str());
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f ms", timer->last_ms());
+                        ImGui::TableNextColumn();
+                        ImGui::Text("%.3f ms", timer->average_ms());
+                    }
+                }
+                ImGui::EndTable();
+            }
+
             ImGui::EndTabItem();
         }
         ImGui::EndTabBar();
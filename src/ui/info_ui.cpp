@@ -3,6 +3,9 @@
 #include <imgui.h>
 #include <GL/gl3w.h>
 
+#include <graphics/buffer_arena.h>
+#include <graphics/gl_state.h>
+#include <graphics/program_cache.h>
 #include <utils/gl_tools.h>
 
 #define GL_GPU_MEM_INFO_TOTAL_AVAILABLE_MEM_NVX    0x9048
@@ -37,6 +40,21 @@ void InfoUi::draw() {
         ImGui::Text("memory information unavailable");
     GL_CHECK_ERROR();
 
+    const auto& arena_stats = BufferArena::get().get_stats();
+    ImGui::Text("frame buffer arena : %d allocations, %d Ko / %d Ko, %d stalls", static_cast<int>(arena_stats.allocation_count),
+                static_cast<int>(arena_stats.frame_bytes / 1024), static_cast<int>(BufferArena::get().capacity() / 1024), static_cast<int>(arena_stats.stall_count));
+
+    const auto& state_stats = GlState::get().get_stats();
+    ImGui::Text("GL state changes : %d issued, %d skipped", static_cast<int>(state_stats.issued), static_cast<int>(state_stats.skipped));
+
+    const auto& program_stats = ProgramCache::get().get_stats();
+    if (program_stats.startup_milliseconds >= 0)
+        ImGui::Text("shader programs : %s startup in %.1f ms, %d loaded from cache, %d compiled%s", program_stats.warm_startup ? "warm" : "cold", program_stats.startup_milliseconds,
+                    static_cast<int>(program_stats.cache_hits), static_cast<int>(program_stats.cache_misses),
+                    ProgramCache::get().is_parallel_compile_supported() ? " (parallel)" : "");
+    else
+        ImGui::Text("shader programs : compiling...");
+
     ImGui::Separator();
 
     ImGui::Text("Extensions");
@@ -1,10 +1,15 @@
 #include "session_frontend.h"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
 #include <imgui.h>
 
 #include "world/world.h"
 #include "engine/engine.h"
+#include "utils/frame_stats.h"
 #include "utils/profiler.h"
+#include "utils/trace_capture.h"
 
 
 SessionFrontend::SessionFrontend()
@@ -59,7 +64,7 @@ static void compute_record_data(ui::RecordData& output, int level, std::vector<R
 		TimeType last_start = it->start;
 		TimeType last_end = it->end;
 		output.get_line(level).emplace_back(ui::RecordData::RecordItem{
-			.name = it->name, .start = local_min, .end = local_max
+			.name = it->name(), .start = local_min, .end = local_max
 		});
 		++it;
 		if (it != records.end() && it->start > last_start && it->start < last_end)
@@ -98,15 +103,30 @@ void SessionFrontend::draw()
 	STAT_FRAME("Session Frontend Update");
 
 	// Enable or disable profiler
-	ImGui::Checkbox("Enable profiler", &Profiler::get().enabled);
+	bool enabled = Profiler::is_enabled();
+	if (ImGui::Checkbox("Enable profiler", &enabled))
+		Profiler::set_enabled(enabled);
 
 	// Profiler need to be enabled to display recorded data
-	if (!Profiler::get().enabled)
+	if (!enabled)
 	{
 		record_first_frame = 5;
 		return;
 	}
 
+	// Export the next frames as a Chrome trace (F2)
+	if (TraceCapture::get().is_capturing())
+		ImGui::Text("Capturing trace... (%u frames)", TraceCapture::get().captured_frames());
+	else
+	{
+		ImGui::SetNextItemWidth(100);
+		ImGui::InputInt("##trace_frames", &trace_frames);
+		trace_frames = std::max(trace_frames, 1);
+		ImGui::SameLine();
+		if (ImGui::Button("Capture trace"))
+			TraceCapture::get().start({.frames = static_cast<uint32_t>(trace_frames)});
+	}
+
 	ImGui::Separator();
 
 	if (record_first_frame >= 0)
@@ -119,8 +139,28 @@ void SessionFrontend::draw()
 			ImGui::Separator();
 			// Update displayed record
 			if (ImGui::Button("refresh") || record_first_frame == 0)
+			{
 				frame_record = compute_record(Profiler::get().get_last_frame(), true);
-			frame_record.display();
+				frame_record.label = "CPU";
+				// GPU events are resolved a few frames late : both timelines start at their first event
+				gpu_frame_record = compute_record(Profiler::get().get_last_gpu_frame(), true);
+				gpu_frame_record.label = "GPU";
+				const float max = std::max(frame_record.max_display_value, gpu_frame_record.max_display_value);
+				frame_record.max_display_value = max;
+				gpu_frame_record.max_display_value = max;
+			}
+
+			if (frame_record.display())
+			{
+				gpu_frame_record.max_display_value = frame_record.max_display_value;
+				gpu_frame_record.min_display_value = frame_record.min_display_value;
+			}
+			ImGui::Separator();
+			if (gpu_frame_record.display())
+			{
+				frame_record.max_display_value = gpu_frame_record.max_display_value;
+				frame_record.min_display_value = gpu_frame_record.min_display_value;
+			}
 			ImGui::EndTabItem();
 		}
 		if (ImGui::BeginTabItem("Actions"))
@@ -151,6 +191,31 @@ void SessionFrontend::draw()
 			}
 			ImGui::EndTabItem();
 		}
+		if (ImGui::BeginTabItem("Counters"))
+		{
+			ImGui::Separator();
+			if (ImGui::BeginTable("Counters", 2))
+			{
+				ImGui::TableSetupColumn("name");
+				ImGui::TableSetupColumn("value");
+				ImGui::TableHeadersRow();
+				for (const auto& counter : Profiler::get().get_last_frame_counters())
+				{
+					ImGui::TableNextRow();
+					ImGui::TableNextColumn();
+					ImGui::Text("%s", counter.name);
+					ImGui::TableNextColumn();
+					ImGui::Text("%lld", static_cast<long long>(counter.value));
+				}
+				ImGui::EndTable();
+			}
+			ImGui::EndTabItem();
+		}
+		if (ImGui::BeginTabItem("Frame statistics"))
+		{
+			draw_frame_statistics();
+			ImGui::EndTabItem();
+		}
 		ImGui::EndTabBar();
 	}
 
@@ -160,3 +225,103 @@ void SessionFrontend::draw()
 	fps_graph.push_value(static_cast<float>(Engine::get().get_world().get_delta_seconds() * 1000.0));
 	fps_graph.display();
 }
+
+void SessionFrontend::draw_frame_statistics()
+{
+	auto& stats = FrameStats::get();
+	ImGui::SetNextItemWidth(100);
+	ImGui::DragFloat("Hitch ratio", &stats.hitch_ratio, 0.05f, 1.f, 10.f);
+	ImGui::SameLine();
+	ImGui::SetNextItemWidth(100);
+	ImGui::DragFloat("Min hitch (ms)", &stats.min_hitch_ms, 0.1f, 0.f, 100.f);
+
+	// Comma separated durations, applied when pressing enter (ImGui keeps its own copy of the text while it is edited)
+	char windows_buffer[128] = {};
+	size_t windows_length = 0;
+	for (const float seconds : stats.get_windows())
+	{
+		const int written = std::snprintf(windows_buffer + windows_length, sizeof(windows_buffer) - windows_length, windows_length == 0 ? "%g" : ", %g", seconds);
+		windows_length = std::min(sizeof(windows_buffer) - 1, windows_length + static_cast<size_t>(std::max(written, 0)));
+	}
+	ImGui::SetNextItemWidth(300);
+	if (ImGui::InputText("Windows (s)", windows_buffer, sizeof(windows_buffer), ImGuiInputTextFlags_EnterReturnsTrue))
+	{
+		std::vector<float> windows;
+		for (char* c = windows_buffer; *c;)
+		{
+			char* end = nullptr;
+			const float seconds = std::strtof(c, &end);
+			if (end == c)
+			{
+				c++;
+				continue;
+			}
+			windows.emplace_back(seconds);
+			c = end;
+		}
+		stats.set_windows(std::move(windows));
+	}
+
+	// Scope names include their arguments, as displayed in the frame events tab
+	ImGui::SetNextItemWidth(300);
+	ImGui::InputText("##tracked_scope", tracked_scope_name, sizeof(tracked_scope_name));
+	ImGui::SameLine();
+	if (ImGui::Button("Track scope") && tracked_scope_name[0] != '\0')
+	{
+		stats.track_scope(tracked_scope_name);
+		tracked_scope_name[0] = '\0';
+	}
+	for (const auto& scope : stats.get_tracked_scopes())
+	{
+		ImGui::PushID(scope.c_str());
+		if (ImGui::Button("Untrack"))
+		{
+			ImGui::PopID();
+			stats.untrack_scope(scope);
+			break;
+		}
+		ImGui::SameLine();
+		ImGui::Text("%s", scope.c_str());
+		ImGui::PopID();
+	}
+	ImGui::Separator();
+
+	if (ImGui::BeginTable("Frame statistics", 8))
+	{
+		ImGui::TableSetupColumn("name");
+		ImGui::TableSetupColumn("window");
+		ImGui::TableSetupColumn("p50 (ms)");
+		ImGui::TableSetupColumn("p95 (ms)");
+		ImGui::TableSetupColumn("p99 (ms)");
+		ImGui::TableSetupColumn("p99.9 (ms)");
+		ImGui::TableSetupColumn("max (ms)");
+		ImGui::TableSetupColumn("hitches");
+		ImGui::TableHeadersRow();
+		const auto draw_row = [](const std::string& name, const FrameStats::Window& window)
+		{
+			const auto summary = FrameStats::summarize(window);
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::Text("%s", name.c_str());
+			ImGui::TableNextColumn();
+			if (window.seconds > 0)
+				ImGui::Text("%.0f s", window.seconds);
+			else
+				ImGui::Text("session");
+			for (const double value : {summary.p50, summary.p95, summary.p99, summary.p999, summary.max})
+			{
+				ImGui::TableNextColumn();
+				ImGui::Text("%.2f", value);
+			}
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", static_cast<unsigned long long>(summary.hitches));
+		};
+		for (const auto& series : stats.get_series())
+		{
+			for (const auto& window : series.windows)
+				draw_row(series.name, window);
+			draw_row(series.name, series.session);
+		}
+		ImGui::EndTable();
+	}
+}
@@ -15,12 +15,17 @@ public:
 
 	void draw() override;
 private:
+	void draw_frame_statistics();
+
 	std::vector<Record> last_frame;
 	ui::RecordData frame_record;
+	ui::RecordData gpu_frame_record;
 	ui::RecordData action_record_main_thread;
 	ui::RecordData action_record_other_threads;
 
 	int record_first_frame = 5;
+	int trace_frames = 300;
+	char tracked_scope_name[128] = {};
 	
 	ui::GraphData fps_graph;
 };
@@ -0,0 +1,195 @@
+#include "file_watcher.h"
+
+#include <algorithm>
+#include <iostream>
+#include <ranges>
+
+#if defined(__linux__)
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+static std::unique_ptr<FileWatcher> file_watcher_singleton = nullptr;
+
+FileWatcher& FileWatcher::get() {
+    if (!file_watcher_singleton)
+        file_watcher_singleton = std::unique_ptr<FileWatcher>(new FileWatcher());
+    return *file_watcher_singleton;
+}
+
+std::string FileWatcher::canonical_path(const std::string& path) {
+    std::error_code error;
+    const auto      canonical = std::filesystem::weakly_canonical(path, error);
+    return error ? path : canonical.generic_string();
+}
+
+FileWatcher::FileWatcher() {
+#if defined(__linux__)
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    stop_fd    = eventfd(0, EFD_CLOEXEC);
+    if (inotify_fd < 0 || stop_fd < 0) {
+        std::cerr << "failed to initialize inotify : hot reload is disabled" << std::endl;
+        return;
+    }
+#endif
+    thread = std::thread(&FileWatcher::watcher_thread, this);
+}
+
+FileWatcher::~FileWatcher() {
+#if defined(__linux__)
+    stopping = true;
+    if (stop_fd >= 0) {
+        const uint64_t value = 1;
+        (void)write(stop_fd, &value, sizeof(value));
+    }
+#else
+    {
+        std::lock_guard lock(watches_lock);
+        stopping = true;
+    }
+    stop_condition.notify_all();
+#endif
+    if (thread.joinable())
+        thread.join();
+#if defined(__linux__)
+    if (inotify_fd >= 0)
+        close(inotify_fd);
+    if (stop_fd >= 0)
+        close(stop_fd);
+#endif
+}
+
+Event_FileChanged& FileWatcher::watch(const std::string& path) {
+    const std::string key  = canonical_path(path);
+    auto&             file = files[key];
+    if (!file) {
+        file = std::make_unique<Event_FileChanged>();
+        add_watch(key);
+    }
+    return *file;
+}
+
+void FileWatcher::unwatch(const std::string& path, void* object) {
+    // Entries are kept : they are cheap, and the file is likely to be watched again
+    const auto file = files.find(canonical_path(path));
+    if (file != files.end())
+        file->second->clear_object(object);
+}
+
+void FileWatcher::dispatch_events() {
+    if (overflow.exchange(false)) {
+        while (changes.pop());
+        // Listeners may watch new files : don't iterate the map while executing them
+        std::vector<Event_FileChanged*> events;
+        for (const auto& file : files | std::views::values)
+            events.emplace_back(file.get());
+        for (const auto& event : events)
+            event->execute();
+        return;
+    }
+
+    // A single save usually produces several events
+    dispatched_paths.clear();
+    while (auto path = changes.pop())
+        if (std::ranges::find(dispatched_paths, *path) == dispatched_paths.end())
+            dispatched_paths.emplace_back(std::move(*path));
+
+    for (const auto& path : dispatched_paths) {
+        const auto file = files.find(path);
+        if (file != files.end())
+            file->second->execute();
+    }
+}
+
+void FileWatcher::push_change(std::string path) {
+    if (!changes.push(std::move(path)))
+        overflow = true;
+}
+
+#if defined(__linux__)
+
+void FileWatcher::add_watch(const std::string& path) {
+    if (inotify_fd < 0)
+        return;
+
+    // Editors often save by replacing the file : watch the directory rather than the inode of the file
+    const std::string directory = std::filesystem::path(path).parent_path().generic_string();
+    const int         watch     = inotify_add_watch(inotify_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch < 0) {
+        std::cerr << "failed to watch directory " << directory << std::endl;
+        return;
+    }
+    // inotify returns the same descriptor when the directory is already watched
+    std::lock_guard lock(watches_lock);
+    directory_watches[watch] = directory;
+}
+
+void FileWatcher::watcher_thread() {
+    alignas(inotify_event) char buffer[4096];
+    pollfd                      fds[2] = {{inotify_fd, POLLIN, 0}, {stop_fd, POLLIN, 0}};
+
+    while (!stopping) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        if (fds[1].revents & POLLIN)
+            return;
+
+        const ssize_t length = read(inotify_fd, buffer, sizeof(buffer));
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+            if (event->mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            if (event->len == 0)
+                continue;
+
+            std::string path;
+            {
+                std::lock_guard lock(watches_lock);
+                const auto      directory = directory_watches.find(event->wd);
+                if (directory == directory_watches.end())
+                    continue;
+                path = directory->second + "/" + event->name;
+            }
+            push_change(std::move(path));
+        }
+    }
+}
+
+#else
+
+void FileWatcher::add_watch(const std::string& path) {
+    std::error_code error;
+    const auto      time = std::filesystem::last_write_time(path, error);
+    std::lock_guard lock(watches_lock);
+    polled_files.emplace_back(path, error ? std::filesystem::file_time_type() : time);
+}
+
+void FileWatcher::watcher_thread() {
+    // No inotify : poll timestamps, but still off the main thread
+    std::unique_lock lock(watches_lock);
+    while (!stopping) {
+        stop_condition.wait_for(lock, std::chrono::milliseconds(250));
+        if (stopping)
+            return;
+        for (auto& [path, last_write_time] : polled_files) {
+            std::error_code error;
+            const auto      time = std::filesystem::last_write_time(path, error);
+            if (!error && time != last_write_time) {
+                last_write_time = time;
+                push_change(path);
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "event_manager.h"
+#include "spsc_queue.h"
+
+DECLARE_DELEGATE_MULTICAST(Event_FileChanged);
+
+/**
+ * \brief Notify modifications of files on disk.
+ * Changes are detected by a background thread (inotify on linux, timestamp polling elsewhere) and queued until dispatch_events() is called on the main thread.
+ */
+class FileWatcher {
+public:
+    ~FileWatcher();
+
+    static FileWatcher& get();
+
+    /**
+     * \brief Start watching a file. Listeners of the returned event are called from dispatch_events() each time the file is written.
+     */
+    Event_FileChanged& watch(const std::string& path);
+
+    /**
+     * \brief Remove every listener bound to the given object
+     */
+    void unwatch(const std::string& path, void* object);
+
+    /**
+     * \brief Execute the events of the files modified since the last call. Doesn't make any system call when nothing changed.
+     */
+    void dispatch_events();
+
+    /**
+     * \brief Path used to identify a file : two paths to the same file have the same key
+     */
+    [[nodiscard]] static std::string canonical_path(const std::string& path);
+
+private:
+    FileWatcher();
+
+    void add_watch(const std::string& path);
+    void watcher_thread();
+    void push_change(std::string path);
+
+    std::unordered_map<std::string, std::unique_ptr<Event_FileChanged>> files;
+
+    // Written by the watcher thread, read by the main thread
+    SpscQueue<std::string, 256> changes;
+    std::atomic_bool            overflow = false; // Some changes were lost : every file is considered modified
+    std::vector<std::string>    dispatched_paths;
+
+    // Watches shared with the watcher thread
+    std::mutex watches_lock;
+#if defined(__linux__)
+    std::unordered_map<int, std::string> directory_watches; // inotify watch descriptor -> directory
+    int                                  inotify_fd = -1;
+    int                                  stop_fd    = -1;
+#else
+    std::vector<std::pair<std::string, std::filesystem::file_time_type>> polled_files;
+    std::condition_variable                                              stop_condition;
+#endif
+
+    std::atomic_bool stopping = false;
+    std::thread      thread;
+};
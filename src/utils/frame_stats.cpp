@@ -0,0 +1,188 @@
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+#include "json.h"
+
+static std::unique_ptr<FrameStats> frame_stats_singleton = nullptr;
+
+size_t DurationHistogram::bucket_index(uint64_t value) {
+    if (value < sub_bucket_count)
+        return value;
+    // value >> magnitude is in [sub_bucket_count, 2 * sub_bucket_count[
+    const int magnitude = std::bit_width(value) - 1 - sub_bucket_bits;
+    if (magnitude >= max_magnitude)
+        return (max_magnitude + 1) * sub_bucket_count - 1;
+    return (magnitude + 1) * sub_bucket_count + ((value >> magnitude) - sub_bucket_count);
+}
+
+uint64_t DurationHistogram::bucket_upper_bound(size_t index) {
+    if (index < sub_bucket_count)
+        return index;
+    const size_t   magnitude  = index / sub_bucket_count - 1;
+    const uint64_t sub_bucket = index % sub_bucket_count + sub_bucket_count;
+    return ((sub_bucket + 1) << magnitude) - 1;
+}
+
+void DurationHistogram::add(uint64_t microseconds) {
+    counts[bucket_index(microseconds)]++;
+    total++;
+}
+
+void DurationHistogram::remove(uint64_t microseconds) {
+    counts[bucket_index(microseconds)]--;
+    total--;
+}
+
+uint64_t DurationHistogram::percentile(double percentile) const {
+    if (total == 0)
+        return 0;
+    const uint64_t target     = std::max(uint64_t(1), static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total))));
+    uint64_t       cumulative = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        cumulative += counts[i];
+        if (cumulative >= target)
+            return bucket_upper_bound(i);
+    }
+    return bucket_upper_bound(counts.size() - 1);
+}
+
+void FrameStats::Window::add(const Sample& sample) {
+    // Evict the samples that left the window
+    if (seconds > 0) {
+        const auto oldest = sample.time - std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(seconds));
+        while (!samples.empty() && samples.front().time < oldest) {
+            histogram.remove(samples.front().microseconds);
+            hitches -= samples.front().hitch;
+            samples.pop_front();
+        }
+        samples.emplace_back(sample);
+    }
+    histogram.add(sample.microseconds);
+    hitches += sample.hitch;
+}
+
+FrameStats& FrameStats::get() {
+    if (!frame_stats_singleton)
+        frame_stats_singleton = std::unique_ptr<FrameStats>(new FrameStats());
+    return *frame_stats_singleton;
+}
+
+void FrameStats::set_windows(std::vector<float> window_seconds) {
+    std::erase_if(window_seconds, [](float seconds) { return seconds <= 0; });
+    windows = std::move(window_seconds);
+
+    // Refill the windows of the existing series with the samples retained by their longest window
+    for (auto& item : series) {
+        std::deque<Window::Sample> retained;
+        if (const auto longest = std::ranges::max_element(item.windows, {}, &Window::seconds); longest != item.windows.end())
+            retained = std::move(longest->samples);
+        item.windows.clear();
+        for (const float seconds : windows)
+            item.windows.emplace_back().seconds = seconds;
+        for (const auto& sample : retained)
+            for (auto& window : item.windows)
+                window.add(sample);
+    }
+}
+
+void FrameStats::add_sample(const std::string& name, double seconds) {
+    auto it = std::ranges::find_if(series, [&](const Series& item) { return item.name == name; });
+    if (it == series.end()) {
+        it       = series.emplace(series.end());
+        it->name = name;
+        for (const float seconds : windows)
+            it->windows.emplace_back().seconds = seconds;
+    }
+
+    // Compare with the median of the longest window, before adding the new sample
+    const auto    longest   = std::ranges::max_element(it->windows, {}, &Window::seconds);
+    const Window& reference = longest != it->windows.end() ? *longest : it->session;
+    const uint64_t microseconds = static_cast<uint64_t>(std::llround(std::max(0.0, seconds) * 1000000.0));
+    const double   threshold    = std::max(static_cast<double>(min_hitch_ms) * 1000.0, hitch_ratio * static_cast<double>(reference.histogram.percentile(50)));
+    const bool     hitch        = reference.histogram.count() > 0 && static_cast<double>(microseconds) > threshold;
+
+    const Window::Sample sample{std::chrono::steady_clock::now(), microseconds, hitch};
+    for (auto& window : it->windows)
+        window.add(sample);
+    it->session.add(sample);
+}
+
+void FrameStats::track_scope(const std::string& name) {
+    if (std::ranges::find(tracked_scopes, name) == tracked_scopes.end())
+        tracked_scopes.emplace_back(name);
+}
+
+void FrameStats::untrack_scope(const std::string& name) {
+    std::erase(tracked_scopes, name);
+    std::erase_if(series, [&](const Series& item) { return item.name == name; });
+}
+
+void FrameStats::add_frame(const std::vector<Record>& frame) {
+    if (tracked_scopes.empty())
+        return;
+
+    // A scope can run several times per frame : sum its durations
+    std::vector<double> durations(tracked_scopes.size(), -1.0);
+    for (const auto& record : frame) {
+        // Records without arguments are compared without formatting their name
+        const std::string formatted = record.args.count > 0 ? record.name() : std::string();
+        for (size_t i = 0; i < tracked_scopes.size(); ++i) {
+            const bool match = record.args.count > 0 ? formatted == tracked_scopes[i] : std::strcmp(record.format, tracked_scopes[i].c_str()) == 0;
+            if (match)
+                durations[i] = std::max(0.0, durations[i]) + std::chrono::duration<double>(record.end - record.start).count();
+        }
+    }
+
+    for (size_t i = 0; i < tracked_scopes.size(); ++i)
+        if (durations[i] >= 0)
+            add_sample(tracked_scopes[i], durations[i]);
+}
+
+FrameStats::Summary FrameStats::summarize(const Window& window) {
+    const auto& histogram = window.histogram;
+    return Summary{
+        .count   = histogram.count(),
+        .p50     = static_cast<double>(histogram.percentile(50)) / 1000.0,
+        .p95     = static_cast<double>(histogram.percentile(95)) / 1000.0,
+        .p99     = static_cast<double>(histogram.percentile(99)) / 1000.0,
+        .p999    = static_cast<double>(histogram.percentile(99.9)) / 1000.0,
+        .max     = static_cast<double>(histogram.percentile(100)) / 1000.0,
+        .hitches = window.hitches,
+    };
+}
+
+static void write_summary(std::ofstream& file, const FrameStats::Window& window) {
+    const auto summary = FrameStats::summarize(window);
+    file << "\"seconds\":" << window.seconds << ",\"count\":" << summary.count << ",\"p50_ms\":" << summary.p50 << ",\"p95_ms\":" << summary.p95
+        << ",\"p99_ms\":" << summary.p99 << ",\"p99.9_ms\":" << summary.p999 << ",\"max_ms\":" << summary.max << ",\"hitches\":" << summary.hitches;
+}
+
+bool FrameStats::write(const std::filesystem::path& path) const {
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "Failed to open frame statistics output " << path.string() << std::endl;
+        return false;
+    }
+
+    file << "{\"hitch_ratio\":" << hitch_ratio << ",\"min_hitch_ms\":" << min_hitch_ms << ",\"series\":[";
+    for (size_t i = 0; i < series.size(); ++i) {
+        file << (i == 0 ? "\n" : ",\n") << "{\"name\":\"" << escape_json(series[i].name) << "\",\"session\":{";
+        write_summary(file, series[i].session);
+        file << "},\"windows\":[";
+        for (size_t w = 0; w < series[i].windows.size(); ++w) {
+            file << (w == 0 ? "{" : ",{");
+            write_summary(file, series[i].windows[w]);
+            file << "}";
+        }
+        file << "]}";
+    }
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "profiler.h"
+
+/**
+ * \brief Log-linear histogram of durations in microseconds (same layout as an HDR histogram) : values are grouped by power of two,
+ * each power being split into 64 linear buckets. The relative error is below 1.6% from 1us to 19 hours, with a fixed 16KB footprint.
+ */
+class DurationHistogram {
+public:
+    void add(uint64_t microseconds);
+    void remove(uint64_t microseconds);
+
+    /**
+     * \brief Smallest value greater or equal to 'percentile' % of the samples (upper bound of its bucket)
+     */
+    [[nodiscard]] uint64_t percentile(double percentile) const;
+    [[nodiscard]] uint64_t count() const { return total; }
+
+private:
+    static constexpr int      sub_bucket_bits  = 6;
+    static constexpr uint64_t sub_bucket_count = 1 << sub_bucket_bits;
+    static constexpr int      max_magnitude    = 30;
+
+    static size_t   bucket_index(uint64_t value);
+    static uint64_t bucket_upper_bound(size_t index);
+
+    std::array<uint64_t, (max_magnitude + 1) * sub_bucket_count> counts = {};
+    uint64_t                                                     total  = 0;
+};
+
+/**
+ * \brief Rolling frame time statistics. Frame times are pushed by World::tick_world(), and the durations of the tracked STAT_FRAME scopes
+ * (summed over each frame) by Profiler::new_frame(). Each series keeps one histogram per window plus one for the whole session.
+ */
+class FrameStats {
+public:
+    static FrameStats& get();
+
+    struct Summary {
+        uint64_t count   = 0;
+        double   p50     = 0; // milliseconds
+        double   p95     = 0;
+        double   p99     = 0;
+        double   p999    = 0;
+        double   max     = 0;
+        uint64_t hitches = 0;
+    };
+
+    struct Window {
+        float             seconds = 0; // 0 : whole session, samples are not retained
+        DurationHistogram histogram;
+        uint64_t          hitches = 0;
+
+        struct Sample {
+            TimeType time;
+            uint64_t microseconds;
+            bool     hitch;
+        };
+        std::deque<Sample> samples;
+
+        void add(const Sample& sample);
+    };
+
+    struct Series {
+        std::string         name;
+        std::vector<Window> windows;
+        Window              session;
+    };
+
+    // A sample is a hitch if it is 'hitch_ratio' times longer than the median of the longest window (and longer than 'min_hitch_ms')
+    float hitch_ratio  = 2.f;
+    float min_hitch_ms = 4.f;
+
+    /**
+     * \brief Add a sample to the series 'name'
+     */
+    void add_sample(const std::string& name, double seconds);
+
+    /**
+     * \brief Change the window durations (in seconds) of every series. Existing windows are rebuilt from the samples still retained.
+     */
+    void set_windows(std::vector<float> window_seconds);
+
+    /**
+     * \brief Also collect the duration of the STAT_FRAME scopes with this exact name (formatted with its arguments) every frame
+     */
+    void track_scope(const std::string& name);
+    void untrack_scope(const std::string& name);
+    void add_frame(const std::vector<Record>& frame);
+
+    [[nodiscard]] const std::vector<Series>&      get_series() const { return series; }
+    [[nodiscard]] const std::vector<std::string>& get_tracked_scopes() const { return tracked_scopes; }
+    [[nodiscard]] const std::vector<float>&       get_windows() const { return windows; }
+    [[nodiscard]] static Summary                  summarize(const Window& window);
+
+    /**
+     * \brief Write the summaries of every series and window as JSON
+     */
+    bool write(const std::filesystem::path& path) const;
+
+private:
+    FrameStats() = default;
+
+    std::vector<float>       windows = {1, 10, 60};
+    std::vector<Series>      series;
+    std::vector<std::string> tracked_scopes;
+};
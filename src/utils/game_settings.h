@@ -9,6 +9,15 @@ enum class Shading {
     PBR = 3,
 };
 
+/**
+ * \brief Resolution divisor of the low frequency effects (atmosphere, screen space reflections)
+ */
+enum class EffectResolution {
+    Full    = 1,
+    Half    = 2,
+    Quarter = 4,
+};
+
 class GameSettings {
 public:
     static GameSettings& get();
@@ -18,6 +27,10 @@ public:
     bool wireframe  = false;
     bool fullscreen = false;
     int  max_fps    = 0;
+    // Hidden window, input events are ignored (--headless). The application exits once the trace capture is written. Must be set before Engine::init().
+    bool headless = false;
+    // Simulation step in seconds, 0 = real time (the benchmark uses a fixed step to be repeatable)
+    double fixed_delta_seconds = 0;
 
     // Bloom
     float bloom_intensity = 0.5f;
@@ -35,5 +48,8 @@ public:
     bool  screen_space_reflections = true;
     float ssr_quality              = 0.3f;
 
+    // Atmosphere and reflections are upsampled with a depth aware filter. Call FrameGraph::invalidate_resolution() after changing it.
+    EffectResolution effect_resolution = EffectResolution::Half;
+
     Eigen::Quaterniond sun_direction = Eigen::Quaterniond::FromTwoVectors(Eigen::Vector3d(1, 0, 0), Eigen::Vector3d(1, 0, 1).normalized());
 };
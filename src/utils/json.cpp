@@ -0,0 +1,16 @@
+#include "json.h"
+
+std::string escape_json(std::string_view text) {
+    std::string result;
+    result.reserve(text.size());
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            result += '\\';
+            result += c;
+        } else if (static_cast<unsigned char>(c) < 0x20)
+            result += ' ';
+        else
+            result += c;
+    }
+    return result;
+}
@@ -0,0 +1,8 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+/**
+ * \brief Escape a string to be written between quotes in a JSON file (quotes and backslashes are escaped, control characters become spaces)
+ */
+std::string escape_json(std::string_view text);
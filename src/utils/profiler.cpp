@@ -1,8 +1,13 @@
 #include "profiler.h"
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
-#include <iostream>
-#include <memory>
+#include <mutex>
+
+#include "frame_stats.h"
+#include "spsc_queue.h"
+#include "trace_capture.h"
 
 std::unique_ptr<Profiler> profiler_singleton = nullptr;
 
@@ -14,94 +19,146 @@ Profiler& Profiler::get()
 	return *profiler_singleton;
 }
 
-void Profiler::new_frame()
-{
-	last_frame = std::move(frame_events);
-	frame_events = std::vector<Record>();
-}
-
-void Profiler::clear_actions()
-{
-	actions.clear();
-}
-
-uint64_t Profiler::begin_frame_event(std::string name)
-{
-	if (!enabled)
-		return -1;
-
-	frame_events.emplace_back(Record {std::move(name), std::chrono::steady_clock::now(), std::chrono::steady_clock::now(), std::this_thread::get_id()} );
-	return frame_events.size() - 1;
-}
-
-void Profiler::end_frame_event(uint64_t record)
+void StatArgs::push(std::string_view value)
 {
-	frame_events[record].end = std::chrono::steady_clock::now();
+	if (size >= capacity)
+		return;
+	const size_t length = std::min(value.size(), capacity - size - 1);
+	std::memcpy(text + size, value.data(), length);
+	text[size + length] = '\0';
+	size = static_cast<uint8_t>(size + length + 1);
+	count++;
 }
 
-double Profiler::frame_event_duration(uint64_t record) const
+std::string Record::name() const
 {
-	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - frame_events[record].start).count() / 1000.0;
+	if (!format)
+		return {};
+
+	std::string result;
+	const char* arg = args.text;
+	uint8_t remaining_args = args.count;
+	for (const char* c = format; *c; ++c)
+	{
+		if (c[0] == '{' && c[1] == '}' && remaining_args > 0)
+		{
+			result += arg;
+			arg += std::strlen(arg) + 1;
+			remaining_args--;
+			++c;
+			continue;
+		}
+		result += *c;
+	}
+	return result;
 }
 
-uint64_t Profiler::begin_action(std::string name)
+struct ThreadEvent
 {
-	std::lock_guard lock_guard(action_mutex);
-	if (!enabled)
-		return -1;
-
-	actions.emplace_back(Record{ std::move(name), std::chrono::steady_clock::now(), std::chrono::steady_clock::now(), std::this_thread::get_id() });
-	return actions.size() - 1;
-}
-
-void Profiler::end_action(uint64_t record)
+	StatType type;
+	Record record;
+};
+
+/**
+ * \brief Events of one thread : written by this thread only, drained by Profiler::new_frame()
+ */
+struct ThreadBuffer
 {
-	std::lock_guard lock_guard(action_mutex);
-	actions[record].end = std::chrono::steady_clock::now();
-}
+	SpscQueue<ThreadEvent, 2048> events;
+	std::thread::id thread_id = std::this_thread::get_id();
+	std::atomic<uint64_t> dropped = 0;
+	std::atomic_bool retired = false; // The thread exited : the buffer is released once drained
+};
 
-double Profiler::action_duration(uint64_t record)
-{
-	std::lock_guard lock_guard(action_mutex);
-	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - actions[record].start).count() / 1000.0;
-}
+// Only locked when a thread records its first event, and by new_frame()
+static std::mutex thread_buffers_lock;
+static std::vector<std::shared_ptr<ThreadBuffer>> thread_buffers;
 
-FrameEventRecord::FrameEventRecord(std::string in_stat_name)
-	: stat_name(in_stat_name), record_begin(std::chrono::steady_clock::now()),
-	  self_ref(-1)
+struct ThreadBufferHolder
 {
-	self_ref = Profiler::get().begin_frame_event(std::move(stat_name));
-}
-
-FrameEventRecord::~FrameEventRecord()
+	ThreadBufferHolder()
+	{
+		buffer = std::make_shared<ThreadBuffer>();
+		std::lock_guard lock(thread_buffers_lock);
+		thread_buffers.emplace_back(buffer);
+	}
+
+	~ThreadBufferHolder()
+	{
+		buffer->retired.store(true, std::memory_order_release);
+	}
+
+	std::shared_ptr<ThreadBuffer> buffer;
+};
+
+void Profiler::submit(StatType type, const Record& record)
 {
-	if (self_ref >= 0)
-		Profiler::get().end_frame_event(self_ref);
+	thread_local ThreadBufferHolder holder;
+	if (!holder.buffer->events.push(ThreadEvent{type, record}))
+		holder.buffer->dropped.fetch_add(1, std::memory_order_relaxed);
 }
 
-double FrameEventRecord::get_elapsed_milliseconds() const
+void Profiler::new_frame()
 {
-	if (self_ref >= 0)
-		return Profiler::get().frame_event_duration(self_ref);
-	return -1;
+	// Keep the capacity : no allocation once the frame size is stable
+	last_frame.clear();
+	const size_t first_new_action = actions.size();
+	uint64_t dropped = 0;
+	{
+		std::lock_guard lock(thread_buffers_lock);
+		std::erase_if(thread_buffers, [&](const std::shared_ptr<ThreadBuffer>& buffer)
+		{
+			// Read before draining : once set, every event of the thread is already in the queue
+			const bool retired = buffer->retired.load(std::memory_order_acquire);
+			while (auto event = buffer->events.pop())
+			{
+				event->record.thread_id = buffer->thread_id;
+				(event->type == StatType::Frame ? last_frame : actions).emplace_back(event->record);
+			}
+			dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+			return retired;
+		});
+	}
+
+	if (dropped > 0)
+		add_counter("Profiler dropped events", static_cast<int64_t>(dropped));
+
+	// Records are pushed when their scope ends : restore the start order expected by the viewers
+	const auto by_start = [](const Record& a, const Record& b) { return a.start < b.start; };
+	std::ranges::stable_sort(last_frame, by_start);
+	std::stable_sort(actions.begin() + static_cast<std::ptrdiff_t>(first_new_action), actions.end(), by_start);
+	const std::span new_actions(actions.begin() + static_cast<std::ptrdiff_t>(first_new_action), actions.end());
+	TraceCapture::get().add_cpu_frame(last_frame, new_actions, frame_counters);
+	FrameStats::get().add_frame(last_frame);
+	std::inplace_merge(actions.begin(), actions.begin() + static_cast<std::ptrdiff_t>(first_new_action), actions.end(), by_start);
+
+	// Keep the capacity of both lists
+	std::swap(last_frame_counters, frame_counters);
+	frame_counters.clear();
 }
 
-ActionRecord::ActionRecord(std::string in_action_name)
-	: stat_name(in_action_name), record_begin(std::chrono::steady_clock::now()),
-	self_ref(-1)
+void Profiler::set_last_gpu_frame(std::vector<Record> records)
 {
-	self_ref = Profiler::get().begin_action(std::move(stat_name));
+	TraceCapture::get().add_gpu_frame(records);
+	on_gpu_frame_resolved.execute(records);
+	last_gpu_frame = std::move(records);
 }
 
-ActionRecord::~ActionRecord()
+void Profiler::add_counter(const char* name, int64_t value)
 {
-	if (self_ref >= 0)
-		Profiler::get().end_action(self_ref);
+	if (!is_enabled())
+		return;
+
+	for (auto& counter : frame_counters)
+		if (counter.same_name(name))
+		{
+			counter.value += value;
+			return;
+		}
+	frame_counters.emplace_back(Counter{name, value});
 }
 
-double ActionRecord::get_elapsed_milliseconds()
+void Profiler::clear_actions()
 {
-	if (self_ref >= 0)
-		return Profiler::get().frame_event_duration(self_ref);
-	return -1;
+	actions.clear();
 }
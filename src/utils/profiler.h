@@ -1,75 +1,159 @@
 #pragma once
+#include <atomic>
+#include <charconv>
 #include <chrono>
-#include <vector>
+#include <concepts>
+#include <cstring>
 #include <string>
-#include <mutex>
+#include <string_view>
 #include <thread>
+#include <vector>
+
+#include "event_manager.h"
 
 #define CONCAT(x, y) x ## y
 #define CONCAT_2(x, y) CONCAT(x, y)
-#define STAT_FRAME(name) FrameEventRecord CONCAT_2(frame_event_recorder_, __LINE__)(name)
-#define STAT_ACTION(name) ActionRecord CONCAT_2(action_recorder_, __LINE__)(name)
+// format : string literal, where each "{}" is replaced by the next argument when the record is displayed. Arguments are strings or integers.
+#define STAT_FRAME(format, ...) StatRecord CONCAT_2(frame_event_recorder_, __LINE__)(StatType::Frame, format __VA_OPT__(,) __VA_ARGS__)
+#define STAT_ACTION(format, ...) StatRecord CONCAT_2(action_recorder_, __LINE__)(StatType::Action, format __VA_OPT__(,) __VA_ARGS__)
+// name : string literal, identified by its pointer like the record formats. Nothing is evaluated while the profiler is disabled.
+#define STAT_COUNTER(name, value)                         \
+    do {                                                  \
+        if (Profiler::is_enabled())                       \
+            Profiler::get().add_counter(name, value);     \
+    } while (false)
 
 using TimeType = std::chrono::steady_clock::time_point;
 
+/**
+ * \brief Arguments of a record name. They are copied into a fixed size buffer (truncated if too long) : recording a stat never allocates.
+ */
+struct StatArgs {
+    static constexpr size_t capacity = 56;
+
+    void push(std::string_view value);
+
+    template <std::integral Int_T> void push(Int_T value) {
+        char       buffer[24];
+        const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        push(std::string_view(buffer, result.ptr - buffer));
+    }
+
+    uint8_t count = 0;
+    uint8_t size  = 0;
+    char    text[capacity]; // Arguments separated by '\0'
+};
+
 struct Record {
-    std::string     name;
+    const char*     format = nullptr; // Static string : the pointer identifies the stat
+    StatArgs        args;
     TimeType        start;
     TimeType        end;
     std::thread::id thread_id;
+
+    /**
+     * \brief Replace the "{}" of the format with the arguments. Allocates : only call it to display the record.
+     */
+    [[nodiscard]] std::string name() const;
+};
+
+struct Counter {
+    const char* name; // Static string (see STAT_COUNTER)
+    int64_t     value;
+
+    /**
+     * \brief Same counter. The pointers are compared first : the same literal is only merged within a translation unit.
+     */
+    [[nodiscard]] bool same_name(const char* other) const { return name == other || std::strcmp(name, other) == 0; }
 };
 
+DECLARE_DELEGATE_MULTICAST(EventGpuFrameResolved, const std::vector<Record>&);
+
+enum class StatType : uint8_t {
+    Frame,
+    Action
+};
+
+/**
+ * \brief Each thread records its finished events in its own lock-free ring buffer. new_frame() drains every buffer from the main thread.
+ * When disabled, a stat costs a single relaxed load.
+ */
 class Profiler {
 public:
-    bool enabled = true;
+    [[nodiscard]] static bool is_enabled() { return enabled.load(std::memory_order_relaxed); }
+    static void               set_enabled(bool in_enabled) { enabled.store(in_enabled, std::memory_order_relaxed); }
 
+    /**
+     * \brief Collect the events recorded by every thread since the last call (main thread only)
+     */
     void new_frame();
     void clear_actions();
 
-    uint64_t             begin_frame_event(std::string name);
-    void                 end_frame_event(uint64_t record);
-    [[nodiscard]] double frame_event_duration(uint64_t record) const;
+    /**
+     * \brief Push a finished record into the buffer of the calling thread. Never locks, the record is dropped if the buffer is full.
+     */
+    static void submit(StatType type, const Record& record);
 
-    uint64_t             begin_action(std::string name);
-    void                 end_action(uint64_t record);
-    [[nodiscard]] double action_duration(uint64_t record);
+    /**
+     * \brief Accumulate a value into a named counter of the current frame (main thread only). Never allocates once the counter list is stable.
+     */
+    void add_counter(const char* name, int64_t value);
 
     static Profiler& get();
 
-    [[nodiscard]] const std::vector<Record>& get_last_frame() const { return last_frame; }
-    [[nodiscard]] const std::vector<Record>& get_actions() const { return actions; }
+    [[nodiscard]] const std::vector<Record>&  get_last_frame() const { return last_frame; }
+    [[nodiscard]] const std::vector<Record>&  get_actions() const { return actions; }
+    [[nodiscard]] const std::vector<Counter>& get_last_frame_counters() const { return last_frame_counters; }
 
-private:
-    Profiler() = default;
+    /**
+     * \brief GPU events (see STAT_GPU) of the latest frame whose queries are resolved : a few frames older than get_last_frame()
+     */
+    [[nodiscard]] const std::vector<Record>& get_last_gpu_frame() const { return last_gpu_frame; }
+    void                                     set_last_gpu_frame(std::vector<Record> records);
 
-    std::vector<Record> frame_events;
-    std::vector<Record> actions;
-    std::vector<Record> last_frame;
-    std::mutex          action_mutex;
-};
+    /**
+     * \brief Called for every resolved GPU frame. Several frames can be resolved at once : get_last_gpu_frame() only keeps the latest.
+     */
+    EventGpuFrameResolved on_gpu_frame_resolved;
 
-class FrameEventRecord final {
-public:
-    FrameEventRecord(std::string in_stat_name);
-    ~FrameEventRecord();
+private:
+    Profiler() = default;
 
-    [[nodiscard]] double get_elapsed_milliseconds() const;
+    static inline std::atomic_bool enabled = true;
 
-private:
-    std::string stat_name;
-    TimeType    record_begin;
-    int64_t     self_ref;
+    std::vector<Record>  actions;
+    std::vector<Record>  last_frame;
+    std::vector<Record>  last_gpu_frame;
+    std::vector<Counter> frame_counters;
+    std::vector<Counter> last_frame_counters;
 };
 
-class ActionRecord final {
+/**
+ * \brief Record the lifetime of a scope (see STAT_FRAME and STAT_ACTION)
+ */
+class StatRecord final {
 public:
-    ActionRecord(std::string in_action_name);
-    ~ActionRecord();
-
-    [[nodiscard]] double get_elapsed_milliseconds();
+    template <typename... Args_T>
+    StatRecord(StatType in_type, const char* format, const Args_T&... args)
+        : type(in_type) {
+        if (!Profiler::is_enabled())
+            return;
+        record.format = format;
+        (record.args.push(args), ...);
+        record.start = std::chrono::steady_clock::now();
+    }
+
+    ~StatRecord() {
+        if (!record.format)
+            return;
+        record.end = std::chrono::steady_clock::now();
+        Profiler::submit(type, record);
+    }
+
+    StatRecord(const StatRecord&)            = delete;
+    StatRecord& operator=(const StatRecord&) = delete;
 
 private:
-    std::string stat_name;
-    TimeType    record_begin;
-    int64_t     self_ref;
+    StatType type;
+    Record   record;
 };
@@ -0,0 +1,40 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <optional>
+
+/**
+ * \brief Bounded queue between exactly one producer thread and one consumer thread.
+ * push() and pop() never lock : each side only writes its own index.
+ */
+template <typename Value_T, size_t Capacity> class SpscQueue {
+public:
+    /**
+     * \brief Return false if the queue is full (the value is dropped)
+     */
+    bool push(Value_T value) {
+        const size_t write = write_index.load(std::memory_order_relaxed);
+        const size_t next  = (write + 1) % items.size();
+        if (next == read_index.load(std::memory_order_acquire))
+            return false;
+        items[write] = std::move(value);
+        write_index.store(next, std::memory_order_release);
+        return true;
+    }
+
+    std::optional<Value_T> pop() {
+        const size_t read = read_index.load(std::memory_order_relaxed);
+        if (read == write_index.load(std::memory_order_acquire))
+            return {};
+        std::optional<Value_T> value = std::move(items[read]);
+        read_index.store((read + 1) % items.size(), std::memory_order_release);
+        return value;
+    }
+
+private:
+    // One slot is always left empty to distinguish a full queue from an empty one
+    std::array<Value_T, Capacity + 1> items;
+    alignas(64) std::atomic<size_t>   write_index = 0;
+    alignas(64) std::atomic<size_t>   read_index  = 0;
+};
@@ -0,0 +1,194 @@
+#include "trace_capture.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+
+#include "json.h"
+
+static std::unique_ptr<TraceCapture> trace_capture_singleton = nullptr;
+
+// The GpuProfiler drops the frames it couldn't resolve after a few frames : don't wait longer than that for the end of the capture
+static constexpr uint32_t max_gpu_latency_frames = 10;
+
+TraceCapture& TraceCapture::get() {
+    if (!trace_capture_singleton)
+        trace_capture_singleton = std::unique_ptr<TraceCapture>(new TraceCapture());
+    return *trace_capture_singleton;
+}
+
+void TraceCapture::start(TraceCaptureSettings in_settings) {
+    if (is_capturing())
+        return;
+    settings        = std::move(in_settings);
+    state           = State::Pending;
+    cpu_frame_count = 0;
+    gpu_wait_frames = 0;
+    cpu_events.clear();
+    gpu_events.clear();
+    counters.clear();
+    profiler_was_enabled = Profiler::is_enabled();
+    Profiler::set_enabled(true);
+    std::cout << "Start trace capture (" << settings.frames << " frames) to " << settings.output.string() << std::endl;
+}
+
+static std::optional<std::string> find_option(int argc, char** argv, const char* argument, const char* environment_variable) {
+    for (int i = 1; i + 1 < argc; ++i)
+        if (std::strcmp(argv[i], argument) == 0)
+            return argv[i + 1];
+    if (const char* value = std::getenv(environment_variable))
+        return value;
+    return {};
+}
+
+std::optional<TraceCaptureSettings> TraceCapture::settings_from_command_line(int argc, char** argv) {
+    const auto frames  = find_option(argc, argv, "--trace-frames", "PLANET_ENGINE_TRACE_FRAMES");
+    const auto seconds = find_option(argc, argv, "--trace-seconds", "PLANET_ENGINE_TRACE_SECONDS");
+    const auto output  = find_option(argc, argv, "--trace-output", "PLANET_ENGINE_TRACE_OUTPUT");
+    if (!frames && !seconds && !output)
+        return {};
+
+    TraceCaptureSettings result;
+    if (seconds) {
+        result.seconds = std::strtof(seconds->c_str(), nullptr);
+        if (!frames) // Only limited by the duration
+            result.frames = std::numeric_limits<uint32_t>::max();
+    }
+    if (frames)
+        result.frames = static_cast<uint32_t>(std::strtoul(frames->c_str(), nullptr, 10));
+    if (output)
+        result.output = *output;
+
+    if (result.frames == 0) {
+        std::cerr << "Invalid trace capture frame count : " << *frames << std::endl;
+        return {};
+    }
+    return result;
+}
+
+void TraceCapture::add_cpu_frame(const std::vector<Record>& frame, std::span<const Record> new_actions, const std::vector<Counter>& frame_counters) {
+    if (state == State::Idle)
+        return;
+
+    if (state == State::WaitingGpu) {
+        if (++gpu_wait_frames > max_gpu_latency_frames)
+            finish();
+        return;
+    }
+
+    const TimeType frame_start = frame.empty() ? std::chrono::steady_clock::now() : frame.front().start;
+    if (state == State::Pending) {
+        capture_start = frame_start;
+        state         = State::Recording;
+    }
+
+    cpu_events.insert(cpu_events.end(), frame.begin(), frame.end());
+    cpu_events.insert(cpu_events.end(), new_actions.begin(), new_actions.end());
+    for (const auto& counter : frame_counters)
+        counters.emplace_back(CounterSample{counter.name, counter.value, frame_start});
+    last_cpu_frame_start = frame_start;
+    last_cpu_frame_end   = frame_start;
+    for (const auto& event : frame)
+        last_cpu_frame_end = std::max(last_cpu_frame_end, event.end);
+    cpu_frame_count++;
+
+    const bool out_of_time = settings.seconds > 0 && std::chrono::duration<float>(frame_start - capture_start).count() >= settings.seconds;
+    if (cpu_frame_count >= settings.frames || out_of_time) {
+        state           = State::WaitingGpu;
+        gpu_wait_frames = 0;
+        // The GPU events of the last frame may have been resolved before the frame was closed
+        if (!gpu_events.empty() && last_gpu_frame_start >= last_cpu_frame_start)
+            finish();
+    }
+}
+
+void TraceCapture::add_gpu_frame(const std::vector<Record>& frame) {
+    if (state != State::Recording && state != State::WaitingGpu)
+        return;
+    // GPU frames are anchored on the CPU time of their first event
+    if (frame.empty() || frame.front().start < capture_start)
+        return;
+
+    const bool after_capture = state == State::WaitingGpu && frame.front().start > last_cpu_frame_end;
+    if (!after_capture) {
+        gpu_events.insert(gpu_events.end(), frame.begin(), frame.end());
+        last_gpu_frame_start = frame.front().start;
+    }
+
+    // Queries are resolved in submission order : every frame of the capture is there
+    if (state == State::WaitingGpu && frame.front().start >= last_cpu_frame_start)
+        finish();
+}
+
+void TraceCapture::finish() {
+    if (write()) {
+        std::cout << "Trace capture written to " << settings.output.string() << " (" << cpu_frame_count << " frames, " << cpu_events.size() << " CPU events, "
+            << gpu_events.size() << " GPU events)" << std::endl;
+    }
+    state = State::Idle;
+    cpu_events.clear();
+    gpu_events.clear();
+    counters.clear();
+    completed_capture_count++;
+    Profiler::set_enabled(profiler_was_enabled);
+}
+
+bool TraceCapture::write() const {
+    std::ofstream file(settings.output);
+    if (!file) {
+        std::cerr << "Failed to open trace capture output " << settings.output.string() << std::endl;
+        return false;
+    }
+
+    // Long actions may have started before the capture
+    TimeType origin = capture_start;
+    for (const auto& event : cpu_events)
+        origin = std::min(origin, event.start);
+    const auto timestamp = [&](const TimeType& time) {
+        return std::chrono::duration<double, std::micro>(time - origin).count();
+    };
+
+    // Chrome traces identify threads with small integers. The capture is driven by the main thread.
+    std::unordered_map<std::thread::id, uint32_t> thread_ids = {{std::this_thread::get_id(), 0}};
+    const auto thread_index = [&](const std::thread::id& id) {
+        return thread_ids.emplace(id, static_cast<uint32_t>(thread_ids.size())).first->second;
+    };
+
+    constexpr int cpu_pid = 1;
+    constexpr int gpu_pid = 2;
+
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << R"({"name":"process_name","ph":"M","pid":)" << cpu_pid << R"(,"tid":0,"args":{"name":"CPU"}},)" << "\n";
+    file << R"({"name":"process_name","ph":"M","pid":)" << gpu_pid << R"(,"tid":0,"args":{"name":"GPU"}},)" << "\n";
+    file << R"({"name":"thread_name","ph":"M","pid":)" << gpu_pid << R"(,"tid":0,"args":{"name":"GPU queue"}})";
+
+    const auto write_events = [&](const std::vector<Record>& events, int pid, const char* category) {
+        for (const auto& event : events) {
+            file << ",\n{\"name\":\"" << escape_json(event.name()) << "\",\"cat\":\"" << category << "\",\"ph\":\"X\",\"ts\":" << timestamp(event.start)
+                << ",\"dur\":" << std::chrono::duration<double, std::micro>(event.end - event.start).count() << ",\"pid\":" << pid
+                << ",\"tid\":" << (pid == gpu_pid ? 0 : thread_index(event.thread_id)) << "}";
+        }
+    };
+    write_events(cpu_events, cpu_pid, "cpu");
+    write_events(gpu_events, gpu_pid, "gpu");
+
+    for (const auto& counter : counters) {
+        file << ",\n{\"name\":\"" << escape_json(counter.name) << "\",\"ph\":\"C\",\"ts\":" << timestamp(counter.time) << ",\"pid\":" << cpu_pid
+            << ",\"args\":{\"value\":" << counter.value << "}}";
+    }
+
+    for (const auto& [id, index] : thread_ids) {
+        file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << cpu_pid << ",\"tid\":" << index << ",\"args\":{\"name\":\""
+            << (index == 0 ? std::string("Main thread") : "Worker thread " + std::to_string(index)) << "\"}}";
+    }
+
+    file << "\n]}\n";
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "profiler.h"
+
+struct TraceCaptureSettings {
+    std::filesystem::path output = "profiler_trace.json";
+    // The capture stops after this many frames, or after 'seconds' if it is reached first (0 = no time limit)
+    uint32_t frames  = 300;
+    float    seconds = 0;
+};
+
+/**
+ * \brief Record the CPU scopes, GPU scopes and counters of several consecutive frames, and write them as a Chrome Trace Event JSON file
+ * (open it with ui.perfetto.dev or chrome://tracing). Fed by the Profiler : it doesn't depend on the UI and works in headless runs.
+ */
+class TraceCapture {
+public:
+    static TraceCapture& get();
+
+    /**
+     * \brief Start recording from the next frame. Enable the profiler until the capture is written. Ignored if a capture is already running.
+     */
+    void start(TraceCaptureSettings settings);
+
+    /**
+     * \brief Capture requested with --trace-frames <count>, --trace-seconds <duration>, --trace-output <path>,
+     * or with the environment variables PLANET_ENGINE_TRACE_FRAMES, PLANET_ENGINE_TRACE_SECONDS and PLANET_ENGINE_TRACE_OUTPUT (arguments take precedence)
+     */
+    static std::optional<TraceCaptureSettings> settings_from_command_line(int argc, char** argv);
+
+    [[nodiscard]] bool     is_capturing() const { return state != State::Idle; }
+    [[nodiscard]] uint32_t captured_frames() const { return cpu_frame_count; }
+    [[nodiscard]] uint32_t completed_captures() const { return completed_capture_count; }
+
+    void add_cpu_frame(const std::vector<Record>& frame, std::span<const Record> new_actions, const std::vector<Counter>& counters);
+    void add_gpu_frame(const std::vector<Record>& frame);
+
+private:
+    TraceCapture() = default;
+
+    enum class State {
+        Idle,
+        Pending,     // Waiting for the first frame
+        Recording,   // Recording CPU and GPU events
+        WaitingGpu,  // CPU capture done, waiting for the GPU queries of the last frames to be resolved
+    };
+
+    struct CounterSample {
+        const char* name;
+        int64_t     value;
+        TimeType    time;
+    };
+
+    void finish();
+    bool write() const;
+
+    TraceCaptureSettings       settings;
+    State                      state                   = State::Idle;
+    uint32_t                   cpu_frame_count         = 0;
+    uint32_t                   gpu_wait_frames         = 0;
+    uint32_t                   completed_capture_count = 0;
+    bool                       profiler_was_enabled    = true;
+    TimeType                   capture_start;
+    TimeType                   last_cpu_frame_start;
+    TimeType                   last_cpu_frame_end;
+    TimeType                   last_gpu_frame_start;
+    std::vector<Record>        cpu_events;
+    std::vector<Record>        gpu_events;
+    std::vector<CounterSample> counters;
+};
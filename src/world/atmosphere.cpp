@@ -0,0 +1,165 @@
+#include "atmosphere.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <GL/gl3w.h>
+
+#include "graphics/buffer_arena.h"
+#include "graphics/camera.h"
+#include "graphics/compute_shader.h"
+#include "graphics/texture_image.h"
+#include "utils/gl_tools.h"
+#include "utils/profiler.h"
+
+static std::vector<Atmosphere*> atmosphere_list;
+
+// LUT layers of every atmosphere
+static std::shared_ptr<Texture2DArray> transmittance_luts;
+static std::shared_ptr<Texture2DArray> sky_view_luts;
+
+const std::vector<Atmosphere*>& Atmosphere::registry() { return atmosphere_list; }
+
+int32_t Atmosphere::allocate_lut_layer() {
+    int32_t layer = 0;
+    while (std::ranges::any_of(atmosphere_list, [layer](const auto& atmosphere) { return atmosphere->parameters.lut_layer == layer; }))
+        layer++;
+
+    const uint32_t capacity = transmittance_luts ? transmittance_luts->depth() : 0;
+    if (static_cast<uint32_t>(layer) < capacity)
+        return layer;
+
+    // Grow the arrays and keep the existing LUTs
+    const uint32_t           new_capacity = std::max(4u, capacity * 2);
+    const TextureCreateInfos lut_infos    = {.wrapping = TextureWrapping::ClampToEdge, .filtering_mag = TextureMagFilter::Linear, .filtering_min = TextureMinFilter::Linear};
+    const auto               new_transmittance_luts = Texture2DArray::create("Atmosphere transmittance LUTs", lut_infos);
+    new_transmittance_luts->set_data(transmittance_lut_width, transmittance_lut_height, new_capacity, ImageFormat::R_F32);
+    const auto new_sky_view_luts = Texture2DArray::create("Atmosphere sky view LUTs", lut_infos);
+    new_sky_view_luts->set_data(sky_view_lut_width, sky_view_lut_height, new_capacity, ImageFormat::RGBA_F16);
+    if (capacity > 0) {
+        glCopyImageSubData(transmittance_luts->id(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, new_transmittance_luts->id(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, transmittance_lut_width, transmittance_lut_height, capacity);
+        glCopyImageSubData(sky_view_luts->id(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, new_sky_view_luts->id(), GL_TEXTURE_2D_ARRAY, 0, 0, 0, 0, sky_view_lut_width, sky_view_lut_height, capacity);
+    }
+    transmittance_luts = new_transmittance_luts;
+    sky_view_luts      = new_sky_view_luts;
+    GL_CHECK_ERROR();
+    return layer;
+}
+
+Atmosphere::Atmosphere(std::string in_name)
+    : name(std::move(in_name)) {
+    parameters.lut_layer = allocate_lut_layer();
+    atmosphere_list.emplace_back(this);
+
+    transmittance_compute = ComputeShader::create("Atmosphere transmittance LUT", "resources/shaders/compute/atmosphere_transmittance_lut.cs");
+    sky_view_compute      = ComputeShader::create("Atmosphere sky view LUT", "resources/shaders/compute/atmosphere_sky_view_lut.cs");
+    transmittance_compute->on_reload.add_object(this, &Atmosphere::invalidate_luts);
+}
+
+Atmosphere::~Atmosphere() {
+    transmittance_compute->on_reload.clear_object(this);
+    std::erase(atmosphere_list, this);
+    if (atmosphere_list.empty()) {
+        transmittance_luts = nullptr;
+        sky_view_luts      = nullptr;
+    }
+}
+
+// Layout must match AtmosphereData in atmosphere.cginc
+struct AtmosphereDataHeader {
+    uint32_t atmosphere_count;
+    uint32_t padding[3];
+};
+
+static void push_atmosphere_data(const Atmosphere::GpuParameters* atmospheres, uint32_t count) {
+    const auto allocation = BufferArena::get().allocate(sizeof(AtmosphereDataHeader) + count * sizeof(Atmosphere::GpuParameters));
+    // The arena is full (already reported by BufferArena) : skip the upload for this frame
+    if (!allocation.data)
+        return;
+    const AtmosphereDataHeader header{.atmosphere_count = count, .padding = {}};
+    std::memcpy(allocation.data, &header, sizeof(AtmosphereDataHeader));
+    if (count > 0)
+        std::memcpy(static_cast<uint8_t*>(allocation.data) + sizeof(AtmosphereDataHeader), atmospheres, count * sizeof(Atmosphere::GpuParameters));
+    allocation.bind(GL_SHADER_STORAGE_BUFFER, 10);
+}
+
+void Atmosphere::update(const Settings& new_settings, float planet_radius, const Eigen::Vector3f& center, const Eigen::Vector3f& viewer_position, const Eigen::Vector3f& sun_direction) {
+    STAT_FRAME("Update atmosphere [{}]", name);
+    parameters.center = center;
+    const bool viewer_inside = (viewer_position - center).norm() < planet_radius + new_settings.atmosphere_depth;
+    if (!settings || *settings != new_settings || parameters.planet_radius != planet_radius) {
+        settings = new_settings;
+
+        // Rayleigh-like : shorter wavelengths are scattered more
+        const auto scatter = [&](float wavelength) {
+            return std::pow(400.f / wavelength, new_settings.scatter_coefficients.w()) * new_settings.scatter_strength;
+        };
+        parameters.planet_radius        = planet_radius;
+        parameters.atmosphere_radius    = planet_radius + new_settings.atmosphere_depth;
+        parameters.scatter_coefficients = {scatter(new_settings.scatter_coefficients.x()), scatter(new_settings.scatter_coefficients.y()), scatter(new_settings.scatter_coefficients.z())};
+        parameters.density_falloff      = new_settings.density_falloff;
+        parameters.epsilon              = new_settings.epsilon;
+        rebuild_transmittance_lut();
+    }
+    // The sky view LUT is only read from inside the atmosphere
+    parameters.has_sky_view = viewer_inside;
+    if (viewer_inside)
+        rebuild_sky_view_lut(viewer_position, sun_direction);
+}
+
+void Atmosphere::rebuild_transmittance_lut() {
+    STAT_ACTION("Rebuild transmittance LUT [{}]", name);
+    push_atmosphere_data(&parameters, 1);
+    transmittance_compute->bind();
+    transmittance_compute->bind_texture(transmittance_luts, BindingMode::Out, 0);
+    transmittance_compute->execute(transmittance_lut_width, transmittance_lut_height, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    GL_CHECK_ERROR();
+}
+
+void Atmosphere::rebuild_sky_view_lut(const Eigen::Vector3f& viewer_position, const Eigen::Vector3f& sun_direction) {
+    // Layout must match SkyViewData in atmosphere_sky_view_lut.cs
+    struct SkyViewData {
+        Eigen::Vector4f viewer_position;
+        Eigen::Vector4f sun_direction;
+    };
+    push_atmosphere_data(&parameters, 1);
+    BufferArena::get().push(SkyViewData{
+        .viewer_position = Eigen::Vector4f(viewer_position.x(), viewer_position.y(), viewer_position.z(), 0),
+        .sun_direction = Eigen::Vector4f(sun_direction.x(), sun_direction.y(), sun_direction.z(), 0),
+    }).bind(GL_SHADER_STORAGE_BUFFER, 11);
+    sky_view_compute->bind();
+    transmittance_luts->bind(1);
+    sky_view_compute->bind_texture(sky_view_luts, BindingMode::Out, 0);
+    sky_view_compute->execute(sky_view_lut_width, sky_view_lut_height, 1);
+    glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    GL_CHECK_ERROR();
+}
+
+Atmosphere::Uniforms::Uniforms(const Material& material)
+    : transmittance_luts(material.uniform<std::shared_ptr<TextureBase>>("atmosphere_transmittance_luts")),
+      sky_view_luts(material.uniform<std::shared_ptr<TextureBase>>("atmosphere_sky_view_luts")) {
+}
+
+void Atmosphere::bind_visible(const Uniforms& uniforms, Camera& camera) {
+    STAT_FRAME("Bind visible atmospheres");
+    static std::vector<GpuParameters> visible_atmospheres;
+    visible_atmospheres.clear();
+
+    const Frustum         frustum         = camera.get_frustum();
+    const Eigen::Vector3d camera_position = camera.get_world_position();
+    for (const auto& atmosphere : atmosphere_list) {
+        if (!atmosphere->settings)
+            continue;
+        const Eigen::Vector3d center_cs = atmosphere->parameters.center.cast<double>() - camera_position;
+        if (frustum.intersects_sphere(center_cs, atmosphere->parameters.atmosphere_radius))
+            visible_atmospheres.emplace_back(atmosphere->parameters);
+    }
+    STAT_COUNTER("Visible atmospheres", static_cast<int64_t>(visible_atmospheres.size()));
+
+    push_atmosphere_data(visible_atmospheres.data(), static_cast<uint32_t>(visible_atmospheres.size()));
+    if (transmittance_luts) {
+        uniforms.transmittance_luts.set(transmittance_luts);
+        uniforms.sky_view_luts.set(sky_view_luts);
+    }
+}
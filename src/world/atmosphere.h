@@ -0,0 +1,106 @@
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+#include "graphics/material.h"
+
+class Camera;
+class ComputeShader;
+class Texture2DArray;
+
+/**
+ * \brief Precomputed single scattering of a planet atmosphere (see libs/atmosphere.cginc).
+ * The transmittance LUT only depends on the settings : it is rebuilt by a compute shader when they change. The sky view LUT depends on the viewer and on the sun,
+ * it is updated every frame while the viewer is inside the atmosphere. The lighting pass then reads the sky from a single texture fetch, and only marches the rays that hit the scene.
+ * The LUTs of every atmosphere are layers of shared texture arrays, so the lighting pass can loop over the visible atmospheres without binding anything per atmosphere.
+ */
+class Atmosphere {
+public:
+    ~Atmosphere();
+
+    static std::shared_ptr<Atmosphere> create(const std::string& name) {
+        return std::shared_ptr<Atmosphere>(new Atmosphere(name));
+    }
+
+    struct Settings {
+        float           atmosphere_depth     = 20000;
+        float           density_falloff      = 6;
+        float           scatter_strength     = 2;
+        Eigen::Vector4f scatter_coefficients = Eigen::Vector4f(700.f, 550.f, 460.f, 4.f); // xyz : wavelengths, w : scatter power
+        float           epsilon              = 1;
+
+        bool operator==(const Settings& other) const = default;
+    };
+
+    /**
+     * \brief Rebuild the transmittance LUT if the settings changed, and update the sky view LUT if the viewer is inside the atmosphere. Should be called once per frame.
+     * \param center planet center in world space
+     * \param viewer_position camera position in world space
+     */
+    void update(const Settings& settings, float planet_radius, const Eigen::Vector3f& center, const Eigen::Vector3f& viewer_position, const Eigen::Vector3f& sun_direction);
+
+    /**
+     * \brief Layout must match AtmosphereParameters in atmosphere.cginc
+     */
+    struct GpuParameters {
+        Eigen::Vector3f center;
+        float           planet_radius;
+        Eigen::Vector3f scatter_coefficients;
+        float           atmosphere_radius;
+        float           density_falloff;
+        float           epsilon;
+        int32_t         lut_layer;
+        int32_t         has_sky_view; // The sky view LUT is up to date : the viewer is inside the atmosphere
+    };
+
+    [[nodiscard]] const GpuParameters& get_parameters() const { return parameters; }
+
+    /**
+     * \brief LUT samplers of the lighting material, resolved once per shader compilation
+     */
+    struct Uniforms {
+        Uniforms() = default;
+        Uniforms(const Material& material);
+
+        UniformHandle<std::shared_ptr<TextureBase>> transmittance_luts;
+        UniformHandle<std::shared_ptr<TextureBase>> sky_view_luts;
+    };
+
+    /**
+     * \brief Bind the parameters of the atmospheres whose shell intersects the view frustum of the camera, and the LUT arrays. The material must be bound.
+     */
+    static void bind_visible(const Uniforms& uniforms, Camera& camera);
+
+    /**
+     * \brief Every existing atmosphere, in creation order
+     */
+    static const std::vector<Atmosphere*>& registry();
+
+    const std::string name;
+
+private:
+    Atmosphere(std::string name);
+
+    void invalidate_luts() { settings.reset(); }
+    void rebuild_transmittance_lut();
+    void rebuild_sky_view_lut(const Eigen::Vector3f& viewer_position, const Eigen::Vector3f& sun_direction);
+
+    /**
+     * \brief Find a free layer in the LUT arrays, and grow them if they are full
+     */
+    static int32_t allocate_lut_layer();
+
+    static constexpr uint32_t transmittance_lut_width  = 256; // cos(zenith)
+    static constexpr uint32_t transmittance_lut_height = 64;  // altitude
+    static constexpr uint32_t sky_view_lut_width       = 192; // azimuth relative to the sun
+    static constexpr uint32_t sky_view_lut_height      = 108; // elevation
+
+    std::optional<Settings>        settings;
+    GpuParameters                  parameters = {};
+    std::shared_ptr<ComputeShader> transmittance_compute;
+    std::shared_ptr<ComputeShader> sky_view_compute;
+};
@@ -0,0 +1,326 @@
+#include "landscape.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <GL/gl3w.h>
+
+#include "graphics/compute_shader.h"
+#include "graphics/storage_buffer.h"
+#include "utils/gl_tools.h"
+#include "utils/profiler.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define LANDSCAPE_SIMD_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+#define LANDSCAPE_SIMD_SSE
+#endif
+
+namespace landscape {
+namespace {
+
+/*
+ * Scalar lane
+ */
+
+inline float v_floor(float a) { return std::floor(a); }
+inline float v_min(float a, float b) { return b < a ? b : a; }
+inline float v_max(float a, float b) { return a < b ? b : a; }
+inline float v_abs(float a) { return std::abs(a); }
+// GLSL step(edge, x)
+inline float v_step(float edge, float x) { return x < edge ? 0.f : 1.f; }
+
+/*
+ * SSE lanes (4 floats)
+ */
+#if defined(LANDSCAPE_SIMD_SSE)
+struct SimdFloat {
+    static constexpr size_t width = 4;
+
+    __m128 v;
+
+    SimdFloat(__m128 in_v)
+        : v(in_v) {
+    }
+
+    SimdFloat(float f)
+        : v(_mm_set1_ps(f)) {
+    }
+
+    static SimdFloat load(const float* ptr) { return _mm_loadu_ps(ptr); }
+    void             store(float* ptr) const { _mm_storeu_ps(ptr, v); }
+
+    friend SimdFloat operator+(const SimdFloat& a, const SimdFloat& b) { return _mm_add_ps(a.v, b.v); }
+    friend SimdFloat operator-(const SimdFloat& a, const SimdFloat& b) { return _mm_sub_ps(a.v, b.v); }
+    friend SimdFloat operator*(const SimdFloat& a, const SimdFloat& b) { return _mm_mul_ps(a.v, b.v); }
+    friend SimdFloat operator/(const SimdFloat& a, const SimdFloat& b) { return _mm_div_ps(a.v, b.v); }
+    friend SimdFloat operator-(const SimdFloat& a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.f)); }
+
+    friend SimdFloat v_floor(const SimdFloat& a) {
+#if defined(__SSE4_1__)
+        return _mm_floor_ps(a.v);
+#else
+        // Values handled by the noise functions always fit in a 32 bit integer
+        const __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+        return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, a.v), _mm_set1_ps(1.f)));
+#endif
+    }
+
+    friend SimdFloat v_min(const SimdFloat& a, const SimdFloat& b) { return _mm_min_ps(a.v, b.v); }
+    friend SimdFloat v_max(const SimdFloat& a, const SimdFloat& b) { return _mm_max_ps(a.v, b.v); }
+    friend SimdFloat v_abs(const SimdFloat& a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a.v); }
+    friend SimdFloat v_step(const SimdFloat& edge, const SimdFloat& x) { return _mm_and_ps(_mm_cmpnlt_ps(x.v, edge.v), _mm_set1_ps(1.f)); }
+};
+#endif
+
+/*
+ * AVX2 lanes (8 floats)
+ */
+#if defined(LANDSCAPE_SIMD_AVX2)
+struct SimdFloat {
+    static constexpr size_t width = 8;
+
+    __m256 v;
+
+    SimdFloat(__m256 in_v)
+        : v(in_v) {
+    }
+
+    SimdFloat(float f)
+        : v(_mm256_set1_ps(f)) {
+    }
+
+    static SimdFloat load(const float* ptr) { return _mm256_loadu_ps(ptr); }
+    void             store(float* ptr) const { _mm256_storeu_ps(ptr, v); }
+
+    friend SimdFloat operator+(const SimdFloat& a, const SimdFloat& b) { return _mm256_add_ps(a.v, b.v); }
+    friend SimdFloat operator-(const SimdFloat& a, const SimdFloat& b) { return _mm256_sub_ps(a.v, b.v); }
+    friend SimdFloat operator*(const SimdFloat& a, const SimdFloat& b) { return _mm256_mul_ps(a.v, b.v); }
+    friend SimdFloat operator/(const SimdFloat& a, const SimdFloat& b) { return _mm256_div_ps(a.v, b.v); }
+    friend SimdFloat operator-(const SimdFloat& a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.f)); }
+
+    friend SimdFloat v_floor(const SimdFloat& a) { return _mm256_floor_ps(a.v); }
+    friend SimdFloat v_min(const SimdFloat& a, const SimdFloat& b) { return _mm256_min_ps(a.v, b.v); }
+    friend SimdFloat v_max(const SimdFloat& a, const SimdFloat& b) { return _mm256_max_ps(a.v, b.v); }
+    friend SimdFloat v_abs(const SimdFloat& a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a.v); }
+    friend SimdFloat v_step(const SimdFloat& edge, const SimdFloat& x) { return _mm256_and_ps(_mm256_cmp_ps(x.v, edge.v, _CMP_NLT_UQ), _mm256_set1_ps(1.f)); }
+};
+#endif
+
+/*
+ * Noise functions. These are written once for every lane type and follow the operation order of random.cginc to stay as close as possible to the GPU results.
+ */
+
+// GLSL mod(x, y)
+template <typename V> V v_mod(const V& x, float y) { return x - y * v_floor(x / y); }
+
+template <typename V> V permute(const V& x) { return v_mod((x * 34.f + 1.f) * x, 289.f); }
+
+template <typename V> V taylor_inv_sqrt(const V& r) { return 1.79284291400159f - 0.85373472095314f * r; }
+
+template <typename V> V simplex_noise(const V& vx, const V& vy, const V& vz) {
+    constexpr float c_x = 1.f / 6.f;
+    constexpr float c_y = 1.f / 3.f;
+
+    // First corner
+    const V dot_v = vx * c_y + vy * c_y + vz * c_y;
+    V       ix    = v_floor(vx + dot_v);
+    V       iy    = v_floor(vy + dot_v);
+    V       iz    = v_floor(vz + dot_v);
+    const V dot_i = ix * c_x + iy * c_x + iz * c_x;
+
+    const V x0_x = vx - ix + dot_i;
+    const V x0_y = vy - iy + dot_i;
+    const V x0_z = vz - iz + dot_i;
+
+    // Other corners
+    const V g_x  = v_step(x0_y, x0_x);
+    const V g_y  = v_step(x0_z, x0_y);
+    const V g_z  = v_step(x0_x, x0_z);
+    const V l_x  = 1.f - g_x;
+    const V l_y  = 1.f - g_y;
+    const V l_z  = 1.f - g_z;
+    const V i1_x = v_min(g_x, l_z);
+    const V i1_y = v_min(g_y, l_x);
+    const V i1_z = v_min(g_z, l_y);
+    const V i2_x = v_max(g_x, l_z);
+    const V i2_y = v_max(g_y, l_x);
+    const V i2_z = v_max(g_z, l_y);
+
+    const V x[4] = {x0_x, x0_x - i1_x + 1.f * c_x, x0_x - i2_x + 2.f * c_x, x0_x - 1.f + 3.f * c_x};
+    const V y[4] = {x0_y, x0_y - i1_y + 1.f * c_x, x0_y - i2_y + 2.f * c_x, x0_y - 1.f + 3.f * c_x};
+    const V z[4] = {x0_z, x0_z - i1_z + 1.f * c_x, x0_z - i2_z + 2.f * c_x, x0_z - 1.f + 3.f * c_x};
+
+    // Permutations
+    ix = v_mod(ix, 289.f);
+    iy = v_mod(iy, 289.f);
+    iz = v_mod(iz, 289.f);
+
+    const V offset_x[4] = {0.f, i1_x, i2_x, 1.f};
+    const V offset_y[4] = {0.f, i1_y, i2_y, 1.f};
+    const V offset_z[4] = {0.f, i1_z, i2_z, 1.f};
+
+    // Gradients ( N*N points uniformly over a square, mapped onto an octahedron.)
+    constexpr float n      = 1.f / 7.f;
+    constexpr float ns_x   = n * 2.f - 0.f;
+    constexpr float ns_y   = n * 0.5f - 1.f;
+    constexpr float ns_z   = n * 1.f - 0.f;
+    V               result = 0.f;
+    for (int corner = 0; corner < 4; ++corner) {
+        const V p = permute(permute(permute(iz + offset_z[corner]) + iy + offset_y[corner]) + ix + offset_x[corner]);
+
+        const V j      = p - 49.f * v_floor(p * ns_z * ns_z);
+        const V x_     = v_floor(j * ns_z);
+        const V y_     = v_floor(j - 7.f * x_);
+        const V grad_x = x_ * ns_x + ns_y;
+        const V grad_y = y_ * ns_x + ns_y;
+        const V h      = 1.f - v_abs(grad_x) - v_abs(grad_y);
+        const V sh     = -v_step(h, 0.f);
+
+        V p_x = grad_x + (v_floor(grad_x) * 2.f + 1.f) * sh;
+        V p_y = grad_y + (v_floor(grad_y) * 2.f + 1.f) * sh;
+        V p_z = h;
+
+        // Normalise gradients
+        const V norm = taylor_inv_sqrt(p_x * p_x + p_y * p_y + p_z * p_z);
+        p_x          = p_x * norm;
+        p_y          = p_y * norm;
+        p_z          = p_z * norm;
+
+        // Mix final noise value
+        V m    = v_max(0.6f - (x[corner] * x[corner] + y[corner] * y[corner] + z[corner] * z[corner]), 0.f);
+        m      = m * m;
+        result = result + m * m * (p_x * x[corner] + p_y * y[corner] + p_z * z[corner]);
+    }
+    return 42.f * result;
+}
+
+// Simplex noise using octaves
+template <typename V> V simplex_noise(const V& x, const V& y, const V& z, int octaves, float persistance, float lacunarity) {
+    float amplitude = 1;
+    float frequency = 1;
+    V     height    = 0.f;
+
+    for (int i = 0; i < octaves; ++i) {
+        height = height + simplex_noise<V>(x * frequency, y * frequency, z * frequency) * amplitude;
+        amplitude *= persistance;
+        frequency *= lacunarity;
+    }
+
+    return height;
+}
+
+// get_height_at_location_v2()
+template <typename V> V height_at_location(const V& x, const V& y, const V& z) {
+    return simplex_noise<V>(x + 1.f, y + 1.005f, z + 0.f, 17, 0.65f, 1.75f) * 30000.f;
+}
+}
+
+float height_at_location(const Eigen::Vector3f& planet_space_normal) {
+    return height_at_location<float>(planet_space_normal.x(), planet_space_normal.y(), planet_space_normal.z());
+}
+
+void height_at_locations(const float* x, const float* y, const float* z, float* heights, size_t count) {
+    size_t i = 0;
+#if defined(LANDSCAPE_SIMD_SSE) || defined(LANDSCAPE_SIMD_AVX2)
+    for (; i + SimdFloat::width <= count; i += SimdFloat::width)
+        height_at_location<SimdFloat>(SimdFloat::load(x + i), SimdFloat::load(y + i), SimdFloat::load(z + i)).store(heights + i);
+#endif
+    // Remaining items
+    for (; i < count; ++i)
+        heights[i] = height_at_location<float>(x[i], y[i], z[i]);
+}
+
+void height_at_locations(const std::vector<Eigen::Vector3f>& planet_space_normals, std::vector<float>& heights) {
+    const size_t       count = planet_space_normals.size();
+    std::vector<float> x(count), y(count), z(count);
+    for (size_t i = 0; i < count; ++i) {
+        x[i] = planet_space_normals[i].x();
+        y[i] = planet_space_normals[i].y();
+        z[i] = planet_space_normals[i].z();
+    }
+    heights.resize(count);
+    height_at_locations(x.data(), y.data(), z.data(), heights.data(), count);
+}
+
+const char* simd_backend_name() {
+#if defined(LANDSCAPE_SIMD_AVX2)
+    return "AVX2";
+#elif defined(LANDSCAPE_SIMD_SSE) && defined(__SSE4_1__)
+    return "SSE4.1";
+#elif defined(LANDSCAPE_SIMD_SSE)
+    return "SSE2";
+#else
+    return "Scalar";
+#endif
+}
+
+ValidationResult validate_against_gpu(int grid_resolution) {
+    STAT_ACTION("Validate CPU landscape heights ({}x{})", grid_resolution, grid_resolution);
+    ValidationResult result;
+    if (grid_resolution < 2)
+        return result;
+
+    // Build latitude / longitude grid
+    std::vector<Eigen::Vector3f> directions;
+    std::vector<Eigen::Vector4f> gpu_directions;
+    directions.reserve(static_cast<size_t>(grid_resolution) * grid_resolution);
+    gpu_directions.reserve(static_cast<size_t>(grid_resolution) * grid_resolution);
+    for (int lat = 0; lat < grid_resolution; ++lat)
+        for (int lon = 0; lon < grid_resolution; ++lon) {
+            const double latitude  = (lat / static_cast<double>(grid_resolution - 1) - 0.5) * M_PI;
+            const double longitude = lon / static_cast<double>(grid_resolution) * 2 * M_PI;
+            const auto   direction = Eigen::Vector3f(Eigen::Vector3d(std::cos(latitude) * std::cos(longitude), std::cos(latitude) * std::sin(longitude), std::sin(latitude)).cast<float>());
+            directions.emplace_back(direction);
+            gpu_directions.emplace_back(direction.x(), direction.y(), direction.z(), 0.f);
+        }
+    result.sample_count = directions.size();
+
+    // CPU evaluation
+    std::vector<float> cpu_heights;
+    auto               begin = std::chrono::steady_clock::now();
+    height_at_locations(directions, cpu_heights);
+    result.cpu_milliseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count() / 1000.0;
+
+    begin = std::chrono::steady_clock::now();
+    for (const auto& direction : directions)
+        height_at_location(direction);
+    result.cpu_scalar_milliseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count() / 1000.0;
+
+    // GPU evaluation
+    const auto probe_shader = ComputeShader::create("Landscape height probe", "resources/shaders/compute/landscape_height_probe.cs");
+    const auto input        = StorageBuffer::create("Landscape probe directions");
+    const auto output       = StorageBuffer::create("Landscape probe heights");
+    input->set_data_raw(gpu_directions.data(), gpu_directions.size() * sizeof(Eigen::Vector4f));
+    output->set_data_raw(nullptr, directions.size() * sizeof(float));
+
+    probe_shader->bind();
+    if (probe_shader->compilation_error)
+        return result;
+    GL_CHECK_ERROR();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, input->id());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, output->id());
+    probe_shader->execute(static_cast<int>(directions.size()), 1, 1);
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    std::vector<float> gpu_heights(directions.size());
+    output->get_data_raw(gpu_heights.data(), gpu_heights.size() * sizeof(float));
+    GL_CHECK_ERROR();
+
+    // Compare
+    double error_sum = 0;
+    for (size_t i = 0; i < directions.size(); ++i) {
+        const float error = std::abs(cpu_heights[i] - gpu_heights[i]);
+        result.max_error  = std::max(result.max_error, error);
+        error_sum += error;
+    }
+    result.mean_error = static_cast<float>(error_sum / static_cast<double>(directions.size()));
+    result.valid      = true;
+    return result;
+}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <vector>
+
+/**
+ * \brief CPU implementation of the terrain height function.
+ * This is a mirror of resources/shaders/libs/landscape.cginc : any change made to the shader must be reported here.
+ */
+namespace landscape {
+
+/**
+ * \brief Scale applied to the height function by planet_compute_position.cs before storing it into the chunk heightmaps.
+ */
+constexpr float height_map_scale = 0.2f;
+
+/**
+ * \brief Upper bound of |height_at_location() * height_map_scale| (sum of the octave amplitudes, simplex noise being in [-1, 1])
+ */
+constexpr float max_altitude = [] {
+    float amplitude = 1, sum = 0;
+    for (int i = 0; i < 17; ++i, amplitude *= 0.65f)
+        sum += amplitude;
+    return sum * 30000.f * height_map_scale;
+}();
+
+/**
+ * \brief Same as get_height_at_location_v2() (landscape.cginc)
+ * \param planet_space_normal normalized direction from the planet center, in planet space
+ */
+float height_at_location(const Eigen::Vector3f& planet_space_normal);
+
+/**
+ * \brief Evaluate the height function for a batch of directions using SIMD lanes when available.
+ * \param x,y,z normalized directions from the planet center (structure of arrays)
+ * \param heights output buffer (count elements)
+ */
+void height_at_locations(const float* x, const float* y, const float* z, float* heights, size_t count);
+
+void height_at_locations(const std::vector<Eigen::Vector3f>& planet_space_normals, std::vector<float>& heights);
+
+/**
+ * \brief Name of the instruction set used by the batch API. (selected at compile time)
+ */
+const char* simd_backend_name();
+
+struct ValidationResult {
+    size_t sample_count            = 0;
+    float  max_error               = 0;
+    float  mean_error              = 0;
+    double cpu_milliseconds        = 0;
+    double cpu_scalar_milliseconds = 0;
+    bool   valid                   = false;
+};
+
+/**
+ * \brief Compare CPU heights with the GLSL output on a latitude / longitude grid.
+ * The GPU values are computed by resources/shaders/compute/landscape_height_probe.cs. Require a valid OpenGL context.
+ * \param grid_resolution number of samples along each axis
+ */
+ValidationResult validate_against_gpu(int grid_resolution);
+}
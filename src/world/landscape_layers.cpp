@@ -0,0 +1,134 @@
+#include "landscape_layers.h"
+
+#include <GL/gl3w.h>
+#include <GLFW/glfw3.h>
+
+#include "graphics/storage_buffer.h"
+#include "graphics/texture_image.h"
+#include "utils/gl_tools.h"
+#include "utils/profiler.h"
+
+// GL_ARB_bindless_texture entry points are not loaded by gl3w
+static PFNGLGETTEXTUREHANDLEARBPROC             get_texture_handle_arb             = nullptr;
+static PFNGLMAKETEXTUREHANDLERESIDENTARBPROC    make_texture_handle_resident_arb    = nullptr;
+static PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC make_texture_handle_non_resident_arb = nullptr;
+
+bool LandscapeLayers::is_bindless_supported() {
+    static bool supported = [] {
+        if (!glfwExtensionSupported("GL_ARB_bindless_texture"))
+            return false;
+        get_texture_handle_arb               = reinterpret_cast<PFNGLGETTEXTUREHANDLEARBPROC>(glfwGetProcAddress("glGetTextureHandleARB"));
+        make_texture_handle_resident_arb     = reinterpret_cast<PFNGLMAKETEXTUREHANDLERESIDENTARBPROC>(glfwGetProcAddress("glMakeTextureHandleResidentARB"));
+        make_texture_handle_non_resident_arb = reinterpret_cast<PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC>(glfwGetProcAddress("glMakeTextureHandleNonResidentARB"));
+        return get_texture_handle_arb && make_texture_handle_resident_arb && make_texture_handle_non_resident_arb;
+    }();
+    return supported;
+}
+
+LandscapeLayers::LandscapeLayers(std::string in_name)
+    : name(std::move(in_name)), bindless(is_bindless_supported()) {
+    layer_buffer = StorageBuffer::create(name);
+    glCreateFramebuffers(2, copy_framebuffers);
+}
+
+LandscapeLayers::~LandscapeLayers() {
+    for (const auto& handle : resident_handles)
+        make_texture_handle_non_resident_arb(handle);
+    glDeleteFramebuffers(2, copy_framebuffers);
+}
+
+void LandscapeLayers::add_layer(const Layer& layer) {
+    layers.emplace_back(layer);
+    gpu_layers.emplace_back(GpuLayer{
+        .albedo = 0,
+        .normal = 0,
+        .mrao_scale = Eigen::Vector4f(layer.mrao.x(), layer.mrao.y(), layer.mrao.z(), layer.texture_scale),
+        .blend = Eigen::Vector4f(layer.slope_range.x(), layer.slope_range.y(), layer.altitude_range.x(), layer.altitude_range.y()),
+        .flags = 0,
+        .padding = {0, 0, 0},
+    });
+    dirty = true;
+}
+
+void LandscapeLayers::update() {
+    if (!bindless && atlas_capacity < layers.size())
+        resize_atlases();
+
+    bool atlas_changed = false;
+    for (size_t i = 0; i < layers.size(); ++i) {
+        auto&          gpu_layer = gpu_layers[i];
+        const uint32_t layer     = static_cast<uint32_t>(i);
+        if (!(gpu_layer.flags & layer_has_albedo) && layers[i].albedo && resolve_texture(*layers[i].albedo, albedo_atlas, layer, gpu_layer.albedo)) {
+            gpu_layer.flags |= layer_has_albedo;
+            atlas_changed = true;
+        }
+        if (!(gpu_layer.flags & layer_has_normal) && layers[i].normal && resolve_texture(*layers[i].normal, normal_atlas, layer, gpu_layer.normal)) {
+            gpu_layer.flags |= layer_has_normal;
+            atlas_changed = true;
+        }
+    }
+    dirty |= atlas_changed;
+
+    if (!bindless && atlas_changed) {
+        glGenerateTextureMipmap(albedo_atlas->id());
+        glGenerateTextureMipmap(normal_atlas->id());
+    }
+
+    if (dirty && !gpu_layers.empty()) {
+        STAT_ACTION("Upload landscape layers [{}]", name);
+        layer_buffer->set_data_raw(gpu_layers.data(), gpu_layers.size() * sizeof(GpuLayer));
+        dirty = false;
+    }
+    GL_CHECK_ERROR();
+}
+
+LandscapeLayers::Uniforms::Uniforms(const Material& material)
+    : albedo_atlas(material.uniform<std::shared_ptr<TextureBase>>("layer_albedo_atlas")),
+      normal_atlas(material.uniform<std::shared_ptr<TextureBase>>("layer_normal_atlas")) {
+}
+
+void LandscapeLayers::bind(const Uniforms& uniforms) const {
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, layer_buffer->id());
+    if (!bindless) {
+        uniforms.albedo_atlas.set(albedo_atlas);
+        uniforms.normal_atlas.set(normal_atlas);
+    }
+}
+
+bool LandscapeLayers::resolve_texture(Texture2D& texture, const std::shared_ptr<Texture2DArray>& atlas, uint32_t layer, uint64_t& reference) {
+    // id() finishes the upload of asynchronously loaded textures
+    const uint32_t texture_id = texture.id();
+    if (texture.width() == 0 || texture.height() == 0)
+        return false;
+
+    if (bindless) {
+        // The texture is immutable once a handle was created
+        reference = get_texture_handle_arb(texture_id);
+        if (reference == 0)
+            return false;
+        make_texture_handle_resident_arb(reference);
+        resident_handles.emplace_back(reference);
+        return true;
+    }
+
+    // Resample the texture into its atlas layer
+    glNamedFramebufferTexture(copy_framebuffers[0], GL_COLOR_ATTACHMENT0, texture_id, 0);
+    glNamedFramebufferTextureLayer(copy_framebuffers[1], GL_COLOR_ATTACHMENT0, atlas->id(), 0, static_cast<int>(layer));
+    glBlitNamedFramebuffer(copy_framebuffers[0], copy_framebuffers[1], 0, 0, static_cast<int>(texture.width()), static_cast<int>(texture.height()), 0, 0, atlas_resolution,
+                           atlas_resolution, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    GL_CHECK_ERROR();
+    reference = layer;
+    return true;
+}
+
+void LandscapeLayers::resize_atlases() {
+    atlas_capacity = static_cast<uint32_t>(layers.size());
+    albedo_atlas   = Texture2DArray::create(name + " albedo atlas", {.srgb = true});
+    albedo_atlas->set_data(atlas_resolution, atlas_resolution, atlas_capacity, ImageFormat::RGBA_U8);
+    normal_atlas = Texture2DArray::create(name + " normal atlas");
+    normal_atlas->set_data(atlas_resolution, atlas_resolution, atlas_capacity, ImageFormat::RGBA_U8);
+
+    // Previous atlases content is lost : copy every layer again
+    for (auto& gpu_layer : gpu_layers)
+        gpu_layer.flags = 0;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+#include "graphics/material.h"
+
+class StorageBuffer;
+class Texture2D;
+class Texture2DArray;
+
+/**
+ * \brief Surface layers blended by the landscape material (see libs/landscape_layers.cginc).
+ * Layer textures are referenced by GL_ARB_bindless_texture handles stored in a storage buffer : no texture is bound per draw, and adding a layer doesn't need a new sampler.
+ * When the extension is not available, the textures are copied into texture array atlases and the buffer stores atlas layers instead.
+ */
+class LandscapeLayers {
+public:
+    ~LandscapeLayers();
+
+    static std::shared_ptr<LandscapeLayers> create(const std::string& name) {
+        return std::shared_ptr<LandscapeLayers>(new LandscapeLayers(name));
+    }
+
+    struct Layer {
+        std::string                name;
+        std::shared_ptr<Texture2D> albedo;
+        std::shared_ptr<Texture2D> normal;
+        float                      texture_scale  = 40;
+        Eigen::Vector3f            mrao           = {0, 1, 1}; // metalness, roughness, ambient occlusion
+        Eigen::Vector2f            slope_range    = {0, 0};    // Weight ramp from start to end of the slope (0 = flat). No ramp if start == end.
+        Eigen::Vector2f            altitude_range = {0, 0};    // Weight ramp from start to end of the altitude. No ramp if start == end.
+    };
+
+    /**
+     * \brief Layers are blended in order : each one is mixed over the result of the previous ones.
+     */
+    void add_layer(const Layer& layer);
+
+    [[nodiscard]] const std::vector<Layer>& get_layers() const { return layers; }
+
+    /**
+     * \brief Make the textures that finished loading available to the shader, and upload the layer buffer if it changed. Should be called once per frame.
+     */
+    void update();
+
+    /**
+     * \brief Atlas samplers of the fallback path, resolved once per shader compilation
+     */
+    struct Uniforms {
+        Uniforms() = default;
+        Uniforms(const Material& material);
+
+        UniformHandle<std::shared_ptr<TextureBase>> albedo_atlas;
+        UniformHandle<std::shared_ptr<TextureBase>> normal_atlas;
+    };
+
+    /**
+     * \brief Bind the layer buffer (and the atlases without bindless support). The material must be bound.
+     */
+    void bind(const Uniforms& uniforms) const;
+
+    /**
+     * \brief Is GL_ARB_bindless_texture supported by the current context
+     */
+    [[nodiscard]] static bool is_bindless_supported();
+
+    const std::string name;
+
+private:
+    LandscapeLayers(std::string name);
+
+    /**
+     * \brief Layout must match LandscapeLayer in landscape_layers.cginc
+     */
+    struct GpuLayer {
+        uint64_t        albedo; // Bindless handle, or atlas layer
+        uint64_t        normal;
+        Eigen::Vector4f mrao_scale; // xyz : mrao, w : texture scale
+        Eigen::Vector4f blend;      // xy : slope range, zw : altitude range
+        uint32_t        flags;
+        uint32_t        padding[3];
+    };
+
+    static constexpr uint32_t layer_has_albedo = 1;
+    static constexpr uint32_t layer_has_normal = 2;
+    static constexpr uint32_t atlas_resolution = 1024;
+
+    /**
+     * \brief Get a reference to the texture usable by the shader. Return false if the texture is not loaded yet.
+     */
+    bool resolve_texture(Texture2D& texture, const std::shared_ptr<Texture2DArray>& atlas, uint32_t layer, uint64_t& reference);
+    void resize_atlases();
+
+    std::vector<Layer>              layers;
+    std::vector<GpuLayer>           gpu_layers;
+    std::vector<uint64_t>           resident_handles;
+    std::shared_ptr<StorageBuffer>  layer_buffer;
+    std::shared_ptr<Texture2DArray> albedo_atlas;
+    std::shared_ptr<Texture2DArray> normal_atlas;
+    uint32_t                        atlas_capacity = 0;
+    uint32_t                        copy_framebuffers[2];
+    bool                            bindless;
+    bool                            dirty = true;
+};
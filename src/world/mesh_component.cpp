@@ -7,6 +7,7 @@
 #include "engine/engine.h"
 #include "engine/renderer.h"
 #include "graphics/camera.h"
+#include "graphics/gl_state.h"
 #include "graphics/mesh.h"
 #include "graphics/material.h"
 #include "utils/game_settings.h"
@@ -18,14 +19,14 @@ void MeshComponent::render(Camera& camera, const DrawGroup& draw_group, const st
         return;
 
     if (GameSettings::get().wireframe)
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        GlState::get().set_polygon_mode(GL_LINE);
 
     material->bind();
     auto transform = get_world_transform();
     transform.translate(-camera.get_world_position());
-    material->set_model_transform(transform);
+    model_uniform.set(transform);
     mesh->draw();
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    GlState::get().set_polygon_mode(GL_FILL);
 }
 
 void MeshComponent::draw_ui() {
@@ -1,8 +1,8 @@
 #pragma once
 
 #include "scene_component.h"
+#include "graphics/material.h"
 
-class Material;
 class Mesh;
 
 class MeshComponent : public SceneComponent {
@@ -17,7 +17,8 @@ public:
 	}
 
 	void set_material(const std::shared_ptr<Material>& in_material) {
-		material = in_material;
+		material      = in_material;
+		model_uniform = material ? material->uniform<Eigen::Affine3d>("model") : UniformHandle<Eigen::Affine3d>();
 	}
 
 	[[nodiscard]] const std::shared_ptr<Mesh>& get_mesh() const {
@@ -35,4 +36,5 @@ public:
 private:
 	std::shared_ptr<Material> material;
 	std::shared_ptr<Mesh> mesh;
+	UniformHandle<Eigen::Affine3d> model_uniform;
 };
\ No newline at end of file
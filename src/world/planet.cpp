@@ -3,20 +3,59 @@
 #include "graphics/camera.h"
 #include "planet.h"
 
+#include "landscape.h"
 #include "planet_chunk.h"
+#include "planet_grid.h"
+#include "graphics/texture_readback.h"
 
 #include <imgui.h>
 
 #include "engine/renderer.h"
+#include "graphics/buffer_arena.h"
 #include "graphics/compute_shader.h"
+#include "graphics/gl_state.h"
+#include "graphics/gpu_profiler.h"
+#include "graphics/gpu_timer.h"
 #include "graphics/material.h"
 #include "graphics/mesh.h"
 #include "graphics/texture_image.h"
 #include "ui/widgets.h"
+#include "utils/game_settings.h"
 #include "utils/gl_tools.h"
 #include "utils/maths.h"
 #include "utils/profiler.h"
 
+// Shared by every planet : a texture can only have one resident bindless handle
+static std::shared_ptr<LandscapeLayers> get_default_landscape_layers() {
+    static std::weak_ptr<LandscapeLayers> default_layers;
+    if (auto layers = default_layers.lock())
+        return layers;
+
+    auto layers = LandscapeLayers::create("terrain layers");
+    layers->add_layer({
+        .name = "grass",
+        .albedo = Texture2D::create("terrain grass albedo", "resources/textures/terrain/wispy-grass-meadow_albedo.png", {.srgb = true}),
+        .normal = Texture2D::create("terrain grass normal", "resources/textures/terrain/wispy-grass-meadow_normal-dx.png"),
+        .mrao = {0, 0.7f, 0},
+    });
+    layers->add_layer({
+        .name = "rock",
+        .albedo = Texture2D::create("terrain rock albedo", "resources/textures/terrain/pine_forest_ground1_albedo.png", {.srgb = true}),
+        .normal = Texture2D::create("terrain rock normal", "resources/textures/terrain/pine_forest_ground1_Normal-dx.png"),
+        .mrao = {0, 0.9f, 0},
+        .slope_range = {0, 1},
+    });
+    layers->add_layer({
+        .name = "sand",
+        .albedo = Texture2D::create("terrain sand albedo", "resources/textures/terrain/wavy-sand_albedo.png", {.srgb = true}),
+        .normal = Texture2D::create("terrain sand normal", "resources/textures/terrain/wavy-sand_normal-dx.png"),
+        .mrao = {0.2f, 0.7f, 0},
+        .altitude_range = {10, 8}, // Beach
+    });
+    default_layers = layers;
+    return layers;
+}
+
 Planet::Planet(const std::string& name, const std::shared_ptr<SceneComponent>& in_player)
     : SceneComponent(name), player(in_player) {
     root  = std::make_shared<PlanetChunk>(*this, 16, 0);
@@ -26,6 +65,10 @@ Planet::Planet(const std::string& name, const std::shared_ptr<SceneComponent>& i
     compute_fix_seams = ComputeShader::create("Planet Fix Seams", "resources/shaders/compute/planet_fix_seams.cs");
     compute_normals   = ComputeShader::create("Planet compute normals", "resources/shaders/compute/planet_compute_normals.cs");
 
+    compute_positions_timer = GpuTimer::create("Planet compute position");
+    compute_fix_seams_timer = GpuTimer::create("Planet Fix Seams");
+    compute_normals_timer   = GpuTimer::create("Planet compute normals");
+
     compute_positions->on_reload.add_object(root.get(), &PlanetChunk::force_rebuild_maps);
     compute_fix_seams->on_reload.add_object(root.get(), &PlanetChunk::force_rebuild_maps);
     compute_normals->on_reload.add_object(root.get(), &PlanetChunk::force_rebuild_maps);
@@ -33,24 +76,18 @@ Planet::Planet(const std::string& name, const std::shared_ptr<SceneComponent>& i
     landscape_material            = Material::create("planet material", "resources/shaders/planet_material.vs", "resources/shaders/planet_material.fs");
     debug_normal_display_material = Material::create("planet material normals", "resources/shaders/planet_material.vs", "resources/shaders/planet_material_normal_display.fs",
                                                      "resources/shaders/planet_material_normal_display.gs");
+    landscape_uniforms            = LandscapeUniforms(*landscape_material);
+    debug_normal_display_uniforms = LandscapeUniforms(*debug_normal_display_material);
 
-    grass_albedo = Texture2D::create("terrain grass albedo", "resources/textures/terrain/wispy-grass-meadow_albedo.png", {.srgb = true});
-    grass_normal = Texture2D::create("terrain grass normal", "resources/textures/terrain/wispy-grass-meadow_normal-dx.png");
-    grass_mrao   = Texture2D::create("terrain grass mrao", "resources/textures/terrain/wispy-grass-meadow_mrao.jpg");
-
-    rock_albedo = Texture2D::create("terrain rock albedo", "resources/textures/terrain/pine_forest_ground1_albedo.png", {.srgb = true});
-    rock_normal = Texture2D::create("terrain rock normal", "resources/textures/terrain/pine_forest_ground1_Normal-dx.png");
-    rock_mrao   = Texture2D::create("terrain rock mrao", "resources/textures/terrain/pine_forest_ground1_mrao.jpg");
+    landscape_layers = get_default_landscape_layers();
+}
 
-    sand_albedo = Texture2D::create("terrain sand albedo", "resources/textures/terrain/wavy-sand_albedo.png", {.srgb = true});
-    sand_normal = Texture2D::create("terrain sand normal", "resources/textures/terrain/wavy-sand_normal-dx.png");
-    sand_mrao   = Texture2D::create("terrain sand mrao", "resources/textures/terrain/wavy-sand_mrao.jpg");
 
-    water_normal       = Texture2D::create("water normal", "resources/textures/water/water_normal_3.jpg");
-    water_displacement = Texture2D::create("water displacement", "resources/textures/water/water_distortion.png");
+Planet::~Planet() {
+    if (grid)
+        grid->unregister_planet(this);
 }
 
-
 std::shared_ptr<Planet> Planet::create(const std::string& name, const std::shared_ptr<SceneComponent>& player) {
     return std::shared_ptr<Planet>(new Planet(name, player));
 }
@@ -58,7 +95,8 @@ std::shared_ptr<Planet> Planet::create(const std::string& name, const std::share
 void Planet::draw_ui() {
     SceneComponent::draw_ui();
     ImGui::Text("Mesh");
-    ImGui::SliderInt("num LODs : ", &num_lods, 1, 40);
+    if (ImGui::SliderInt("num LODs : ", &num_lods, 1, 40))
+        dirty = true;
     ImGui::DragFloat("radius : ", &radius, 10);
     if (ImGui::SliderInt("cell number", &cell_count, 1, 120) ||
         ImGui::SliderFloat("cell_width : ", &cell_width, 0.05f, 10))
@@ -68,7 +106,7 @@ void Planet::draw_ui() {
     ImGui::Text("Atmosphere");
     ImGui::Checkbox("enable", &enable_atmosphere);
     if (enable_atmosphere) {
-        ImGui::DragFloat("Depth", &atmosphere_settings.density_falloff, 100);
+        ImGui::DragFloat("Depth", &atmosphere_settings.atmosphere_depth, 100);
         ImGui::SliderFloat("Density Falloff", &atmosphere_settings.density_falloff, 0.01f, 12);
         ImGui::SliderFloat("Scatter strength", &atmosphere_settings.scatter_strength, 0.01f, 10);
 
@@ -87,126 +125,122 @@ void Planet::draw_ui() {
     ImGui::Checkbox("Double sided", &double_sided);
     ImGui::Checkbox("Freeze Camera", &freeze_camera);
     ImGui::Checkbox("Freeze Updates", &freeze_updates);
+    ImGui::Checkbox("Tile culling", &tile_culling);
     ImGui::DragFloat4("debug vector", debug_vector.data());
+
+    static landscape::ValidationResult validation;
+    ImGui::SliderInt("validation grid", &validation_grid, 2, 1024);
+    if (ImGui::Button("Compare CPU / GPU heights"))
+        validation = landscape::validate_against_gpu(validation_grid);
+    if (validation.valid) {
+        ImGui::Text("%d samples : max error = %f, mean error = %f", static_cast<int>(validation.sample_count), validation.max_error, validation.mean_error);
+        ImGui::Text("CPU batch (%s) : %.3f ms / scalar : %.3f ms", landscape::simd_backend_name(), validation.cpu_milliseconds, validation.cpu_scalar_milliseconds);
+    }
     ui::rotation_edit(mesh_rotation_ws, "camera rotation");
-}
 
-static void generate_rectangle_area(std::vector<uint32_t>& indices, std::vector<Eigen::Vector3f>& positions,
-                                    int32_t                x_min, int32_t                         x_max,
-                                    int32_t                z_min, int32_t                         z_max,
-                                    int32_t                cell_min, int32_t                      cell_max) {
-    // Requirement for Y val
-    const auto distance_max = static_cast<float>(cell_max);
-    auto       min_global   = static_cast<float>(cell_min);
-
-    // Handle LOD 0 case
-    if (abs(min_global - distance_max) < 0.0001)
-        min_global = 0;
-
-    const auto current_index_offset = static_cast<uint32_t>(positions.size());
-    for (int32_t z = z_min; z <= z_max; ++z)
-        for (int32_t x = x_min; x <= x_max; ++x) {
-            // The Y val is used to store the progression from previous LOD to the next one
-            const float linf_distance = static_cast<float>(std::max(std::abs(x), std::abs(z))); // Tchebychev distance
-            const float y_val_weight  = (linf_distance - min_global) / (distance_max - min_global);
-            const bool  x_aligned     = std::abs(x) > std::abs(z);
-            const int   mask          = std::abs(x) % 2 == 0 && !x_aligned || std::abs(z) % 2 == 0 && x_aligned;
-            positions.emplace_back(Eigen::Vector3f(static_cast<float>(x), mask * y_val_weight, static_cast<float>(z)));
+    if (ImGui::Button("Rebuild all maps"))
+        root->force_rebuild_maps();
+    // Fixed seams are baked in the heightmaps : switching mode requires regenerating them
+    if (ImGui::Checkbox("Geomorphing", &geomorphing))
+        root->force_rebuild_maps();
+    ImGui::DragInt("Map update texel budget", &map_update_texel_budget, 1024, 1, 16 * 1024 * 1024);
+    ImGui::SliderFloat("Map update GPU budget (ms)", &map_update_budget_ms, 0, 16);
+    if (ImGui::BeginTable("Map generation", 3)) {
+        ImGui::TableSetupColumn("GPU pass");
+        ImGui::TableSetupColumn("last");
+        ImGui::TableSetupColumn("average");
+        ImGui::TableHeadersRow();
+        for (const auto& timer : {compute_positions_timer, compute_fix_seams_timer, compute_normals_timer}) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%s", timer->name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f ms", timer->last_ms());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f ms", timer->average_ms());
         }
+        ImGui::EndTable();
+    }
 
-    const uint32_t x_width = std::abs(x_max - x_min);
-    const uint32_t z_width = std::abs(z_max - z_min);
-    for (uint32_t z = 0; z < z_width; ++z)
-        for (uint32_t x = 0; x < x_width; ++x) {
-            uint32_t base_index = x + z * (x_width + 1) + current_index_offset;
-            if (positions[base_index].x() * positions[base_index].z() > 0) {
-                indices.emplace_back(base_index);
-                indices.emplace_back(base_index + x_width + 2);
-                indices.emplace_back(base_index + x_width + 1);
-                indices.emplace_back(base_index);
-                indices.emplace_back(base_index + 1);
-                indices.emplace_back(base_index + x_width + 2);
-            } else {
-                indices.emplace_back(base_index);
-                indices.emplace_back(base_index + 1);
-                indices.emplace_back(base_index + x_width + 1);
-                indices.emplace_back(base_index + 1);
-                indices.emplace_back(base_index + x_width + 2);
-                indices.emplace_back(base_index + x_width + 1);
-            }
+    ImGui::Checkbox("Height readback", &enable_height_readback);
+    if (enable_height_readback && ImGui::BeginTable("Height readback", 5)) {
+        ImGui::TableSetupColumn("LOD");
+        ImGui::TableSetupColumn("in flight");
+        ImGui::TableSetupColumn("latency");
+        ImGui::TableSetupColumn("transferred");
+        ImGui::TableSetupColumn("dropped");
+        ImGui::TableHeadersRow();
+        int lod = 0;
+        for (const PlanetChunk* chunk = root.get(); chunk; chunk = chunk->get_child().get(), ++lod) {
+            const auto& readback = chunk->get_height_readback();
+            if (!readback)
+                continue;
+            const auto& stats = readback->get_stats();
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", lod);
+            ImGui::TableNextColumn();
+            ImGui::Text("%d / %d", static_cast<int>(readback->in_flight()), static_cast<int>(readback->capacity()));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f ms (%d frames)", stats.last_latency_ms, static_cast<int>(stats.last_latency_frames));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f Mb", static_cast<double>(stats.bytes_transferred) / (1024.0 * 1024.0));
+            ImGui::TableNextColumn();
+            ImGui::Text("%d", static_cast<int>(stats.dropped));
         }
+        ImGui::EndTable();
+    }
 }
 
-void Planet::rebuild_mesh() {
-    GL_CHECK_ERROR();
-    STAT_ACTION("Generate planet mesh : [" + name + "]");
-    STAT_FRAME("rebuild_mesh planet mesh");
+const PlanetChunk::HeightTile* Planet::try_get_heights(uint32_t lod) const {
+    const PlanetChunk* chunk = root.get();
+    for (uint32_t i = 0; chunk && i < lod; ++i)
+        chunk = chunk->get_child().get();
+    return chunk ? chunk->try_get_heights() : nullptr;
+}
 
-    {
-        STAT_ACTION("rebuild_mesh root mesh");
-        std::vector<uint32_t>        indices_root;
-        std::vector<Eigen::Vector3f> positions_root;
-        generate_rectangle_area(indices_root, positions_root,
-                                -cell_count * 2 - 1,
-                                cell_count * 2 + 1,
-                                -cell_count * 2 - 1,
-                                cell_count * 2 + 1,
-                                0, cell_count * 2);
-
-        root_mesh = Mesh::create("planet root mesh");
-        root_mesh->set_positions(positions_root, 0, true);
-        root_mesh->set_indices(indices_root);
-    }
+double Planet::get_ground_altitude(const Eigen::Vector3d& planet_space_direction) const {
+    return landscape::height_at_location(planet_space_direction.normalized().cast<float>()) * landscape::height_map_scale;
+}
 
+void Planet::get_ground_altitudes(const std::vector<Eigen::Vector3f>& planet_space_directions, std::vector<float>& altitudes) const {
+    landscape::height_at_locations(planet_space_directions, altitudes);
+    for (auto& altitude : altitudes)
+        altitude *= landscape::height_map_scale;
+}
+
+void Planet::rebuild_mesh() {
     GL_CHECK_ERROR();
+    STAT_ACTION("Generate planet mesh : [{}]", name);
 
-    {
-        STAT_ACTION("Generate planet mesh vertices : [" + name + "]");
-        std::vector<uint32_t>        indices_child;
-        std::vector<Eigen::Vector3f> positions_child;
-        // TOP side (larger)
-        generate_rectangle_area(indices_child, positions_child,
-                                cell_count,
-                                cell_count * 2 + 1,
-                                -cell_count - 1,
-                                cell_count * 2 + 1,
-                                cell_count, cell_count * 2 + 1);
-
-        // RIGHT side (larger)
-        generate_rectangle_area(indices_child, positions_child,
-                                -cell_count * 2 - 1,
-                                cell_count,
-                                cell_count,
-                                cell_count * 2 + 1,
-                                cell_count, cell_count * 2 + 1);
-
-        // BOTTOM side
-        generate_rectangle_area(indices_child, positions_child,
-                                -cell_count * 2 - 1,
-                                -cell_count - 1,
-                                -cell_count * 2 - 1,
-                                cell_count,
-                                cell_count + 1, cell_count * 2 + 1);
-
-        // LEFT side
-        generate_rectangle_area(indices_child, positions_child,
-                                -cell_count - 1,
-                                cell_count * 2 + 1,
-                                -cell_count * 2 - 1,
-                                -cell_count - 1, cell_count + 1, cell_count * 2 + 1);
-        child_mesh = Mesh::create("planet child mesh");
-        child_mesh->set_positions(positions_child, 0, true);
-        child_mesh->set_indices(indices_child);
+    // Grid meshes and maps are shared by all the planets with the same cell count
+    if (grid && grid->cell_count != cell_count) {
+        grid->unregister_planet(this);
+        grid = nullptr;
     }
+    if (!grid)
+        grid = PlanetGrid::get(cell_count);
+    grid->register_planet(this, std::max(num_lods, 1));
+    map_layer_base = grid->get_layer_base(this);
+    map_generation = grid->get_map_generation();
 
-    GL_CHECK_ERROR();
-
-    STAT_ACTION("rebuild_mesh planet children chunk : [" + name + "] ");
+    STAT_ACTION("rebuild_mesh planet children chunk : [{}] ", name);
     root->regenerate(cell_count);
     GL_CHECK_ERROR();
     dirty = false;
 }
 
+Eigen::Affine3d Planet::get_mesh_transform_ws(const Eigen::Quaterniond& rotation_ws) const {
+    Eigen::Affine3d transform = Eigen::Affine3d::Identity();
+    // 1. Add camera offset
+    transform.translate(get_world_position() - player->get_world_position());
+    // 2. Add rotation
+    transform.rotate(rotation_ws);
+    // 3. Shift up to center sphere to (0, 0, 0)
+    transform.translate(Eigen::Vector3d(radius, 0, 0));
+    return transform;
+}
+
 void Planet::tick(double delta_time) {
     STAT_FRAME("Planet_Tick");
     SceneComponent::tick(delta_time);
@@ -215,6 +249,24 @@ void Planet::tick(double delta_time) {
         rebuild_mesh();
     }
 
+    landscape_layers->update();
+
+    if (enable_atmosphere) {
+        if (!atmosphere)
+            atmosphere = Atmosphere::create(name);
+        const Eigen::Vector3f sun_direction = (GameSettings::get().sun_direction * Eigen::Vector3d(1, 0, 0)).cast<float>();
+        atmosphere->update(atmosphere_settings, radius, get_world_position().cast<float>(), player->get_world_position().cast<float>(), sun_direction);
+    }
+    else
+        atmosphere = nullptr;
+
+    // Another planet changed the layer allocation of the shared maps
+    if (grid->get_map_generation() != map_generation) {
+        map_layer_base = grid->get_layer_base(this);
+        map_generation = grid->get_map_generation();
+        root->regenerate(cell_count);
+    }
+
     {
         STAT_FRAME("compute planet global transform");
 
@@ -234,23 +286,19 @@ void Planet::tick(double delta_time) {
         inv_mesh_rotation_ws = mesh_rotation_ws.inverse();
 
         // Mesh transform in world space
-        mesh_transform_ws = Eigen::Affine3d::Identity();
-        // 1. Add camera offset
-        mesh_transform_ws.translate(get_world_position() - player->get_world_position());
-        // 2. Add rotation
-        mesh_transform_ws.rotate(mesh_rotation_ws);
-        // 3. Shift up to center sphere to (0, 0, 0)
-        mesh_transform_ws.translate(Eigen::Vector3d(radius, 0, 0));
+        mesh_transform_ws = get_mesh_transform_ws(mesh_rotation_ws);
     }
 
     // Compute LODs
-    const double camera_distance_to_ground = (player->get_world_position() - get_world_position()).norm() - static_cast<double>(radius);
-    const double normalized_distance       = std::max(1.0, camera_distance_to_ground / (cell_width * (cell_count * 4 + 2)));
-    const int    display_lod0_level        = std::min(num_lods - 1, static_cast<int>(std::log2(normalized_distance)));
-    const int    display_max_lod           = num_lods; // @TODO : limit max LOD when camera is close to ground
-    const double display_lod0_cell_width   = cell_width * std::pow(2.0, display_lod0_level);
+    const Eigen::Vector3d player_direction_ps       = get_world_rotation().inverse() * (player->get_world_position() - get_world_position());
+    const double          camera_distance_to_ground = std::abs(player_direction_ps.norm() - static_cast<double>(radius) - get_ground_altitude(player_direction_ps));
+    const double          normalized_distance       = std::max(1.0, camera_distance_to_ground / (cell_width * (cell_count * 4 + 2)));
+    const int             display_lod0_level        = std::min(num_lods - 1, static_cast<int>(std::log2(normalized_distance)));
+    const int             display_max_lod           = num_lods; // @TODO : limit max LOD when camera is close to ground
+    const double          display_lod0_cell_width   = cell_width * std::pow(2.0, display_lod0_level);
 
     root->tick(delta_time, display_max_lod - display_lod0_level, display_lod0_cell_width);
+    rebuild_maps(camera_distance_to_ground);
 
     // Update planet transform
     current_orbit += static_cast<double>(orbit_speed) * delta_time;
@@ -259,41 +307,172 @@ void Planet::tick(double delta_time) {
     set_local_rotation(Eigen::Quaterniond(Eigen::AngleAxisd(current_rotation, Eigen::Vector3d::UnitZ())));
 }
 
+void Planet::rebuild_maps(double camera_altitude) {
+    STAT_FRAME("rebuild landscape maps");
+    STAT_GPU("Rebuild landscape maps [{}]", name);
+    GL_CHECK_ERROR();
+
+    // Sort outdated chunks by screen space error (full updates first, coarse to fine)
+    outdated_chunks.clear();
+    for (PlanetChunk* chunk = root.get(); chunk; chunk = chunk->get_child().get())
+        if (chunk->update_target())
+            outdated_chunks.emplace_back(chunk->get_update_priority(camera_altitude), chunk);
+    std::ranges::stable_sort(outdated_chunks, [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    // Estimate the cost of an update from the previous ones : the heights are only generated in the update rects,
+    // but the seams and normals passes process the whole map of every updated chunk.
+    double ms_per_texel = 0;
+    double ms_per_chunk = 0;
+    if (map_update_budget_ms > 0 && average_generated_texels > 0 && average_updated_chunks > 0) {
+        ms_per_texel = compute_positions_timer->average_ms() / average_generated_texels;
+        ms_per_chunk = ((geomorphing ? 0 : compute_fix_seams_timer->average_ms()) + compute_normals_timer->average_ms()) / average_updated_chunks;
+    }
+
+    // Outdated chunks that don't fit in the budget keep displaying their current maps and will be updated during the next frames
+    updated_chunks.clear();
+    updated_chunk_data.clear();
+    update_rects.clear();
+    int64_t generated_texels = 0;
+    double  estimated_ms     = 0;
+    for (const auto& [priority, chunk] : outdated_chunks) {
+        const int64_t cost    = chunk->get_update_cost();
+        const double  cost_ms = ms_per_chunk + cost * ms_per_texel;
+        // Always update at least one chunk per frame
+        if (!updated_chunks.empty() && (generated_texels + cost > map_update_texel_budget || (map_update_budget_ms > 0 && estimated_ms + cost_ms > map_update_budget_ms)))
+            continue;
+        generated_texels += cost;
+        estimated_ms += cost_ms;
+        chunk->update_chunk_data(static_cast<int32_t>(updated_chunks.size()), update_rects);
+        updated_chunks.emplace_back(chunk);
+        updated_chunk_data.emplace_back(chunk->get_chunk_data());
+    }
+
+    if (!updated_chunks.empty()) {
+        // One invocation layer (gl_GlobalInvocationID.z) per updated chunk
+        BufferArena::get().push_raw(updated_chunk_data.data(), updated_chunk_data.size() * sizeof(PlanetChunk::LandscapeChunkData)).bind(GL_SHADER_STORAGE_BUFFER, 3);
+        const auto& height_maps  = grid->get_height_maps();
+        const int   map_size     = static_cast<int>(height_maps->width());
+        const int   chunk_number = static_cast<int>(updated_chunks.size());
+
+        // Compute heightmaps : one invocation layer per update rect, with the longest side of each rect along x
+        if (!update_rects.empty()) {
+            BufferArena::get().push_raw(update_rects.data(), update_rects.size() * sizeof(PlanetChunk::LandscapeUpdateRect)).bind(GL_SHADER_STORAGE_BUFFER, 6);
+            Eigen::Vector2i dispatch_size = Eigen::Vector2i::Zero();
+            for (const auto& rect : update_rects)
+                dispatch_size = dispatch_size.cwiseMax(Eigen::Vector2i(rect.size.maxCoeff(), rect.size.minCoeff()));
+
+            compute_positions_timer->begin();
+            compute_positions->bind();
+            compute_positions->bind_texture(height_maps, BindingMode::Out, 0);
+            compute_positions->execute(dispatch_size.x(), dispatch_size.y(), static_cast<int>(update_rects.size()));
+            compute_positions_timer->end();
+        }
+
+        // Fix seams (not needed with geomorphing)
+        if (!geomorphing) {
+            compute_fix_seams_timer->begin();
+            compute_fix_seams->bind();
+            compute_fix_seams->bind_texture(height_maps, BindingMode::InOut, 0);
+            compute_fix_seams->execute(map_size, map_size, chunk_number);
+            compute_fix_seams_timer->end();
+        }
+
+        // Compute normals
+        compute_normals_timer->begin();
+        compute_normals->bind();
+        compute_normals->bind_texture(height_maps, BindingMode::In, 0);
+        compute_normals->bind_texture(grid->get_normal_maps(), BindingMode::Out, 1);
+        compute_normals->execute(map_size, map_size, chunk_number);
+        compute_normals_timer->end();
+        GL_CHECK_ERROR();
+    }
+    if (!updated_chunks.empty()) {
+        average_generated_texels = average_generated_texels == 0 ? static_cast<double>(generated_texels) : average_generated_texels * 0.9 + generated_texels * 0.1;
+        average_updated_chunks   = average_updated_chunks == 0 ? static_cast<double>(updated_chunks.size()) : average_updated_chunks * 0.9 + updated_chunks.size() * 0.1;
+    }
+
+    STAT_COUNTER("Planet maps rebuilt", static_cast<int64_t>(updated_chunks.size()));
+    STAT_COUNTER("Planet maps delayed", static_cast<int64_t>(outdated_chunks.size() - updated_chunks.size()));
+    STAT_COUNTER("Planet height texels generated", generated_texels);
+
+    for (PlanetChunk* chunk = root.get(); chunk; chunk = chunk->get_child().get())
+        chunk->update_readback();
+}
+
+Planet::LandscapeUniforms::LandscapeUniforms(const Material& material)
+    : ground_displacement(material.uniform<int>("ground_displacement")),
+      debug_vector(material.uniform<Eigen::Vector4f>("debug_vector")),
+      height_map(material.uniform<std::shared_ptr<TextureBase>>("height_map")),
+      normal_map(material.uniform<std::shared_ptr<TextureBase>>("normal_map")),
+      layers(material) {
+}
+
+void Planet::bind_landscape_uniforms(const LandscapeUniforms& uniforms) const {
+    uniforms.ground_displacement.set(1);
+    uniforms.debug_vector.set(debug_vector);
+    uniforms.height_map.set(grid->get_height_maps());
+    uniforms.normal_map.set(grid->get_normal_maps());
+    landscape_layers->bind(uniforms.layers);
+}
+
+void Planet::draw_batch_indirect() const {
+    if (draw_batch.commands.empty())
+        return;
 
-void Planet::render(Camera& camera, const DrawGroup& draw_group, const std::shared_ptr<RenderPass>& render_pass) {
+    const auto draw_data   = BufferArena::get().push_raw(draw_batch.draw_data.data(), draw_batch.draw_data.size() * sizeof(PlanetChunk::LandscapeDrawData));
+    const auto draw_chunks = BufferArena::get().push_raw(draw_batch.draw_chunks.data(), draw_batch.draw_chunks.size() * sizeof(uint32_t));
+    const auto commands    = BufferArena::get().push_raw(draw_batch.commands.data(), draw_batch.commands.size() * sizeof(Mesh::DrawElementsIndirectCommand));
+    // The arena is full (already reported by BufferArena) : the shader can't read its parameters, skip the batch for this frame
+    if (draw_data.buffer_id == 0 || draw_chunks.buffer_id == 0 || commands.buffer_id == 0)
+        return;
+
+    draw_data.bind(GL_SHADER_STORAGE_BUFFER, 7);
+    draw_chunks.bind(GL_SHADER_STORAGE_BUFFER, 8);
+    grid->get_mesh()->draw_indirect(commands.buffer_id, commands.offset, static_cast<uint32_t>(draw_batch.commands.size()));
+}
+
+void Planet::render(Camera& camera, const DrawGroup& in_draw_group, const std::shared_ptr<RenderPass>& render_pass) {
     STAT_FRAME("Render Planet");
-    SceneComponent::render(camera, draw_group, render_pass);
-
-    if (landscape_material->bind()) {
-        landscape_material->set_int("ground_displacement", 1);
-        landscape_material->set_transform("mesh_transform_ws", mesh_transform_ws);
-        landscape_material->set_float("radius", radius);
-        landscape_material->set_int("cell_count", cell_count);
-        landscape_material->set_vec4("debug_vector", debug_vector);
-        landscape_material->set_rotation("mesh_rotation_ps", mesh_rotation_ps);
-        landscape_material->set_rotation("scene_rotation", get_world_rotation());
-        landscape_material->set_texture("grass_color", grass_albedo);
-        landscape_material->set_texture("rock_color", rock_albedo);
-        landscape_material->set_texture("sand_color", sand_albedo);
-        landscape_material->set_texture("grass_normal", grass_normal);
-        landscape_material->set_texture("rock_normal", rock_normal);
-        landscape_material->set_texture("sand_normal", sand_normal);
-        landscape_material->set_texture("grass_mrao", grass_mrao);
-        landscape_material->set_texture("rock_mrao", rock_mrao);
-        landscape_material->set_texture("sand_mrao", sand_mrao);
-        landscape_material->set_texture("water_normal", water_normal);
-        landscape_material->set_texture("water_displacement", water_displacement);
-        root->render(camera, landscape_material);
+    STAT_GPU("Render planet [{}]", name);
+    SceneComponent::render(camera, in_draw_group, render_pass);
+    if (!grid)
+        return;
+
+    // Every planet sharing this grid is drawn by the first one rendered in this draw group, with a single indirect draw call
+    const auto& planets = grid->get_planets();
+    const auto  leader  = std::ranges::find_if(planets, [&](const Planet* planet) { return planet->draw_group.contains(in_draw_group); });
+    if (leader != planets.end() && *leader == this && landscape_material->bind()) {
+        draw_batch.clear();
+        for (Planet* planet : planets)
+            if (planet->draw_group.contains(in_draw_group))
+                planet->root->collect_draws(camera, draw_batch);
+
+        bind_landscape_uniforms(landscape_uniforms);
+        GlState::get().set_enabled(GL_CULL_FACE, true);
+        GlState::get().set_polygon_mode(GameSettings::get().wireframe ? GL_LINE : GL_FILL);
+        draw_batch_indirect();
+        GlState::get().set_polygon_mode(GL_FILL);
+
+        STAT_COUNTER("Planet draw commands", static_cast<int64_t>(draw_batch.commands.size()));
+    }
+
+    // Debug displays only concern this planet
+    if (!double_sided && !display_normals)
+        return;
+    draw_batch.clear();
+    root->collect_draws(camera, draw_batch);
+
+    if (double_sided && landscape_material->bind()) {
+        bind_landscape_uniforms(landscape_uniforms);
+        GlState::get().set_polygon_mode(GL_LINE);
+        GlState::get().set_front_face(GL_CW);
+        draw_batch_indirect();
+        GlState::get().set_front_face(GL_CCW);
+        GlState::get().set_polygon_mode(GL_FILL);
     }
 
     if (display_normals && debug_normal_display_material->bind()) {
-        debug_normal_display_material->set_int("ground_displacement", 1);
-        debug_normal_display_material->set_transform("mesh_transform_ws", mesh_transform_ws);
-        debug_normal_display_material->set_float("radius", radius);
-        debug_normal_display_material->set_int("cell_count", cell_count);
-        debug_normal_display_material->set_vec4("debug_vector", debug_vector);
-        debug_normal_display_material->set_rotation("mesh_rotation_ps", mesh_rotation_ps);
-        debug_normal_display_material->set_rotation("scene_rotation", get_world_rotation());
-        root->render(camera, debug_normal_display_material);
+        bind_landscape_uniforms(debug_normal_display_uniforms);
+        draw_batch_indirect();
     }
 }
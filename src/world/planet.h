@@ -1,23 +1,41 @@
 #pragma once
 
+#include "graphics/material.h"
+#include "world/atmosphere.h"
+#include "world/landscape_layers.h"
+#include "world/planet_chunk.h"
 #include "world/scene_component.h"
 
-class Texture2D;
+class Texture2DArray;
+class TextureBase;
 class ComputeShader;
+class GpuTimer;
 class Mesh;
-class Material;
-class PlanetChunk;
+class PlanetGrid;
 class World;
 
 class Planet : public SceneComponent {
     friend class PlanetChunk;
 public:
+    ~Planet() override;
+
     static std::shared_ptr<Planet> create(const std::string& name, const std::shared_ptr<SceneComponent>& player);
 
     void draw_ui() override;
 
     [[nodiscard]] float get_radius() const { return radius; }
 
+    /**
+     * \brief Terrain altitude above radius in the given direction. Evaluated on CPU, no GPU readback involved.
+     * \param planet_space_direction direction from the planet center in planet space
+     */
+    [[nodiscard]] double get_ground_altitude(const Eigen::Vector3d& planet_space_direction) const;
+
+    /**
+     * \brief Batch version of get_ground_altitude()
+     */
+    void get_ground_altitudes(const std::vector<Eigen::Vector3f>& planet_space_directions, std::vector<float>& altitudes) const;
+
     void set_radius(float in_radius) {
         radius = in_radius;
         dirty  = true;
@@ -47,17 +65,42 @@ public:
 
     virtual Class get_class() override { return {this}; }
 
-    struct AtmosphereSettings {
-        float           atmosphere_depth     = 200000;
-        float           density_falloff      = 6;
-        float           scatter_strength     = 2;
-        Eigen::Vector4f scatter_coefficients = Eigen::Vector4f(700.f, 550.f, 460.f, 4.f);
-        float           epsilon              = 1;
-    };
+    using AtmosphereSettings = Atmosphere::Settings;
 
     bool               enable_atmosphere   = true;
     AtmosphereSettings atmosphere_settings = {};
 
+    /**
+     * \brief Copy chunk heightmaps back to the CPU asynchronously (see try_get_heights())
+     */
+    bool enable_height_readback = true;
+
+    /**
+     * \brief Latest heightmap of the given LOD available on CPU. Never stalls the GPU : results are a few frames late.
+     * \return nullptr if this LOD doesn't exist or if no readback completed yet.
+     */
+    [[nodiscard]] const PlanetChunk::HeightTile* try_get_heights(uint32_t lod) const;
+
+    /**
+     * \brief Blend each LOD toward its parent in the vertex shader (CDLOD geomorphing). Otherwise, the seams are fixed in a compute pass after each update.
+     */
+    bool geomorphing = true;
+
+    /**
+     * \brief Maximum number of heightmap texels generated per frame. Outdated LODs are updated over several frames by decreasing screen space error.
+     */
+    int map_update_texel_budget = 128 * 1024;
+
+    /**
+     * \brief Maximum GPU time spent generating heightmaps per frame (estimated from the previous frames). Ignored if <= 0
+     */
+    float map_update_budget_ms = 1.0f;
+
+    /**
+     * \brief Mesh transform for the given mesh rotation in world space (relative to the camera)
+     */
+    [[nodiscard]] Eigen::Affine3d get_mesh_transform_ws(const Eigen::Quaterniond& rotation_ws) const;
+
 protected:
     void tick(double delta_time) override;
   void render(Camera& camera, const DrawGroup& draw_group, const std::shared_ptr<RenderPass>& render_pass) override;
@@ -66,9 +109,12 @@ private:
     Planet(const std::string& name, const std::shared_ptr<SceneComponent>& player);
 
     std::shared_ptr<SceneComponent> player;
-    std::shared_ptr<Mesh>           root_mesh;
-    std::shared_ptr<Mesh>           child_mesh;
+    std::shared_ptr<PlanetGrid>     grid;               // Meshes and maps shared with the other planets of the same cell count
+    uint32_t                        map_layer_base = 0; // Layer of LOD 0 in the grid maps
+    uint64_t                        map_generation = 0;
     std::shared_ptr<PlanetChunk>    root;
+    std::shared_ptr<Atmosphere>     atmosphere;
+    PlanetChunk::DrawBatch          draw_batch;
 
     // Parameters
     float radius     = 80000;
@@ -88,11 +134,49 @@ private:
     bool            freeze_updates  = false;
     bool            double_sided    = false;
     bool            display_normals = false;
+    bool            tile_culling    = true;
     bool            dirty           = true;
     Eigen::Vector4f debug_vector    = Eigen::Vector4f::Zero();
+    int             validation_grid = 256;
 
     void rebuild_mesh();
 
+    /**
+     * \brief Uniforms of the landscape materials, resolved once per shader compilation
+     */
+    struct LandscapeUniforms {
+        LandscapeUniforms() = default;
+        LandscapeUniforms(const Material& material);
+
+        UniformHandle<int>                          ground_displacement;
+        UniformHandle<Eigen::Vector4f>              debug_vector;
+        UniformHandle<std::shared_ptr<TextureBase>> height_map;
+        UniformHandle<std::shared_ptr<TextureBase>> normal_map;
+        LandscapeLayers::Uniforms                   layers;
+    };
+
+    /**
+     * \brief Bind the grid maps and terrain textures shared by all the planets of the draw batch
+     */
+    void bind_landscape_uniforms(const LandscapeUniforms& uniforms) const;
+
+    /**
+     * \brief Draw the content of draw_batch with the bound material (one glMultiDrawElementsIndirect)
+     */
+    void draw_batch_indirect() const;
+
+    /**
+     * \brief Regenerate the maps of every chunk that changed since the last frame. All LODs are processed by the same dispatches (one texture layer per LOD).
+     */
+    void rebuild_maps(double camera_altitude);
+    std::vector<std::pair<double, PlanetChunk*>>  outdated_chunks;
+    std::vector<PlanetChunk*>                     updated_chunks;
+    std::vector<PlanetChunk::LandscapeChunkData>  updated_chunk_data;
+    std::vector<PlanetChunk::LandscapeUpdateRect> update_rects;
+    // Match the averaging of the GPU timers
+    double                                        average_generated_texels = 0;
+    double                                        average_updated_chunks   = 0;
+
     // Transformations
     Eigen::Affine3d    mesh_transform_ws    = Eigen::Affine3d::Identity();
     Eigen::Quaterniond mesh_rotation_ws     = Eigen::Quaterniond::Identity();
@@ -100,20 +184,15 @@ private:
     Eigen::Quaterniond inv_mesh_rotation_ws = Eigen::Quaterniond::Identity();
 
     // GPU Objects
-    std::shared_ptr<Material>      landscape_material            = nullptr;
-    std::shared_ptr<Material>      debug_normal_display_material = nullptr;
-    std::shared_ptr<ComputeShader> compute_positions             = nullptr;
-    std::shared_ptr<ComputeShader> compute_normals               = nullptr;
-    std::shared_ptr<ComputeShader> compute_fix_seams             = nullptr;
-    std::shared_ptr<Texture2D>     grass_albedo                  = nullptr;
-    std::shared_ptr<Texture2D>     grass_normal                  = nullptr;
-    std::shared_ptr<Texture2D>     grass_mrao                    = nullptr;
-    std::shared_ptr<Texture2D>     rock_albedo                   = nullptr;
-    std::shared_ptr<Texture2D>     rock_normal                   = nullptr;
-    std::shared_ptr<Texture2D>     rock_mrao                     = nullptr;
-    std::shared_ptr<Texture2D>     sand_albedo                   = nullptr;
-    std::shared_ptr<Texture2D>     sand_normal                   = nullptr;
-    std::shared_ptr<Texture2D>     sand_mrao                     = nullptr;
-    std::shared_ptr<Texture2D>     water_normal                  = nullptr;
-    std::shared_ptr<Texture2D>     water_displacement            = nullptr;
+    std::shared_ptr<Material>        landscape_material            = nullptr;
+    std::shared_ptr<Material>        debug_normal_display_material = nullptr;
+    LandscapeUniforms                landscape_uniforms;
+    LandscapeUniforms                debug_normal_display_uniforms;
+    std::shared_ptr<ComputeShader>   compute_positions             = nullptr;
+    std::shared_ptr<ComputeShader>   compute_normals               = nullptr;
+    std::shared_ptr<ComputeShader>   compute_fix_seams             = nullptr;
+    std::shared_ptr<GpuTimer>        compute_positions_timer       = nullptr;
+    std::shared_ptr<GpuTimer>        compute_fix_seams_timer       = nullptr;
+    std::shared_ptr<GpuTimer>        compute_normals_timer         = nullptr;
+    std::shared_ptr<LandscapeLayers> landscape_layers              = nullptr;
 };
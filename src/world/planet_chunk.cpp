@@ -1,15 +1,27 @@
 #include "planet_chunk.h"
 
 #include "planet.h"
+#include "planet_grid.h"
 #include "graphics/camera.h"
-#include "graphics/compute_shader.h"
-#include "graphics/material.h"
 #include "graphics/mesh.h"
-#include "graphics/storage_buffer.h"
 #include "graphics/texture_image.h"
-#include "utils/game_settings.h"
+#include "graphics/texture_readback.h"
 #include "utils/gl_tools.h"
 #include "utils/profiler.h"
+#include "landscape.h"
+
+#include <algorithm>
+#include <cstring>
+
+static int wrap_texel(int value, int map_size) {
+    return (value % map_size + map_size) % map_size;
+}
+
+static Eigen::Matrix4f rotation_matrix(const Eigen::Quaterniond& rotation) {
+    Eigen::Matrix4f matrix       = Eigen::Matrix4f::Identity();
+    matrix.topLeftCorner<3, 3>() = rotation.cast<float>().toRotationMatrix();
+    return matrix;
+}
 
 PlanetChunk::PlanetChunk(Planet& in_parent, uint32_t in_lod_level, uint32_t in_my_level)
     : num_lods(in_lod_level), current_lod(in_my_level), planet(in_parent) {
@@ -17,27 +29,9 @@ PlanetChunk::PlanetChunk(Planet& in_parent, uint32_t in_lod_level, uint32_t in_m
 
 void PlanetChunk::regenerate(int32_t in_cell_number) {
     cell_number = in_cell_number;
-    {
-        const int map_size = cell_number * 4 + 5;
-        if (!chunk_height_map || chunk_height_map->width() != map_size) {
-            GL_CHECK_ERROR();
-            chunk_height_map =
-                Texture2D::create("heightmap_LOD_" + std::to_string(current_lod),
-                                  {.wrapping = TextureWrapping::ClampToEdge, .filtering_mag = TextureMagFilter::Nearest, .filtering_min = TextureMinFilter::Nearest});
-            chunk_height_map->set_data(map_size, map_size, ImageFormat::RG_F32);
-            GL_CHECK_ERROR();
-        }
-        if (!chunk_normal_map || chunk_normal_map->width() != map_size) {
-            GL_CHECK_ERROR();
-            chunk_normal_map =
-                Texture2D::create("normal_LOD_" + std::to_string(current_lod),
-                                  {.wrapping = TextureWrapping::ClampToEdge, .filtering_mag = TextureMagFilter::Nearest, .filtering_min = TextureMinFilter::Nearest});
-            chunk_normal_map->set_data(map_size, map_size, ImageFormat::RG_F16);
-            GL_CHECK_ERROR();
-        }
-
-        rebuild_maps();
-    }
+    tile_bounds.clear();
+    force_rebuild = true;
+    has_maps      = false;
     if (child)
         child->regenerate(cell_number);
 }
@@ -56,7 +50,7 @@ void PlanetChunk::tick(double delta_time, int in_num_lods, double in_width) {
     if (child)
         child->tick(delta_time, num_lods, cell_size * 2);
 
-    STAT_FRAME("Planet Tick LOD :" + std::to_string(current_lod));
+    STAT_FRAME("Planet Tick LOD :{}", current_lod);
     // Compute camera position in local space
     const Eigen::Vector3d camera_local_position = planet.inv_mesh_rotation_ws * (planet.player->get_world_position() - planet.get_world_position());
 
@@ -67,9 +61,13 @@ void PlanetChunk::tick(double delta_time, int in_num_lods, double in_width) {
     // Convert linear position to position on sphere
     Eigen::Vector3d local_location = Eigen::Vector3d(0, asin(std::clamp(temp.y(), -1.0, 1.0)), asin(std::clamp(temp.z(), -1.0, 1.0))) * planet.radius;
 
+    camera_position_2d = Eigen::Vector2d(local_location.y(), local_location.z());
+
     const double snapping = cell_size * 2;
     chunk_position        = Eigen::Vector3d(std::round(local_location.y() / snapping + 0.5) - 0.5, 0, std::round(local_location.z() / snapping + 0.5) - 0.5) * snapping;
 
+    grid_origin = Eigen::Vector2i(static_cast<int>(std::lround(chunk_position.x() / cell_size)), static_cast<int>(std::lround(chunk_position.z() / cell_size)));
+
     mesh_transform_cs = Eigen::Affine3d::Identity();
     mesh_transform_cs.translate(chunk_position);
     mesh_transform_cs.scale(cell_size);
@@ -82,85 +80,312 @@ void PlanetChunk::tick(double delta_time, int in_num_lods, double in_width) {
             mesh_transform_cs.rotate(Eigen::AngleAxisd(M_PI, Eigen::Vector3d::UnitY()));
     }
 
-    rebuild_maps();
 }
 
-void PlanetChunk::render(Camera& camera, const std::shared_ptr<Material>& draw_material) {
+void PlanetChunk::update_readback() {
+    if (!planet.enable_height_readback) {
+        height_readback = nullptr;
+        pending_readbacks.clear();
+        return;
+    }
+    if (!height_readback) {
+        height_readback   = TextureReadback::create("heightmap_readback_LOD_" + std::to_string(current_lod));
+        readback_required = true;
+    }
+
+    // Consume finished transfers
+    if (const uint64_t ticket = height_readback->poll()) {
+        while (!pending_readbacks.empty() && pending_readbacks.front().first < ticket)
+            pending_readbacks.pop_front();
+        if (!pending_readbacks.empty() && pending_readbacks.front().first == ticket) {
+            const auto& source_data = pending_readbacks.front().second;
+            const auto& data        = height_readback->get_data();
+            height_tile.heights.resize(data.size() / sizeof(float));
+            std::memcpy(height_tile.heights.data(), data.data(), height_tile.heights.size() * sizeof(float));
+            height_tile.map_size          = height_readback->width();
+            height_tile.local_transform   = source_data.Chunk_LocalTransform;
+            height_tile.planet_model      = source_data.Chunk_PlanetModel;
+            height_tile.grid_origin_texel = source_data.Chunk_GridOriginTexel;
+            height_tile.version++;
+            pending_readbacks.pop_front();
+        }
+    }
+
+    // Enqueue the last generated map. If the ring is full, retry next frame.
+    if (readback_required) {
+        if (const uint64_t ticket = height_readback->request(planet.grid->get_height_maps(), GL_RED, GL_FLOAT, sizeof(float), last_chunk_data.Chunk_Layer)) {
+            pending_readbacks.emplace_back(ticket, last_chunk_data);
+            readback_required = false;
+        }
+    }
+}
+
+void PlanetChunk::collect_draws(Camera& camera, DrawBatch& batch, bool cover_inner_area) {
+    // Nothing to display until the first maps of this LOD are generated. Displaced maps would be drawn at the wrong place.
+    const bool hidden = !has_maps || is_displaced();
     if (child)
-        child->render(camera, draw_material);
-    GL_CHECK_ERROR();
-    STAT_FRAME("Render planet lod " + std::to_string(current_lod));
-
-    // Set uniforms
-    draw_material->set_transform("mesh_transform_cs", mesh_transform_cs);
-    draw_material->set_texture("height_map", chunk_height_map);
-    draw_material->set_texture("normal_map", chunk_normal_map);
-
-    // Draw
-    glEnable(GL_CULL_FACE);
-    glPolygonMode(GL_FRONT_AND_BACK, GameSettings::get().wireframe ? GL_LINE : GL_FILL);
-    if (current_lod == 0)
-        planet.root_mesh->draw();
-    else
-        planet.child_mesh->draw();
-    if (planet.double_sided) {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        glFrontFace(GL_CW);
-        if (current_lod == 0)
-            planet.root_mesh->draw();
+        child->collect_draws(camera, batch, hidden);
+    if (hidden)
+        return;
+
+    STAT_FRAME("Collect planet lod draws {}", current_lod);
+
+    // The chunk is displayed where its current maps were generated (updates may be delayed by the planet's scheduler)
+    const int         map_size = cell_number * 4 + 5;
+    LandscapeDrawData draw_data{
+        .mesh_transform_ws = (generated_rotation_ps.coeffs() == planet.mesh_rotation_ps.coeffs() ? planet.mesh_transform_ws : planet.get_mesh_transform_ws(get_generated_rotation_ws()))
+                             .cast<float>().matrix(),
+        .mesh_transform_cs = generated_transform_cs.cast<float>().matrix(),
+        .mesh_rotation_ps = rotation_matrix(generated_rotation_ps),
+        .scene_rotation = rotation_matrix(planet.get_world_rotation()),
+        .morph_settings = Eigen::Vector4f::Zero(),
+        .grid_origin_texel = last_chunk_data.Chunk_GridOriginTexel,
+        .grid_origin_wrap = Eigen::Vector2i(wrap_texel(last_grid_origin.x(), map_size * 2), wrap_texel(last_grid_origin.y(), map_size * 2)),
+        .radius = planet.radius,
+        .cell_count = cell_number,
+        .lod_layer = last_chunk_data.Chunk_Layer,
+        .morph_layer = -1};
+    set_geomorphing_data(draw_data);
+
+    // The root mesh has the same outer border as the rings, without the hole
+    const size_t first_command = batch.commands.size();
+    collect_visible_tiles(camera, batch.commands, cover_inner_area ? 0 : current_lod);
+    if (batch.commands.size() == first_command)
+        return;
+    batch.draw_chunks.resize(batch.commands.size(), static_cast<uint32_t>(batch.draw_data.size()));
+    batch.draw_data.emplace_back(draw_data);
+}
+
+void PlanetChunk::set_geomorphing_data(LandscapeDrawData& draw_data) const {
+    // The parent maps must have been generated on the same mesh and cover this whole chunk
+    const PlanetChunk* parent = child.get();
+    if (!planet.geomorphing || !parent || !parent->has_maps || parent->generated_rotation_ps.coeffs() != generated_rotation_ps.coeffs() ||
+        parent->last_chunk_data.Chunk_CellWidth != last_chunk_data.Chunk_CellWidth * 2 || (last_grid_origin - parent->last_grid_origin * 2).cwiseAbs().maxCoeff() > cell_number * 2 + 2)
+        return;
+
+    // Vertices reach the parent heights one cell before the outer border (the camera can be one cell away from the chunk center), and start moving after the inner border
+    const float           morph_end     = static_cast<float>(cell_number * 2);
+    const float           morph_start   = std::min(static_cast<float>(cell_number + 2), morph_end - 1);
+    const Eigen::Vector2d camera_offset = camera_position_2d / last_chunk_data.Chunk_CellWidth - last_grid_origin.cast<double>();
+    draw_data.morph_settings            = Eigen::Vector4f(morph_start, morph_end, static_cast<float>(camera_offset.x()), static_cast<float>(camera_offset.y()));
+    draw_data.morph_layer               = parent->last_chunk_data.Chunk_Layer;
+}
+
+/**
+ * \brief Test if a sphere is entirely hidden by a spherical occluder. Everything is expressed relative to the camera.
+ */
+static bool is_behind_horizon(const Eigen::Vector3d& occluder_center, double occluder_radius, const Eigen::Vector3d& center, double radius) {
+    const double occluder_distance = occluder_center.norm();
+    const double distance          = center.norm();
+    if (occluder_distance <= occluder_radius || distance <= radius)
+        return false;
+
+    // The sphere should be behind the plane containing the horizon circle...
+    const Eigen::Vector3d to_camera = -occluder_center / occluder_distance;
+    if ((center - occluder_center).dot(to_camera) + radius >= occluder_radius * occluder_radius / occluder_distance)
+        return false;
+
+    // ... and inside the occluder's shadow cone
+    const double cone_angle   = std::asin(occluder_radius / occluder_distance);
+    const double sphere_angle = std::acos(std::clamp(center.dot(occluder_center) / (distance * occluder_distance), -1.0, 1.0));
+    return sphere_angle + std::asin(radius / distance) <= cone_angle;
+}
+
+void PlanetChunk::collect_visible_tiles(Camera& camera, std::vector<Mesh::DrawElementsIndirectCommand>& commands, uint32_t tiles_lod) {
+    const auto& tiles = planet.grid->get_tiles(tiles_lod);
+    if (tiles.empty())
+        return;
+
+    // Consecutive visible tiles are merged in a single command
+    const size_t first_command = commands.size();
+    const auto   add_range     = [&](uint32_t first_index, uint32_t index_count) {
+        if (commands.size() > first_command && commands.back().first_index + commands.back().index_count == first_index)
+            commands.back().index_count += index_count;
         else
-            planet.child_mesh->draw();
-        glFrontFace(GL_CCW);
+            commands.emplace_back(Mesh::DrawElementsIndirectCommand{.index_count = index_count, .instance_count = 1, .first_index = first_index, .base_vertex = 0, .base_instance = 0});
+    };
+
+    if (!planet.tile_culling) {
+        // Tiles of a ring are contiguous in the index buffer
+        add_range(tiles.front().first_index, tiles.back().first_index + tiles.back().index_count - tiles.front().first_index);
+        STAT_COUNTER("Planet tiles drawn", static_cast<int64_t>(tiles.size()));
+        return;
+    }
+
+    update_tile_bounds(tiles_lod);
+
+    const Frustum            frustum         = camera.get_frustum();
+    const Eigen::Quaterniond rotation_ws     = get_generated_rotation_ws();
+    const Eigen::Vector3d    planet_center   = planet.mesh_transform_ws * Eigen::Vector3d(-planet.radius, 0, 0);
+    const double             occluder_radius = planet.radius - landscape::max_altitude;
+
+    int64_t visible_tiles = 0;
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const Eigen::Vector3d center = planet_center + rotation_ws * tile_bounds[i].center;
+        if (!frustum.intersects_sphere(center, tile_bounds[i].radius) || is_behind_horizon(planet_center, occluder_radius, center, tile_bounds[i].radius))
+            continue;
+        add_range(tiles[i].first_index, tiles[i].index_count);
+        visible_tiles++;
     }
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    STAT_COUNTER("Planet tiles drawn", visible_tiles);
+    STAT_COUNTER("Planet tiles culled", static_cast<int64_t>(tiles.size()) - visible_tiles);
 }
 
-void PlanetChunk::rebuild_maps() {
-    if (planet.freeze_updates && !force_rebuild)
+void PlanetChunk::update_tile_bounds(uint32_t tiles_lod) {
+    const auto& tiles = planet.grid->get_tiles(tiles_lod);
+    if (tile_bounds_lod == tiles_lod && tile_bounds.size() == tiles.size() && tile_bounds_transform == generated_transform_cs.matrix() && tile_bounds_rotation.coeffs() == generated_rotation_ps.coeffs())
         return;
 
-    GL_CHECK_ERROR();
-    STAT_FRAME("rebuild landscape map");
+    STAT_FRAME("Update planet tile bounds");
+    tile_bounds_lod       = tiles_lod;
+    tile_bounds_transform = generated_transform_cs.matrix();
+    tile_bounds_rotation  = generated_rotation_ps;
+
+    // Sample each tile on a 3x3 grid projected on the sphere
+    constexpr int                samples_per_side = 3;
+    constexpr int                samples_per_tile = samples_per_side * samples_per_side;
+    const double                 radius           = planet.radius;
+    const double                 max_grid         = radius * M_PI / 2;
+    std::vector<Eigen::Vector3d> normals(tiles.size() * samples_per_tile);
+    std::vector<Eigen::Vector3f> directions_ps(normals.size());
+    for (size_t i = 0; i < tiles.size(); ++i)
+        for (int z = 0; z < samples_per_side; ++z)
+            for (int x = 0; x < samples_per_side; ++x) {
+                const Eigen::Vector2d alpha(x / (samples_per_side - 1.0), z / (samples_per_side - 1.0));
+                const Eigen::Vector2d grid_pos = tiles[i].grid_min.cast<double>() + (tiles[i].grid_max - tiles[i].grid_min).cast<double>().cwiseProduct(alpha);
+                const Eigen::Vector3d local    = generated_transform_cs * Eigen::Vector3d(grid_pos.x(), 0, grid_pos.y());
+                const Eigen::Vector2d pos_2d   = Eigen::Vector2d(std::clamp(local.x(), -max_grid, max_grid), std::clamp(local.z(), -max_grid, max_grid)) / radius;
+
+                // Same as grid_to_sphere_centered() (maths.cginc)
+                const Eigen::Vector3d normal = Eigen::Vector3d(std::cos(pos_2d.y()) * std::cos(pos_2d.x()), std::cos(pos_2d.y()) * std::sin(pos_2d.x()), std::sin(pos_2d.y()));
+
+                normals[i * samples_per_tile + z * samples_per_side + x]       = normal;
+                directions_ps[i * samples_per_tile + z * samples_per_side + x] = (generated_rotation_ps * normal).cast<float>();
+            }
+
+    std::vector<float> altitudes;
+    planet.get_ground_altitudes(directions_ps, altitudes);
+
+    tile_bounds.resize(tiles.size());
+    for (size_t i = 0; i < tiles.size(); ++i) {
+        const auto* tile_normals   = &normals[i * samples_per_tile];
+        const auto* tile_altitudes = &altitudes[i * samples_per_tile];
+
+        // Terrain may go past the sampled altitudes between samples : allow a slope of 1 over the whole tile.
+        const double tile_width = cell_size * (tiles[i].grid_max - tiles[i].grid_min).maxCoeff();
+        const double margin     = std::min(tile_width, static_cast<double>(landscape::max_altitude));
+        const double min_radius = radius + std::max(*std::min_element(tile_altitudes, tile_altitudes + samples_per_tile) - margin, -static_cast<double>(landscape::max_altitude));
+        const double max_radius = radius + std::min(*std::max_element(tile_altitudes, tile_altitudes + samples_per_tile) + margin, static_cast<double>(landscape::max_altitude));
+
+        Eigen::Vector3d center = Eigen::Vector3d::Zero();
+        for (int s = 0; s < samples_per_tile; ++s)
+            center += tile_normals[s] * (min_radius + max_radius);
+        center /= 2.0 * samples_per_tile;
+
+        double bound_radius = 0;
+        for (int s = 0; s < samples_per_tile; ++s)
+            bound_radius = std::max({bound_radius, (tile_normals[s] * min_radius - center).norm(), (tile_normals[s] * max_radius - center).norm()});
+
+        // Curvature between two samples
+        const double sample_spacing = (tile_normals[0] - tile_normals[samples_per_tile - 1]).norm() * max_radius / (samples_per_side - 1);
+        tile_bounds[i]              = {center, bound_radius + sample_spacing * sample_spacing / (4 * max_radius)};
+    }
+}
+
+Eigen::Quaterniond PlanetChunk::get_generated_rotation_ws() const {
+    if (generated_rotation_ps.coeffs() == planet.mesh_rotation_ps.coeffs())
+        return planet.mesh_rotation_ws;
+    return planet.get_world_rotation() * generated_rotation_ps;
+}
+
+bool PlanetChunk::update_target() {
+    target_outdated = false;
+    if (planet.freeze_updates && !force_rebuild)
+        return false;
 
     auto test = Eigen::Affine3d::Identity();
     test.rotate(planet.mesh_rotation_ps);
 
-    const LandscapeChunkData chunk_data{.Chunk_LocalTransform = mesh_transform_cs.cast<float>().matrix(),
-                                        .Chunk_PlanetModel = (planet.get_world_transform().inverse() * planet.mesh_transform_ws).cast<float>().matrix(),
-                                        .Chunk_LocalOrientation = test.cast<float>().matrix(),
-                                        .Chunk_PlanetRadius = planet.radius,
-                                        .Chunk_CellWidth = static_cast<float>(cell_size),
-                                        .Chunk_CellCount = cell_number,
-                                        .Chunk_CurrentLOD = static_cast<int32_t>(current_lod)};
+    const int map_size = cell_number * 4 + 5;
+    target_chunk_data  = {.Chunk_LocalTransform = mesh_transform_cs.cast<float>().matrix(),
+                          .Chunk_PlanetModel = (planet.get_world_transform().inverse() * planet.mesh_transform_ws).cast<float>().matrix(),
+                          .Chunk_LocalOrientation = test.cast<float>().matrix(),
+                          .Chunk_PlanetRadius = planet.radius,
+                          .Chunk_CellWidth = static_cast<float>(cell_size),
+                          .Chunk_CellCount = cell_number,
+                          .Chunk_CurrentLOD = static_cast<int32_t>(current_lod),
+                          .Chunk_GridOriginTexel = Eigen::Vector2i(wrap_texel(grid_origin.x(), map_size), wrap_texel(grid_origin.y(), map_size)),
+                          .Chunk_Layer = static_cast<int32_t>(planet.map_layer_base + current_lod),
+                          .Chunk_Padding = 0};
 
-    if (chunk_data == last_chunk_data && !force_rebuild)
-        return;
+    if (target_chunk_data == last_chunk_data && !force_rebuild)
+        return false;
 
-    force_rebuild = false;
+    // Heights are stored toroidally : when the ring only moved on the same grid, the texels that are still visible can be kept.
+    const Eigen::Vector2i delta = grid_origin - last_grid_origin;
+    displaced                   = has_maps && (!target_chunk_data.same_grid(last_chunk_data) || std::abs(delta.x()) >= map_size || std::abs(delta.y()) >= map_size);
+    full_update_required        = force_rebuild || !has_maps || displaced;
+    target_outdated             = true;
+    return true;
+}
 
-    GL_CHECK_ERROR();
-    const auto ssbo = StorageBuffer::create("PlanetChunkData");
-    ssbo->set_data(chunk_data);
-    last_chunk_data = chunk_data;
-    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, ssbo->id());
+double PlanetChunk::get_update_priority(double camera_altitude) const {
+    if (!target_outdated)
+        return 0;
+    // Above any screen space error (at most pi / 2)
+    if (full_update_required)
+        return M_PI + current_lod;
+    const double displacement = (grid_origin - last_grid_origin).cast<double>().norm() * cell_size;
+    // The closest visible part of a ring is its inner border
+    const double distance = std::max(camera_altitude, current_lod == 0 ? cell_size : (cell_number - 1) * cell_size);
+    return std::atan2(displacement, distance);
+}
 
-    // Compute heightmaps
-    planet.compute_positions->bind();
-    planet.compute_positions->bind_texture(chunk_height_map, BindingMode::Out, 0);
-    planet.compute_positions->execute(chunk_height_map->width(), chunk_height_map->height(), 1);
+int64_t PlanetChunk::get_update_cost() const {
+    if (!target_outdated)
+        return 0;
+    const int64_t map_size = cell_number * 4 + 5;
+    if (full_update_required)
+        return map_size * map_size;
+    const Eigen::Vector2i delta = grid_origin - last_grid_origin;
+    return (std::abs(delta.x()) + std::abs(delta.y())) * map_size;
+}
 
-    // Fix seams
-    planet.compute_fix_seams->bind();
-    planet.compute_fix_seams->bind_texture(chunk_height_map, BindingMode::InOut, 0);
-    planet.compute_fix_seams->execute(chunk_height_map->width(), chunk_height_map->height(), 1);
+void PlanetChunk::update_chunk_data(int32_t chunk_index, std::vector<LandscapeUpdateRect>& update_rects) {
+    if (!target_outdated)
+        return;
 
-    // Compute normals
-    planet.compute_normals->bind();
-    planet.compute_normals->bind_texture(chunk_height_map, BindingMode::In, 0);
-    planet.compute_normals->bind_texture(chunk_normal_map, BindingMode::Out, 1);
-    planet.compute_normals->execute(chunk_height_map->width(), chunk_height_map->height(), 1);
+    const int  map_size = cell_number * 4 + 5;
+    const auto add_rect = [&](const Eigen::Vector2i& grid_min, const Eigen::Vector2i& size) {
+        const Eigen::Vector2i texel_min(wrap_texel(grid_min.x(), map_size), wrap_texel(grid_min.y(), map_size));
+        update_rects.emplace_back(LandscapeUpdateRect{.grid_min = grid_min, .size = size, .texel_min = texel_min, .chunk_index = chunk_index, .padding = 0});
+    };
 
-    GL_CHECK_ERROR();
+    const int             half_size = cell_number * 2 + 2;
+    const Eigen::Vector2i delta     = grid_origin - last_grid_origin;
+    if (!full_update_required) {
+        // Exposed columns
+        if (delta.x() != 0)
+            add_rect(Eigen::Vector2i(delta.x() > 0 ? grid_origin.x() + half_size - delta.x() + 1 : grid_origin.x() - half_size, grid_origin.y() - half_size),
+                     Eigen::Vector2i(std::abs(delta.x()), map_size));
+        // Exposed rows
+        if (delta.y() != 0)
+            add_rect(Eigen::Vector2i(grid_origin.x() - half_size, delta.y() > 0 ? grid_origin.y() + half_size - delta.y() + 1 : grid_origin.y() - half_size),
+                     Eigen::Vector2i(map_size, std::abs(delta.y())));
+    }
+    else
+        add_rect(grid_origin - Eigen::Vector2i::Constant(half_size), Eigen::Vector2i::Constant(map_size));
+
+    force_rebuild          = false;
+    target_outdated        = false;
+    displaced              = false;
+    has_maps               = true;
+    last_chunk_data        = target_chunk_data;
+    last_grid_origin       = grid_origin;
+    generated_transform_cs = mesh_transform_cs;
+    generated_rotation_ps  = planet.mesh_rotation_ps;
+    readback_required      = true;
 }
 
 void PlanetChunk::force_rebuild_maps() {
@@ -169,7 +394,27 @@ void PlanetChunk::force_rebuild_maps() {
         child->force_rebuild_maps();
 }
 
+static_assert(sizeof(PlanetChunk::LandscapeChunkData) == 224, "LandscapeChunkData must match the std430 layout of ChunkData (planet_chunk_data.cginc)");
+
+static_assert(sizeof(PlanetChunk::LandscapeUpdateRect) == 32, "LandscapeUpdateRect must match the std430 layout of ChunkUpdateRect (planet_chunk_data.cginc)");
+
+static_assert(sizeof(PlanetChunk::LandscapeDrawData) == 304, "LandscapeDrawData must match the std430 layout of DrawData (planet_material.vs)");
+
+bool PlanetChunk::LandscapeChunkData::same_grid(const LandscapeChunkData& other) const {
+    return Chunk_LocalOrientation == other.Chunk_LocalOrientation && Chunk_PlanetRadius == other.Chunk_PlanetRadius && Chunk_CellWidth == other.Chunk_CellWidth &&
+           Chunk_CellCount == other.Chunk_CellCount && Chunk_CurrentLOD == other.Chunk_CurrentLOD && Chunk_Layer == other.Chunk_Layer;
+}
+
+size_t PlanetChunk::HeightTile::texel_index(const Eigen::Vector2i& vertex_pos) const {
+    const Eigen::Vector3f x_axis = local_transform.col(0).head<3>().normalized();
+    const Eigen::Vector3f z_axis = local_transform.col(2).head<3>().normalized();
+    const Eigen::Vector2i offset = Eigen::Vector2i(static_cast<int>(std::round(x_axis.x())), static_cast<int>(std::round(x_axis.z()))) * vertex_pos.x() +
+                                   Eigen::Vector2i(static_cast<int>(std::round(z_axis.x())), static_cast<int>(std::round(z_axis.z()))) * vertex_pos.y();
+    const int size = static_cast<int>(map_size);
+    return static_cast<size_t>(wrap_texel(grid_origin_texel.y() + offset.y(), size)) * map_size + wrap_texel(grid_origin_texel.x() + offset.x(), size);
+}
+
 bool PlanetChunk::LandscapeChunkData::operator==(const LandscapeChunkData& other) const {
     return Chunk_LocalTransform == other.Chunk_LocalTransform && Chunk_LocalOrientation == other.Chunk_LocalOrientation && Chunk_PlanetRadius == other.Chunk_PlanetRadius &&
-           Chunk_CellWidth == other.Chunk_CellWidth && Chunk_CellCount == other.Chunk_CellCount && Chunk_CurrentLOD == other.Chunk_CurrentLOD;
+           Chunk_CellWidth == other.Chunk_CellWidth && Chunk_CellCount == other.Chunk_CellCount && Chunk_CurrentLOD == other.Chunk_CurrentLOD && Chunk_Layer == other.Chunk_Layer;
 }
@@ -1,11 +1,15 @@
 #pragma once
 
+#include "graphics/mesh.h"
+
 #include <Eigen/Dense>
+#include <deque>
 #include <memory>
+#include <vector>
 
 class ComputeShader;
 class Material;
-class Texture2D;
+class TextureReadback;
 class Planet;
 class Camera;
 
@@ -15,12 +19,37 @@ public:
 
     void regenerate(int32_t cell_number);
     void force_rebuild_maps();
-    void rebuild_maps();
     void tick(double delta_time, int num_lods, double width);
-    void render(Camera& camera, const std::shared_ptr<Material>& draw_material);
 
+    /**
+     * \brief Heightmap of this LOD as last seen by the CPU (a few frames behind the GPU)
+     */
+    struct HeightTile {
+        std::vector<float> heights; // map_size * map_size texels, seams included. Addressed toroidally (see texel_index())
+        uint32_t           map_size = 0;
+        Eigen::Matrix4f    local_transform;   // Chunk_LocalTransform used to generate this tile
+        Eigen::Matrix4f    planet_model;      // Chunk_PlanetModel used to generate this tile
+        Eigen::Vector2i    grid_origin_texel; // Texel of the chunk center
+        uint64_t           version = 0;
 
-private:
+        /**
+         * \brief Index in heights of a vertex of the chunk mesh (in cells, relative to the chunk center). Same as chunk_vertex_to_texel() (planet_grid.cginc)
+         */
+        [[nodiscard]] size_t texel_index(const Eigen::Vector2i& vertex_pos) const;
+    };
+
+    /**
+     * \brief Non-blocking access to the latest heightmap read back from the GPU.
+     * \return nullptr if no readback completed yet
+     */
+    [[nodiscard]] const HeightTile* try_get_heights() const { return height_tile.version != 0 ? &height_tile : nullptr; }
+
+    [[nodiscard]] const std::shared_ptr<TextureReadback>& get_height_readback() const { return height_readback; }
+    [[nodiscard]] const std::shared_ptr<PlanetChunk>&     get_child() const { return child; }
+
+    /**
+     * \brief Chunk parameters used to generate its maps. Layout must match ChunkData in planet_chunk_data.cginc
+     */
     struct LandscapeChunkData {
         Eigen::Matrix4f Chunk_LocalTransform;
         Eigen::Matrix4f Chunk_PlanetModel;
@@ -29,11 +58,146 @@ private:
         float           Chunk_CellWidth;
         int32_t         Chunk_CellCount;
         int32_t         Chunk_CurrentLOD;
+        Eigen::Vector2i Chunk_GridOriginTexel;
+        int32_t         Chunk_Layer; // Layer of the planet grid maps (see PlanetGrid::get_layer_base())
+        int32_t         Chunk_Padding;
 
         bool operator==(const LandscapeChunkData& other) const;
+
+        /**
+         * \brief Both chunks generate the same heights for a given grid position (the maps can be updated incrementally)
+         */
+        [[nodiscard]] bool same_grid(const LandscapeChunkData& other) const;
+    };
+
+    /**
+     * \brief Area of the LOD grid where heights must be generated. Layout must match ChunkUpdateRect in planet_chunk_data.cginc
+     */
+    struct LandscapeUpdateRect {
+        Eigen::Vector2i grid_min;
+        Eigen::Vector2i size;
+        Eigen::Vector2i texel_min;
+        int32_t         chunk_index;
+        int32_t         padding;
+    };
+
+    /**
+     * \brief Per chunk parameters of the planet vertex shader. Layout must match DrawData in planet_material.vs
+     */
+    struct LandscapeDrawData {
+        Eigen::Matrix4f mesh_transform_ws;
+        Eigen::Matrix4f mesh_transform_cs;
+        Eigen::Matrix4f mesh_rotation_ps; // rotations are stored as mat4 to avoid the std430 mat3 padding
+        Eigen::Matrix4f scene_rotation;
+        Eigen::Vector4f morph_settings; // xy : geomorphing start / end distance, zw : camera position relative to the chunk center (in cells)
+        Eigen::Vector2i grid_origin_texel;
+        Eigen::Vector2i grid_origin_wrap; // Chunk center on the grid, modulo 2 * map size
+        float           radius;
+        int32_t         cell_count;
+        int32_t         lod_layer;
+        int32_t         morph_layer; // Layer of the parent (coarser) LOD, -1 if geomorphing is disabled
+    };
+
+    /**
+     * \brief Chunks drawn by a single indirect draw call. Each command reads its parameters from draw_data[draw_chunks[gl_DrawID]]
+     */
+    struct DrawBatch {
+        std::vector<LandscapeDrawData>                 draw_data;
+        std::vector<uint32_t>                          draw_chunks;
+        std::vector<Mesh::DrawElementsIndirectCommand> commands;
+
+        void clear() {
+            draw_data.clear();
+            draw_chunks.clear();
+            commands.clear();
+        }
     };
 
-    LandscapeChunkData last_chunk_data;
+    /**
+     * \brief Append the visible tiles of this chunk and its children to the batch.
+     * \param cover_inner_area the finer ring is hidden : also draw the center of this ring (see is_displaced())
+     */
+    void collect_draws(Camera& camera, DrawBatch& batch, bool cover_inner_area = false);
+
+    /**
+     * \brief Compute the parameters the maps of this chunk should be generated with.
+     * \return true if the current maps are outdated
+     */
+    bool update_target();
+
+    /**
+     * \brief Approximation of the screen space error (as an angle in radians) caused by displaying the current maps instead of the target ones.
+     * Full updates come first, from the coarsest LOD to the finest : the coarse rings must be in place before the finer ones can be displayed.
+     */
+    [[nodiscard]] double get_update_priority(double camera_altitude) const;
+
+    /**
+     * \brief Number of heightmap texels to generate to reach the target
+     */
+    [[nodiscard]] int64_t get_update_cost() const;
+
+    /**
+     * \brief Make the target parameters current (see update_target())
+     * \param chunk_index index of this chunk in the batch (see get_chunk_data())
+     * \param update_rects receives the areas of the heightmap to regenerate : the whole map, or only the rows / columns exposed since the last update.
+     */
+    void update_chunk_data(int32_t chunk_index, std::vector<LandscapeUpdateRect>& update_rects);
+
+    [[nodiscard]] bool is_outdated() const { return target_outdated; }
+
+    /**
+     * \brief The ring moved further than its maps since they were generated (eg. after a teleport). It isn't drawn until they are rebuilt,
+     * the coarser ring covers its area instead.
+     */
+    [[nodiscard]] bool is_displaced() const { return target_outdated && displaced; }
+
+    [[nodiscard]] const LandscapeChunkData& get_chunk_data() const { return last_chunk_data; }
+
+    /**
+     * \brief Consume finished height readbacks and enqueue a new one if the maps were regenerated.
+     */
+    void update_readback();
+
+private:
+    LandscapeChunkData last_chunk_data;   // Parameters of the current maps
+    LandscapeChunkData target_chunk_data; // Parameters for the current camera position
+    Eigen::Vector2i    grid_origin          = Eigen::Vector2i::Zero(); // chunk_position in cells
+    Eigen::Vector2i    last_grid_origin     = Eigen::Vector2i::Zero();
+    bool               target_outdated      = false;
+    bool               full_update_required = true;
+    bool               displaced            = false;
+    bool               has_maps             = false;
+
+    // Transforms used to generate the current maps
+    Eigen::Affine3d    generated_transform_cs = Eigen::Affine3d::Identity();
+    Eigen::Quaterniond generated_rotation_ps  = Eigen::Quaterniond::Identity();
+
+    /**
+     * \brief Bounding sphere of one PlanetGrid::Tile in mesh space (centered on the planet), including the terrain displacement.
+     */
+    struct TileBounds {
+        Eigen::Vector3d center;
+        double          radius;
+    };
+
+    /**
+     * \brief World space rotation of the mesh the current maps were generated for
+     */
+    [[nodiscard]] Eigen::Quaterniond get_generated_rotation_ws() const;
+
+    void set_geomorphing_data(LandscapeDrawData& draw_data) const;
+    void update_tile_bounds(uint32_t tiles_lod);
+    void collect_visible_tiles(Camera& camera, std::vector<Mesh::DrawElementsIndirectCommand>& commands, uint32_t tiles_lod);
+
+    std::vector<TileBounds> tile_bounds;
+    uint32_t                tile_bounds_lod       = 0; // Tiles the bounds were computed for (see PlanetGrid::get_tiles())
+    Eigen::Matrix4d         tile_bounds_transform = Eigen::Matrix4d::Zero();
+    Eigen::Quaterniond      tile_bounds_rotation  = Eigen::Quaterniond::Identity();
+
+    std::shared_ptr<TextureReadback>                    height_readback;
+    std::deque<std::pair<uint64_t, LandscapeChunkData>> pending_readbacks;
+    bool                                                readback_required = false;
+    HeightTile                                          height_tile;
 
     Planet&                      planet;
     Eigen::Vector3d              chunk_position;
@@ -44,7 +208,6 @@ private:
     std::shared_ptr<PlanetChunk> child;
     bool                         force_rebuild = true;
 
-    Eigen::Affine3d            mesh_transform_cs;
-    std::shared_ptr<Texture2D> chunk_height_map;
-    std::shared_ptr<Texture2D> chunk_normal_map;
+    Eigen::Affine3d mesh_transform_cs;
+    Eigen::Vector2d camera_position_2d = Eigen::Vector2d::Zero(); // Camera position on the mesh grid (in meters)
 };
@@ -0,0 +1,191 @@
+#include <GL/gl3w.h>
+
+#include "planet_grid.h"
+
+#include "graphics/mesh.h"
+#include "graphics/texture_image.h"
+#include "utils/gl_tools.h"
+#include "utils/profiler.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+static std::unordered_map<int32_t, std::shared_ptr<PlanetGrid>> grid_registry;
+
+std::shared_ptr<PlanetGrid> PlanetGrid::get(int32_t cell_count) {
+    const auto& grid = grid_registry.find(cell_count);
+    if (grid != grid_registry.end())
+        return grid->second;
+
+    return grid_registry[cell_count] = std::shared_ptr<PlanetGrid>(new PlanetGrid(cell_count));
+}
+
+PlanetGrid::PlanetGrid(int32_t in_cell_count) : cell_count(in_cell_count) {
+    rebuild_mesh();
+}
+
+static void generate_rectangle_area(std::vector<uint32_t>& indices, std::vector<Eigen::Vector3f>& positions, std::vector<PlanetGrid::Tile>& tiles,
+                                    int32_t                x_min, int32_t                         x_max,
+                                    int32_t                z_min, int32_t                         z_max,
+                                    int32_t                cell_min, int32_t                      cell_max, int32_t tile_size) {
+    // Requirement for Y val
+    const auto distance_max = static_cast<float>(cell_max);
+    auto       min_global   = static_cast<float>(cell_min);
+
+    // Handle LOD 0 case
+    if (abs(min_global - distance_max) < 0.0001)
+        min_global = 0;
+
+    const auto current_index_offset = static_cast<uint32_t>(positions.size());
+    for (int32_t z = z_min; z <= z_max; ++z)
+        for (int32_t x = x_min; x <= x_max; ++x) {
+            // The Y val is used to store the progression from previous LOD to the next one
+            const float linf_distance = static_cast<float>(std::max(std::abs(x), std::abs(z))); // Tchebychev distance
+            const float y_val_weight  = (linf_distance - min_global) / (distance_max - min_global);
+            const bool  x_aligned     = std::abs(x) > std::abs(z);
+            const int   mask          = std::abs(x) % 2 == 0 && !x_aligned || std::abs(z) % 2 == 0 && x_aligned;
+            positions.emplace_back(Eigen::Vector3f(static_cast<float>(x), mask * y_val_weight, static_cast<float>(z)));
+        }
+
+    // Indices are grouped by tiles of tile_size * tile_size cells to allow culling them separately
+    const uint32_t x_width = std::abs(x_max - x_min);
+    const uint32_t z_width = std::abs(z_max - z_min);
+    for (uint32_t tile_z = 0; tile_z < z_width; tile_z += tile_size)
+        for (uint32_t tile_x = 0; tile_x < x_width; tile_x += tile_size) {
+            const uint32_t tile_x_max = std::min(tile_x + tile_size, x_width);
+            const uint32_t tile_z_max = std::min(tile_z + tile_size, z_width);
+
+            PlanetGrid::Tile tile{.first_index = static_cast<uint32_t>(indices.size()),
+                                  .grid_min = Eigen::Vector2i(x_min + tile_x, z_min + tile_z),
+                                  .grid_max = Eigen::Vector2i(x_min + tile_x_max, z_min + tile_z_max)};
+
+            for (uint32_t z = tile_z; z < tile_z_max; ++z)
+                for (uint32_t x = tile_x; x < tile_x_max; ++x) {
+                    uint32_t base_index = x + z * (x_width + 1) + current_index_offset;
+                    if (positions[base_index].x() * positions[base_index].z() > 0) {
+                        indices.emplace_back(base_index);
+                        indices.emplace_back(base_index + x_width + 2);
+                        indices.emplace_back(base_index + x_width + 1);
+                        indices.emplace_back(base_index);
+                        indices.emplace_back(base_index + 1);
+                        indices.emplace_back(base_index + x_width + 2);
+                    } else {
+                        indices.emplace_back(base_index);
+                        indices.emplace_back(base_index + 1);
+                        indices.emplace_back(base_index + x_width + 1);
+                        indices.emplace_back(base_index + 1);
+                        indices.emplace_back(base_index + x_width + 2);
+                        indices.emplace_back(base_index + x_width + 1);
+                    }
+                }
+
+            tile.index_count = static_cast<uint32_t>(indices.size()) - tile.first_index;
+            if (tile.index_count > 0)
+                tiles.emplace_back(tile);
+        }
+}
+
+
+void PlanetGrid::rebuild_mesh() {
+    GL_CHECK_ERROR();
+    STAT_ACTION("Generate planet grid mesh : [{} cells]", cell_count);
+
+    // Cell count of one tile side. Rings are split in about 8 * 8 tiles.
+    const int32_t tile_size = std::max(2, cell_count / 2);
+
+    std::vector<uint32_t>        indices;
+    std::vector<Eigen::Vector3f> positions;
+    root_tiles.clear();
+    child_tiles.clear();
+
+    // Root mesh
+    generate_rectangle_area(indices, positions, root_tiles,
+                            -cell_count * 2 - 1,
+                            cell_count * 2 + 1,
+                            -cell_count * 2 - 1,
+                            cell_count * 2 + 1,
+                            0, cell_count * 2, tile_size);
+
+    // Child mesh : TOP side (larger)
+    generate_rectangle_area(indices, positions, child_tiles,
+                            cell_count,
+                            cell_count * 2 + 1,
+                            -cell_count - 1,
+                            cell_count * 2 + 1,
+                            cell_count, cell_count * 2 + 1, tile_size);
+
+    // RIGHT side (larger)
+    generate_rectangle_area(indices, positions, child_tiles,
+                            -cell_count * 2 - 1,
+                            cell_count,
+                            cell_count,
+                            cell_count * 2 + 1,
+                            cell_count, cell_count * 2 + 1, tile_size);
+
+    // BOTTOM side
+    generate_rectangle_area(indices, positions, child_tiles,
+                            -cell_count * 2 - 1,
+                            -cell_count - 1,
+                            -cell_count * 2 - 1,
+                            cell_count,
+                            cell_count + 1, cell_count * 2 + 1, tile_size);
+
+    // LEFT side
+    generate_rectangle_area(indices, positions, child_tiles,
+                            -cell_count - 1,
+                            cell_count * 2 + 1,
+                            -cell_count * 2 - 1,
+                            -cell_count - 1, cell_count + 1, cell_count * 2 + 1, tile_size);
+
+    mesh = Mesh::create("planet grid mesh");
+    mesh->set_positions(positions, 0, true);
+    mesh->set_indices(indices);
+    GL_CHECK_ERROR();
+}
+
+void PlanetGrid::register_planet(Planet* planet, uint32_t num_layers) {
+    const auto existing = std::ranges::find(planet_layers, planet, &PlanetLayers::planet);
+    if (existing != planet_layers.end()) {
+        if (existing->count == num_layers && height_maps)
+            return;
+        existing->count = num_layers;
+    }
+    else
+        planet_layers.emplace_back(PlanetLayers{.planet = planet, .base = 0, .count = num_layers});
+    rebuild_maps();
+}
+
+void PlanetGrid::unregister_planet(const Planet* planet) {
+    const auto existing = std::ranges::find(planet_layers, planet, &PlanetLayers::planet);
+    if (existing == planet_layers.end())
+        return;
+    planet_layers.erase(existing);
+    rebuild_maps();
+}
+
+uint32_t PlanetGrid::get_layer_base(const Planet* planet) const {
+    const auto existing = std::ranges::find(planet_layers, planet, &PlanetLayers::planet);
+    return existing != planet_layers.end() ? existing->base : 0;
+}
+
+void PlanetGrid::rebuild_maps() {
+    STAT_ACTION("Allocate planet maps : [{} cells]", cell_count);
+    uint32_t total_layers = 0;
+    planets.clear();
+    for (auto& layers : planet_layers) {
+        layers.base = total_layers;
+        total_layers += layers.count;
+        planets.emplace_back(layers.planet);
+    }
+
+    // Layers are packed : any allocation change moves the maps of other planets.
+    const uint32_t map_size = cell_count * 4 + 5;
+    height_maps             = Texture2DArray::create("planet heightmaps",
+                                                     {.wrapping = TextureWrapping::ClampToEdge, .filtering_mag = TextureMagFilter::Nearest, .filtering_min = TextureMinFilter::Nearest});
+    height_maps->set_data(map_size, map_size, std::max(total_layers, 1u), ImageFormat::RG_F32);
+    normal_maps = Texture2DArray::create("planet normal maps",
+                                         {.wrapping = TextureWrapping::ClampToEdge, .filtering_mag = TextureMagFilter::Nearest, .filtering_min = TextureMinFilter::Nearest});
+    normal_maps->set_data(map_size, map_size, std::max(total_layers, 1u), ImageFormat::RG_F16);
+    map_generation++;
+    GL_CHECK_ERROR();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Eigen/Dense>
+#include <memory>
+#include <vector>
+
+class Mesh;
+class Planet;
+class Texture2DArray;
+
+/**
+ * \brief LOD ring meshes and map textures shared by every planet with the same cell count.
+ * All planets write their heightmaps in the same texture arrays (one range of layers per planet) so that every LOD of every planet can be drawn with a single
+ * indirect draw call.
+ */
+class PlanetGrid final {
+public:
+    static std::shared_ptr<PlanetGrid> get(int32_t cell_count);
+
+    /**
+     * \brief Part of a LOD ring mesh that can be culled independently. (grid space bounds are inclusive vertex coordinates)
+     */
+    struct Tile {
+        uint32_t        first_index = 0;
+        uint32_t        index_count = 0;
+        Eigen::Vector2i grid_min;
+        Eigen::Vector2i grid_max;
+    };
+
+    /**
+     * \brief Reserve num_layers map layers for this planet (or resize its current range).
+     * Changing the layer allocation recreates the map textures : registered planets must regenerate their maps (see get_map_generation())
+     */
+    void register_planet(Planet* planet, uint32_t num_layers);
+    void unregister_planet(const Planet* planet);
+
+    /**
+     * \brief First map layer of this planet. LOD n is stored in layer get_layer_base() + n
+     */
+    [[nodiscard]] uint32_t get_layer_base(const Planet* planet) const;
+
+    /**
+     * \brief Incremented each time the map textures are recreated.
+     */
+    [[nodiscard]] uint64_t get_map_generation() const { return map_generation; }
+
+    /**
+     * \brief Registered planets, in registration order.
+     */
+    [[nodiscard]] const std::vector<Planet*>& get_planets() const { return planets; }
+
+    /**
+     * \brief Root (LOD 0) and child rings are stored in the same mesh. Tile indices are absolute.
+     */
+    [[nodiscard]] const std::shared_ptr<Mesh>& get_mesh() const { return mesh; }
+    [[nodiscard]] const std::vector<Tile>&     get_tiles(uint32_t lod) const { return lod == 0 ? root_tiles : child_tiles; }
+
+    [[nodiscard]] const std::shared_ptr<Texture2DArray>& get_height_maps() const { return height_maps; }
+    [[nodiscard]] const std::shared_ptr<Texture2DArray>& get_normal_maps() const { return normal_maps; }
+
+    const int32_t cell_count;
+
+private:
+    PlanetGrid(int32_t cell_count);
+
+    void rebuild_mesh();
+    void rebuild_maps();
+
+    struct PlanetLayers {
+        Planet*  planet;
+        uint32_t base;
+        uint32_t count;
+    };
+
+    std::shared_ptr<Mesh>           mesh;
+    std::vector<Tile>               root_tiles;
+    std::vector<Tile>               child_tiles;
+    std::vector<PlanetLayers>       planet_layers;
+    std::vector<Planet*>            planets;
+    std::shared_ptr<Texture2DArray> height_maps    = nullptr;
+    std::shared_ptr<Texture2DArray> normal_maps    = nullptr;
+    uint64_t                        map_generation = 0;
+};
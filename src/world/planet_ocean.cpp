@@ -2,6 +2,7 @@
 
 #include "planet.h"
 #include "graphics/camera.h"
+#include "graphics/gl_state.h"
 #include "graphics/material.h"
 #include "graphics/mesh.h"
 #include "graphics/primitives.h"
@@ -16,6 +17,8 @@ PlanetOcean::PlanetOcean(const std::shared_ptr<Planet>& owning_planet)
     draw_group = DrawGroup::from<DrawGroup_Translucency>();
 
     ocean_material = Material::create("Ocean Shader", "resources/shaders/water_shader.vs", "resources/shaders/water_shader.fs");
+    z_near_uniform = ocean_material->uniform<float>("z_near");
+    model_uniform  = ocean_material->uniform<Eigen::Affine3d>("model");
     if (!ocean_mesh) {
         ocean_mesh = primitives::grid_plane(1024, 1024);
     }
@@ -26,14 +29,14 @@ void PlanetOcean::render(Camera& camera, const DrawGroup& draw_group, const std:
     SceneComponent::render(camera, draw_group, render_pass);
 
     if (GameSettings::get().wireframe)
-        glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+        GlState::get().set_polygon_mode(GL_POINT);
 
     ocean_material->bind();
     render_pass->bind_dependencies_to_material(ocean_material);
-    ocean_material->set_float("z_near", static_cast<float>(camera.z_near()));
+    z_near_uniform.set(static_cast<float>(camera.z_near()));
     auto transform = get_world_transform();
     transform.translate(-camera.get_world_position());
-    ocean_material->set_model_transform(transform);
+    model_uniform.set(transform);
     grid_mesh->draw();
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    GlState::get().set_polygon_mode(GL_FILL);
 }
@@ -1,8 +1,8 @@
 #pragma once
 #include "scene_component.h"
+#include "graphics/material.h"
 
 class Planet;
-class Material;
 class Mesh;
 
 class PlanetOcean : public SceneComponent {
@@ -13,4 +13,7 @@ protected:
 private:
     std::shared_ptr<Mesh>     grid_mesh;
     std::shared_ptr<Material> ocean_material;
+
+    UniformHandle<float>           z_near_uniform;
+    UniformHandle<Eigen::Affine3d> model_uniform;
 };
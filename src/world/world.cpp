@@ -5,6 +5,8 @@
 #include <thread>
 #include "graphics/camera.h"
 #include "graphics/draw_group.h"
+#include "graphics/render_pass.h"
+#include "utils/frame_stats.h"
 #include "utils/game_settings.h"
 #include "utils/profiler.h"
 
@@ -15,7 +17,16 @@ World::World()
 void World::tick_world() {
     STAT_FRAME("World tick");
 
-    {
+    // The statistics always measure the real frame time, even when the simulation uses a fixed step.
+    // The first tick has no previous frame : its duration would include the whole startup.
+    const bool first_tick = last_time < 0;
+    double     frame_seconds;
+    if (GameSettings::get().fixed_delta_seconds > 0) {
+        const double now = glfwGetTime();
+        frame_seconds    = std::min(now - last_time, 1.0);
+        delta_seconds    = GameSettings::get().fixed_delta_seconds;
+        last_time        = now;
+    } else {
         const double required_delta_s = 1.0 / GameSettings::get().max_fps;
         STAT_FRAME("Framerate limiter");
         do {
@@ -25,8 +36,11 @@ void World::tick_world() {
                     std::chrono::microseconds(
                         static_cast<size_t>(std::max(0.0, required_delta_s - delta_seconds) * 1000000)));
         } while (GameSettings::get().max_fps > 1 && delta_seconds < required_delta_s);
-        last_time = glfwGetTime();
+        last_time     = glfwGetTime();
+        frame_seconds = delta_seconds;
     }
+    if (!first_tick)
+        FrameStats::get().add_sample("Frame time", frame_seconds);
 
     {
         STAT_FRAME("Pre-Physic");
@@ -44,10 +58,6 @@ void World::tick_world() {
 }
 
 void World::render_world(const DrawGroup& draw_group, const std::shared_ptr<Camera>& render_camera, const std::shared_ptr<RenderPass>& render_pass) const {
-    std::string names;
-    for (const auto& name : draw_group.group_names())
-        names += name + std::string(" ");
-
-    STAT_FRAME("World render : " + names);
+    STAT_FRAME("World render : {}", render_pass->name);
     root_component->render_internal(*render_camera, draw_group, render_pass);
 }